@@ -17,6 +17,7 @@
  *
  */
 
+#include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
@@ -51,6 +52,26 @@ NS_LOG_COMPONENT_DEFINE ("LeafSpinePpbp");
 
 bool verbose = false;
 
+// parameters of the links, can be changed from the command line
+std::string dataRate = DATA_RATE;
+std::string dataRateServer = DATA_RATE_SERVER;
+double eeeTimeout = 800;
+double eeeByteLimit = 24000;
+double eeeByteLimitServer = 15000;
+double errorRate = 0;
+
+// partition of each node, by node id, empty for a sequential run
+std::vector<uint32_t> systemids;
+
+uint32_t systemid(uint32_t node) {
+   return systemids.empty () ? 0 : systemids[node];
+}
+
+bool islocal(Ptr<Node> node) {
+   return !CoalescingPartitionInterface::IsEnabled ()
+      || node->GetSystemId () == CoalescingPartitionInterface::GetPartition ();
+}
+
 
 void TxTrace(std::string context, Ptr<const Packet> packet)
 {
@@ -105,8 +126,15 @@ void addudpclient(int server1, int server2, NodeContainer &servers, int socketPo
 
    
   ApplicationContainer apps = ppbp.Install (servers.Get (server2));
-  apps.Start (Seconds (FLOWS_START));
-  apps.Stop (Seconds (FLOWS_STOP));
+  if (islocal (servers.Get (server2))) {
+     apps.Start (Seconds (FLOWS_START));
+     apps.Stop (Seconds (FLOWS_STOP));
+  } else {
+     // created anyway, so that the random streams are assigned as in a
+     // sequential run, but started by the partition of its node
+     apps.Start (Time::Max ());
+     apps.Stop (Time::Max ());
+  }
 
 }
 
@@ -133,14 +161,25 @@ char *getnextnetwork() {
 void connect(NodeContainer *pplink, unsigned int *address1, unsigned int *address2, unsigned int *interface1, unsigned int *interface2) {
 
   PointToPointCoalescingHelper pointToPointCoalescing;
-  pointToPointCoalescing.SetDeviceAttribute ("DataRate", StringValue (DATA_RATE));
+  pointToPointCoalescing.SetDeviceAttribute ("DataRate", StringValue (dataRate));
   pointToPointCoalescing.SetChannelAttribute ("Delay", StringValue ("30us"));
+  pointToPointCoalescing.SetDeviceAttribute ("BurstTransmit", BooleanValue (true));
+  pointToPointCoalescing.SetDeviceType ("ns3::PointToPointCoalescingLeanNetDevice");
 
    
 
 	NetDeviceContainer p2pDevices;
 	p2pDevices = pointToPointCoalescing.Install (*pplink);
 
+	if (errorRate > 0) {
+		for (unsigned int i = 0; i < p2pDevices.GetN(); i++) {
+			Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+			em->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+			em->SetRate (errorRate);
+			p2pDevices.Get(i)->SetAttribute ("ReceiveErrorModel", PointerValue (em));
+		}
+	}
+
 	Ipv4AddressHelper address;
 	char *adr = getnextnetwork();
 	address.SetBase (adr, "255.255.255.0");
@@ -163,8 +202,8 @@ void connect(NodeContainer *pplink, unsigned int *address1, unsigned int *addres
 	*interface2 = ipv4->GetInterfaceForAddress(addr2);
 
    for (int ifc = 0; ifc < 2; ifc++) {
-	   p2pDevices.Get(ifc)->SetAttribute ("EeeCoalescingTimeout", DoubleValue (800)); 
-	   p2pDevices.Get(ifc)->SetAttribute ("EeeByteLimit", DoubleValue (24000)); 
+	   p2pDevices.Get(ifc)->SetAttribute ("EeeCoalescingTimeout", DoubleValue (eeeTimeout)); 
+	   p2pDevices.Get(ifc)->SetAttribute ("EeeByteLimit", DoubleValue (eeeByteLimit)); 
 	   p2pDevices.Get(ifc)->SetAttribute ("EeeSleepTime", DoubleValue (2.88)); 
 	   p2pDevices.Get(ifc)->SetAttribute ("EeeWakeUpTime", DoubleValue (4.48)); 
    }
@@ -174,7 +213,8 @@ void connect(NodeContainer *pplink, unsigned int *address1, unsigned int *addres
 
 void leafspine(int switchcount) {
 
-	switches.Create(switchcount);
+	for (int i = 0; i < switchcount; i++)
+		switches.Create(1, systemid(NodeList::GetNNodes()));
 	network.Add(switches);
 
 
@@ -218,13 +258,15 @@ void addservers(int swservers) {
 			NodeContainer p2pNodes;
 
 			p2pNodes.Add (switches.Get(i));
-			p2pNodes.Create (1);			
+			p2pNodes.Create (1, systemid (NodeList::GetNNodes ()));			
 
 			internetNodes.Install(p2pNodes.Get(1));
 			
 			PointToPointCoalescingHelper pointToPoint;
-			pointToPoint.SetDeviceAttribute ("DataRate", StringValue (DATA_RATE_SERVER));
+			pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRateServer));
 			pointToPoint.SetChannelAttribute ("Delay", StringValue ("30us"));
+			pointToPoint.SetDeviceAttribute ("BurstTransmit", BooleanValue (true));
+			pointToPoint.SetDeviceType ("ns3::PointToPointCoalescingLeanNetDevice");
 
 			NetDeviceContainer p2pDevices;
 
@@ -247,8 +289,8 @@ void addservers(int swservers) {
          switchserverdevices.Add(p2pDevices.Get(0));
 
          for (int ifc = 0; ifc < 2; ifc++) {
-            p2pDevices.Get(ifc)->SetAttribute ("EeeCoalescingTimeout", DoubleValue (800)); 
-            p2pDevices.Get(ifc)->SetAttribute ("EeeByteLimit", DoubleValue (15000)); 
+            p2pDevices.Get(ifc)->SetAttribute ("EeeCoalescingTimeout", DoubleValue (eeeTimeout)); 
+            p2pDevices.Get(ifc)->SetAttribute ("EeeByteLimit", DoubleValue (eeeByteLimitServer)); 
             p2pDevices.Get(ifc)->SetAttribute ("EeeSleepTime", DoubleValue (5)); 
             p2pDevices.Get(ifc)->SetAttribute ("EeeWakeUpTime", DoubleValue (8)); 
          }
@@ -262,20 +304,100 @@ void addservers(int swservers) {
 
 }
 
+// values of a comma separated list, or the default if the list is empty
+std::vector<double> parselist(std::string list, double dflt) {
+   std::vector<double> values;
+   std::stringstream ss (list);
+   std::string value;
+   while (std::getline (ss, value, ','))
+      values.push_back (std::atof (value.c_str ()));
+   if (values.empty ())
+      values.push_back (dflt);
+   return values;
+}
+
+// shadows of every port for each combination of the given timeouts and byte limits
+void addshadows(NetDeviceContainer &all, std::string timeouts, std::string byteLimits) {
+   for (unsigned int i = 0; i < all.GetN(); i++) {
+      Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (all.Get(i));
+      CoalescingModel::Parameters p = dev->GetShadowParameters ();
+      std::vector<double> t = parselist (timeouts, p.timeout);
+      std::vector<double> b = parselist (byteLimits, p.limits.byteLimit);
+      for (unsigned int a = 0; a < t.size(); a++)
+         for (unsigned int c = 0; c < b.size(); c++) {
+            p.timeout = t[a];
+            p.limits.byteLimit = b[c];
+            dev->AddShadow (p);
+         }
+   }
+}
 
 
 int
 main (int argc, char *argv[])
 {
 
+  std::string output = "data.bin";
+
   CommandLine cmd;
+  cmd.AddValue ("rate", "Data rate of the links between switches", dataRate);
+  cmd.AddValue ("serverRate", "Data rate of the links to the servers", dataRateServer);
+  cmd.AddValue ("timeout", "EEE coalescing timeout in microseconds", eeeTimeout);
+  cmd.AddValue ("byteLimit", "EEE coalescing byte limit of the links between switches", eeeByteLimit);
+  cmd.AddValue ("serverByteLimit", "EEE coalescing byte limit of the links to the servers", eeeByteLimitServer);
+  cmd.AddValue ("output", "File the measurements are written to", output);
+  std::string branchTimeouts;
+  cmd.AddValue ("branchTimeouts", "Comma separated coalescing timeouts in microseconds, "
+                "each continues the simulation from the start of the flows in its own process", branchTimeouts);
+  double ciTarget = 0;
+  cmd.AddValue ("ciTarget", "Stop when the relative half-width of the 95% confidence intervals "
+                "of E[Toff] and the energy ratio of every port is below this value, 0 to disable", ciTarget);
+  double stopTime = 10.0;
+  cmd.AddValue ("stopTime", "Simulation time at which the simulation ends at the latest, in seconds", stopTime);
+  cmd.AddValue ("errorRate", "Packet error rate of the links between switches", errorRate);
+  std::string arrivalTrace;
+  cmd.AddValue ("arrivalTrace", "File the packet arrivals of all coalescing ports are written to, "
+                "for coalescing-replay", arrivalTrace);
+  std::string shadowTimeouts;
+  cmd.AddValue ("shadowTimeouts", "Comma separated coalescing timeouts in microseconds which shadows "
+                "of every port evaluate on the arrivals of this run", shadowTimeouts);
+  std::string shadowByteLimits;
+  cmd.AddValue ("shadowByteLimits", "Comma separated byte limits which shadows of every port evaluate, "
+                "combined with each shadow timeout", shadowByteLimits);
+  std::string shadowOutput = "shadows.txt";
+  cmd.AddValue ("shadowOutput", "File the measurements of the shadows are written to", shadowOutput);
+  bool timerWheel = false;
+  cmd.AddValue ("timerWheel", "Keep the EEE timers of the devices of each node in one timer wheel "
+                "instead of the scheduler of the simulator", timerWheel);
+  uint32_t partitions = 1;
+  cmd.AddValue ("partitions", "Number of processes the nodes are split into, "
+                "which run in parallel on this machine", partitions);
   cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (partitions > 1 && !branchTimeouts.empty (), "Branches cannot be combined with partitions");
   
   Time::SetResolution (Time::NS);
+  if (!arrivalTrace.empty ())
+     Config::SetDefault ("ns3::PointToPointCoalescingNetDeviceBase::RecordArrivals", BooleanValue (true));
   Config::SetDefault("ns3::Ipv4GlobalRouting::RandomEcmpRouting",BooleanValue(true));
 
   int switchcount = 8;
   int serversperswitch = 16;
+
+  // the nodes are created as the switches, then the servers of each leaf
+  if (partitions > 1) {
+     CoalescingPartitionHelper partitioner;
+     for (int i = 0; i < switchcount/2; i++)
+        for (int j = switchcount/2; j < switchcount; j++)
+           partitioner.AddLink (i, j, DataRate (dataRate).GetBitRate (), MicroSeconds (30));
+     for (int i = 0; i < switchcount/2; i++)
+        for (int j = 0; j < serversperswitch; j++)
+           partitioner.AddLink (i, switchcount + i*serversperswitch + j, DataRate (dataRateServer).GetBitRate (), MicroSeconds (30));
+     systemids = partitioner.Partition (partitions);
+     std::cout << "partitions " << partitions << " lookahead " << partitioner.GetLookahead ().GetMicroSeconds () << "us" << std::endl;
+     CoalescingPartitionInterface::Enable (partitions);
+  }
+
   leafspine(switchcount);
   addservers(serversperswitch);
 
@@ -335,34 +457,119 @@ main (int argc, char *argv[])
 
 
 
-  Simulator::Stop (Seconds (10.0));
+  //
+  // Runs of different EEE configurations with the same seed use common
+  // random numbers without any option: the PPBP sources, the error models
+  // and ECMP routing get their streams automatically in creation order,
+  // and the EEE attributes do not change what is created or in which order.
+  //
+
+  NetDeviceContainer all (switchdevices, serverdevices);
+  all.Add (switchserverdevices);
+  if (timerWheel) {
+     PointToPointCoalescingHelper pointToPointCoalescing;
+     pointToPointCoalescing.InstallTimerWheels (all);
+  }
+
+  bool shadows = !shadowTimeouts.empty () || !shadowByteLimits.empty ();
+  if (shadows)
+     addshadows (all, shadowTimeouts, shadowByteLimits);
+
+  Simulator::Stop (Seconds (stopTime));
+
+  CoalescingConvergenceMonitor monitor;
+  if (ciTarget > 0) {
+     monitor.Add (devices);
+     monitor.SetTarget (ciTarget);
+     monitor.Start (MilliSeconds (10));
+  }
+
+  // setup and routing are shared by all branches
+  CoalescingBranchHelper branches;
+  if (!branchTimeouts.empty ()) {
+     std::stringstream ss (branchTimeouts);
+     std::string timeout;
+     while (std::getline (ss, timeout, ',')) {
+        std::string path = output;
+        std::string::size_type dot = path.rfind (".bin");
+        path.insert (dot == std::string::npos ? path.size () : dot, "-timeout" + timeout);
+        uint32_t b = branches.AddBranch (path);
+        branches.SetBranchAttribute (b, devices, "EeeCoalescingTimeout", DoubleValue (std::atof (timeout.c_str ())));
+     }
+     branches.BranchAt (Seconds (FLOWS_START));
+  }
 
 
   Simulator::Run ();
+
+  if (ciTarget > 0)
+     std::cout << "converged " << monitor.IsConverged () << " ports " << monitor.GetNConverged () << "/" << monitor.GetN ()
+               << " at " << Simulator::Now ().GetSeconds () << std::endl;
+
+  if (!branchTimeouts.empty ()) {
+     if (branches.IsParent ()) {
+        Simulator::Destroy ();
+        std::cout << "branches failed " << branches.GetNFailed () << std::endl;
+        return branches.GetNFailed () == 0 ? 0 : 1;
+     }
+     output = branches.GetOutputPath ();
+     shadowOutput = output + "-" + shadowOutput;
+  }
  
   
-  // Write measurements data
+  // Write measurements data of all devices to one file
+  Ptr<CoalescingMeasurementSink> sink = CreateObject<CoalescingMeasurementSink> ();
+  sink->SetAttribute ("OutputPath", StringValue (output));
   for (unsigned int i = 0; i < switchdevices.GetN(); i++) {
-     Ptr<PointToPointCoalescingNetDevice> dev = DynamicCast<PointToPointCoalescingNetDevice> (switchdevices.Get(i));
-     dev->WriteMeasurementsData (DATA_RATE);
-     
+     Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (switchdevices.Get(i));
+     dev->WriteMeasurementsData (sink);
   }
 
   for (unsigned int i = 0; i < serverdevices.GetN(); i++) {
-     Ptr<PointToPointCoalescingNetDevice> dev = DynamicCast<PointToPointCoalescingNetDevice> (serverdevices.Get(i));
-     dev->WriteMeasurementsData (DATA_RATE_SERVER);
-      
+     Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (serverdevices.Get(i));
+     dev->WriteMeasurementsData (sink);
   }
 
   for (unsigned int i = 0; i < switchserverdevices.GetN(); i++) {
-     Ptr<PointToPointCoalescingNetDevice> dev = DynamicCast<PointToPointCoalescingNetDevice> (switchserverdevices.Get(i));
-     dev->WriteMeasurementsData (DATA_RATE_SERVER);
-      
+     Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (switchserverdevices.Get(i));
+     dev->WriteMeasurementsData (sink);
+  }
+  sink->Close ();
+
+  // Write arrivals of all devices to one trace
+  if (!arrivalTrace.empty ()) {
+     Ptr<CoalescingArrivalTraceSink> traceSink = CreateObject<CoalescingArrivalTraceSink> ();
+     traceSink->SetAttribute ("OutputPath", StringValue (arrivalTrace));
+     for (unsigned int i = 0; i < all.GetN(); i++) {
+        Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (all.Get(i));
+        dev->WriteArrivalTrace (traceSink);
+     }
+     traceSink->Close ();
+  }
+
+  // Write what the shadow configurations would have measured on every port
+  // of this system
+  if (shadows) {
+     std::string path = CoalescingMeasurementSink::GetSystemPath (shadowOutput);
+     std::ofstream os (path.c_str ());
+     os << "# node port shadow policy timeout byteLimit packetLimit lpTimeNs lpIntervals eToff phi delay" << std::endl;
+     for (unsigned int i = 0; i < all.GetN(); i++) {
+        Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (all.Get(i));
+        dev->WriteShadowData (os);
+     }
   }
 
   Simulator::Destroy ();
 
   std::cout << "total packets " << packets << std::endl;
 
+  if (partitions > 1) {
+     CoalescingPartitionInterface::Disable ();
+     if (CoalescingPartitionInterface::GetPartition () == 0) {
+        std::cout << "partitions failed " << CoalescingPartitionInterface::GetNFailed () << std::endl;
+        return CoalescingPartitionInterface::GetNFailed () == 0 ? 0 : 1;
+     }
+  }
+
   return 0;
 }
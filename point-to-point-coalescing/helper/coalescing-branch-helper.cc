@@ -0,0 +1,194 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/net-device.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/coalescing-partition-interface.h"
+#include "coalescing-branch-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingBranchHelper");
+
+CoalescingBranchHelper::CoalescingBranchHelper ()
+  : m_maxParallel (1),
+    m_branch (NO_BRANCH),
+    m_running (0),
+    m_failed (0)
+{
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  if (n > 0)
+    {
+      m_maxParallel = static_cast<uint32_t> (n);
+    }
+}
+
+uint32_t
+CoalescingBranchHelper::AddBranch (std::string outputPath)
+{
+  Branch b;
+  b.outputPath = outputPath;
+  m_branches.push_back (b);
+  return m_branches.size () - 1;
+}
+
+void
+CoalescingBranchHelper::SetBranchAttribute (uint32_t branch, NetDeviceContainer devices,
+                                            std::string name, const AttributeValue &value)
+{
+  NS_ASSERT (branch < m_branches.size ());
+  Setting s;
+  s.devices = devices;
+  s.name = name;
+  s.value = value.Copy ();
+  m_branches[branch].settings.push_back (s);
+}
+
+void
+CoalescingBranchHelper::SetBranchConfig (uint32_t branch, std::string path, const AttributeValue &value)
+{
+  NS_ASSERT (branch < m_branches.size ());
+  Setting s;
+  s.path = path;
+  s.value = value.Copy ();
+  m_branches[branch].settings.push_back (s);
+}
+
+void
+CoalescingBranchHelper::SetMaxParallel (uint32_t n)
+{
+  NS_ASSERT (n > 0);
+  m_maxParallel = n;
+}
+
+void
+CoalescingBranchHelper::BranchAt (Time t)
+{
+  NS_ABORT_MSG_IF (MpiInterface::IsEnabled (), "Branching is not possible in distributed simulations");
+  NS_ABORT_MSG_IF (CoalescingPartitionInterface::IsEnabled (), "Branching is not possible in partitioned simulations");
+  Simulator::Schedule (t - Simulator::Now (), &CoalescingBranchHelper::Fork, this);
+}
+
+bool
+CoalescingBranchHelper::IsParent (void) const
+{
+  return m_branch == NO_BRANCH;
+}
+
+uint32_t
+CoalescingBranchHelper::GetBranch (void) const
+{
+  return m_branch;
+}
+
+std::string
+CoalescingBranchHelper::GetOutputPath (void) const
+{
+  NS_ASSERT_MSG (m_branch != NO_BRANCH, "The parent has no output");
+  return m_branches[m_branch].outputPath;
+}
+
+uint32_t
+CoalescingBranchHelper::GetNFailed (void) const
+{
+  return m_failed;
+}
+
+void
+CoalescingBranchHelper::Fork (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  //
+  // Buffered output would otherwise be written once by every child.
+  //
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  for (uint32_t i = 0; i < m_branches.size (); ++i)
+    {
+      if (m_running == m_maxParallel)
+        {
+          WaitOne ();
+        }
+
+      pid_t pid = fork ();
+      NS_ABORT_MSG_IF (pid < 0, "Cannot fork branch " << i);
+      if (pid == 0)
+        {
+          m_branch = i;
+          m_running = 0;
+          Apply ();
+          return;
+        }
+      NS_LOG_LOGIC ("Branch " << i << " runs in process " << pid);
+      m_running++;
+    }
+
+  while (m_running > 0)
+    {
+      WaitOne ();
+    }
+
+  Simulator::Stop ();
+}
+
+void
+CoalescingBranchHelper::Apply (void)
+{
+  NS_LOG_FUNCTION (this << m_branch);
+
+  const Branch &b = m_branches[m_branch];
+  for (std::vector<Setting>::const_iterator s = b.settings.begin (); s != b.settings.end (); ++s)
+    {
+      if (!s->path.empty ())
+        {
+          Config::Set (s->path, *s->value);
+          continue;
+        }
+      for (NetDeviceContainer::Iterator d = s->devices.Begin (); d != s->devices.End (); ++d)
+        {
+          (*d)->SetAttribute (s->name, *s->value);
+        }
+    }
+}
+
+void
+CoalescingBranchHelper::WaitOne (void)
+{
+  int status;
+  pid_t pid = wait (&status);
+  NS_ABORT_MSG_IF (pid < 0, "No branch to wait for");
+  m_running--;
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      NS_LOG_WARN ("Branch process " << pid << " failed");
+      m_failed++;
+    }
+}
+
+} // namespace ns3
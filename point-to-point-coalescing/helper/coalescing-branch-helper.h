@@ -0,0 +1,166 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_BRANCH_HELPER_H
+#define COALESCING_BRANCH_HELPER_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "ns3/attribute.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+/**
+ * \brief Continue one warmed-up simulation in several branches
+ *
+ * The simulation is set up and run once up to the branch time.  There
+ * the process forks one child per branch.  Children share the state of
+ * the simulation copy-on-write, apply the attributes of their branch and
+ * run to the end on their own.  The parent waits for its children and
+ * then stops its own simulation.
+ *
+ * \code
+ *   CoalescingBranchHelper branches;
+ *   for (uint32_t i = 0; i < timeouts.size (); i++) {
+ *      uint32_t b = branches.AddBranch ("data-" + names[i] + ".bin");
+ *      branches.SetBranchAttribute (b, devices, "EeeCoalescingTimeout", DoubleValue (timeouts[i]));
+ *   }
+ *   branches.BranchAt (Seconds (3.0));
+ *   Simulator::Run ();
+ *   if (branches.IsParent ())
+ *      return branches.GetNFailed () == 0 ? 0 : 1;
+ *   // write measurements to branches.GetOutputPath ()
+ * \endcode
+ *
+ * Random variables continue from the same state in all branches, so the
+ * branches see the same traffic unless their attributes change it.
+ *
+ * Forking needs a POSIX system and a single process simulation, so it
+ * cannot be combined with distributed simulation.
+ */
+class CoalescingBranchHelper
+{
+public:
+  /// Branch index of the parent process
+  static const uint32_t NO_BRANCH = 0xffffffff;
+
+  CoalescingBranchHelper ();
+
+  /**
+   * \brief Add a branch
+   *
+   * \param outputPath measurement file of the branch
+   * \return the index of the branch
+   */
+  uint32_t AddBranch (std::string outputPath);
+
+  /**
+   * \brief Set an attribute of some devices in a branch
+   *
+   * \param branch index of the branch
+   * \param devices devices whose attribute is set
+   * \param name name of the attribute
+   * \param value value of the attribute
+   */
+  void SetBranchAttribute (uint32_t branch, NetDeviceContainer devices,
+                           std::string name, const AttributeValue &value);
+
+  /**
+   * \brief Set attributes matching a configuration path in a branch
+   *
+   * \param branch index of the branch
+   * \param path configuration path, as used by Config::Set
+   * \param value value of the attributes
+   */
+  void SetBranchConfig (uint32_t branch, std::string path, const AttributeValue &value);
+
+  /**
+   * \brief Limit the number of branches running at the same time
+   *
+   * \param n number of branches, by default the number of processors
+   */
+  void SetMaxParallel (uint32_t n);
+
+  /**
+   * \brief Schedule the fork
+   *
+   * \param t simulation time at which the branches start
+   */
+  void BranchAt (Time t);
+
+  /**
+   * \return true in the parent process, which does not belong to any branch
+   */
+  bool IsParent (void) const;
+
+  /**
+   * \return the index of the branch of this process, NO_BRANCH in the parent
+   */
+  uint32_t GetBranch (void) const;
+
+  /**
+   * \return the measurement file of the branch of this process
+   */
+  std::string GetOutputPath (void) const;
+
+  /**
+   * \return the number of branches which did not exit successfully, valid
+   * in the parent after the simulation
+   */
+  uint32_t GetNFailed (void) const;
+
+private:
+  /// Attribute assignment of a branch
+  struct Setting
+  {
+    NetDeviceContainer devices;  //!< Devices, if path is empty
+    std::string path;            //!< Configuration path
+    std::string name;            //!< Attribute name, if path is empty
+    Ptr<AttributeValue> value;   //!< Value to set
+  };
+
+  /// A branch
+  struct Branch
+  {
+    std::string outputPath;          //!< Measurement file
+    std::vector<Setting> settings;   //!< Attributes of the branch
+  };
+
+  /// Forks the branches, executed at the branch time
+  void Fork (void);
+
+  /// Applies the attributes of the branch of this process
+  void Apply (void);
+
+  /// Waits for one child and counts its failure
+  void WaitOne (void);
+
+  std::vector<Branch> m_branches;  //!< Branches
+  uint32_t m_maxParallel;          //!< Maximum number of running children
+  uint32_t m_branch;               //!< Branch of this process
+  uint32_t m_running;              //!< Running children
+  uint32_t m_failed;               //!< Children which failed
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_BRANCH_HELPER_H */
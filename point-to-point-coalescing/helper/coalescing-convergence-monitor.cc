@@ -0,0 +1,146 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/point-to-point-coalescing-net-device.h"
+#include "ns3/coalescing-partition-interface.h"
+#include "coalescing-convergence-monitor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingConvergenceMonitor");
+
+CoalescingConvergenceMonitor::CoalescingConvergenceMonitor ()
+  : m_target (0.05),
+    m_z (1.96),
+    m_minBatches (10),
+    m_converged (false)
+{
+}
+
+void
+CoalescingConvergenceMonitor::Add (NetDeviceContainer devices)
+{
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (*i);
+      if (dev == 0)
+        {
+          continue;
+        }
+      // the ports of the other partitions are not simulated here
+      if (CoalescingPartitionInterface::IsEnabled ()
+          && dev->GetNode ()->GetSystemId () != CoalescingPartitionInterface::GetPartition ())
+        {
+          continue;
+        }
+      dev->EnableEstimators ();
+      m_devices.push_back (dev);
+    }
+}
+
+void
+CoalescingConvergenceMonitor::SetTarget (double target)
+{
+  m_target = target;
+}
+
+void
+CoalescingConvergenceMonitor::SetConfidence (double z)
+{
+  m_z = z;
+}
+
+void
+CoalescingConvergenceMonitor::SetMinBatches (uint32_t n)
+{
+  m_minBatches = n;
+}
+
+void
+CoalescingConvergenceMonitor::Start (Time interval)
+{
+  NS_ASSERT (interval.IsStrictlyPositive ());
+  m_interval = interval;
+  Simulator::Schedule (m_interval, &CoalescingConvergenceMonitor::Check, this);
+}
+
+uint32_t
+CoalescingConvergenceMonitor::GetN (void) const
+{
+  return m_devices.size ();
+}
+
+uint32_t
+CoalescingConvergenceMonitor::GetNConverged (void) const
+{
+  uint32_t n = 0;
+  for (std::size_t i = 0; i < m_devices.size (); ++i)
+    {
+      if (m_devices[i]->GetLowPowerEstimate ().IsConverged (m_target, m_z, m_minBatches)
+          && m_devices[i]->GetEnergyRatioEstimate ().IsConverged (m_target, m_z, m_minBatches))
+        {
+          n++;
+        }
+    }
+  return n;
+}
+
+bool
+CoalescingConvergenceMonitor::IsConverged (void) const
+{
+  return m_converged;
+}
+
+Time
+CoalescingConvergenceMonitor::GetStopTime (void) const
+{
+  return m_stopTime;
+}
+
+void
+CoalescingConvergenceMonitor::Check (void)
+{
+  uint32_t n = GetNConverged ();
+  NS_LOG_LOGIC (Simulator::Now () << ": " << n << " of " << m_devices.size () << " ports converged");
+
+  //
+  // With partitions, a partition leaving the run alone would block the
+  // others, so each one asks to stop and they stop together once all
+  // their ports have converged.  A partition without ports agrees at once.
+  //
+  bool partitioned = CoalescingPartitionInterface::IsEnabled ();
+  if (n == m_devices.size () && (n > 0 || partitioned))
+    {
+      NS_LOG_INFO (Simulator::Now () << ": all " << n << " ports converged, stopping");
+      m_converged = true;
+      m_stopTime = Simulator::Now ();
+      if (partitioned)
+        {
+          CoalescingPartitionInterface::Stop ();
+        }
+      else
+        {
+          Simulator::Stop ();
+        }
+      return;
+    }
+  Simulator::Schedule (m_interval, &CoalescingConvergenceMonitor::Check, this);
+}
+
+} // namespace ns3
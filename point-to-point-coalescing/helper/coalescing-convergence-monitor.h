@@ -0,0 +1,116 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_CONVERGENCE_MONITOR_H
+#define COALESCING_CONVERGENCE_MONITOR_H
+
+#include <vector>
+
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class PointToPointCoalescingNetDeviceBase;
+
+/**
+ * \brief Stop the simulation when the estimates of all ports are precise
+ *
+ * The coalescing devices added to the monitor estimate E[Toff] and their
+ * energy ratio by batch means within the run, see
+ * PointToPointCoalescingNetDeviceBase::EnableEstimators.  The monitor checks the
+ * devices added to it periodically and stops the simulation as soon as
+ * both estimates of every device have a confidence interval whose
+ * half-width is at most the target fraction of the mean.
+ *
+ * A port which carries no traffic never completes a low-power interval,
+ * so its estimates never converge.  Add only ports with traffic, and keep
+ * a Simulator::Stop at the longest acceptable time.
+ *
+ * With CoalescingPartitionInterface, each partition monitors the ports of
+ * its own nodes and the run stops when those of all partitions have
+ * converged, see CoalescingPartitionInterface::Stop.
+ */
+class CoalescingConvergenceMonitor
+{
+public:
+  CoalescingConvergenceMonitor ();
+
+  /**
+   * \brief Monitor the coalescing devices of a container
+   *
+   * Devices which are not coalescing devices are ignored.  The estimators
+   * of the others are started, so the devices should be added before the
+   * simulation starts.
+   *
+   * \param devices devices to monitor
+   */
+  void Add (NetDeviceContainer devices);
+
+  /**
+   * \param target relative half-width of the confidence intervals, 0.05
+   * by default
+   */
+  void SetTarget (double target);
+
+  /**
+   * \param z quantile of the normal distribution, 1.96 (95%) by default
+   */
+  void SetConfidence (double z);
+
+  /**
+   * \param n batches needed after the warm-up, 10 by default
+   */
+  void SetMinBatches (uint32_t n);
+
+  /**
+   * \brief Start checking the devices
+   *
+   * \param interval simulation time between two checks
+   */
+  void Start (Time interval);
+
+  /// \return the number of monitored devices
+  uint32_t GetN (void) const;
+
+  /// \return the number of devices whose estimates have converged
+  uint32_t GetNConverged (void) const;
+
+  /// \return true if the monitor stopped the simulation
+  bool IsConverged (void) const;
+
+  /// \return the time at which the monitor stopped the simulation, or
+  /// asked the partitions to stop
+  Time GetStopTime (void) const;
+
+private:
+  /// Checks the devices and stops the simulation if all have converged
+  void Check (void);
+
+  std::vector<Ptr<PointToPointCoalescingNetDeviceBase> > m_devices; //!< Monitored devices
+  double m_target;          //!< Relative half-width to reach
+  double m_z;               //!< Quantile of the confidence intervals
+  uint32_t m_minBatches;    //!< Batches needed after the warm-up
+  Time m_interval;          //!< Time between two checks
+  bool m_converged;         //!< The simulation has been stopped
+  Time m_stopTime;          //!< Time of the stop
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_CONVERGENCE_MONITOR_H */
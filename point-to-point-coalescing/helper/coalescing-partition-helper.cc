@@ -0,0 +1,662 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/channel.h"
+#include "ns3/data-rate.h"
+#include "ns3/point-to-point-coalescing-net-device.h"
+#include "coalescing-partition-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingPartitionHelper");
+
+namespace {
+
+// part of no vertex yet
+const uint32_t NONE = ~static_cast<uint32_t> (0);
+
+// coarsening stops at this many vertices per part
+const uint32_t COARSEST_PER_PART = 20;
+
+// number of refinement passes on each level
+const uint32_t REFINE_PASSES = 10;
+
+// vertices of each part tried for a swap with each other part
+const uint32_t SWAP_CANDIDATES = 8;
+
+// orders vertices by weight
+struct LighterVertex
+{
+  LighterVertex (const std::vector<double> &weight)
+    : m_weight (weight)
+  {
+  }
+  bool operator () (uint32_t a, uint32_t b) const
+  {
+    return m_weight[a] < m_weight[b];
+  }
+  const std::vector<double> &m_weight;
+};
+
+} // namespace
+
+CoalescingPartitionHelper::CoalescingPartitionHelper ()
+  : m_imbalance (0.05),
+    m_nParts (0)
+{
+}
+
+void
+CoalescingPartitionHelper::Resize (uint32_t node)
+{
+  if (node >= m_load.size ())
+    {
+      m_load.resize (node + 1, 0);
+      m_loadSet.resize (node + 1, false);
+    }
+}
+
+void
+CoalescingPartitionHelper::AddDevices (NetDeviceContainer devices)
+{
+  std::set<Ptr<Channel> > added;
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (*i);
+      if (dev == 0 || dev->GetChannel () == 0 || !added.insert (dev->GetChannel ()).second)
+        {
+          continue;
+        }
+      Ptr<Channel> channel = dev->GetChannel ();
+      NS_ABORT_MSG_IF (channel->GetNDevices () != 2, "A coalescing channel has two devices");
+
+      Ptr<NetDevice> other = channel->GetDevice (0) == dev ? channel->GetDevice (1) : channel->GetDevice (0);
+      DataRateValue rate;
+      dev->GetAttribute ("DataRate", rate);
+      TimeValue delay;
+      channel->GetAttribute ("Delay", delay);
+      AddLink (dev->GetNode ()->GetId (), other->GetNode ()->GetId (),
+               static_cast<double> (rate.Get ().GetBitRate ()), delay.Get ());
+    }
+}
+
+void
+CoalescingPartitionHelper::AddLink (uint32_t a, uint32_t b, double traffic, Time delay)
+{
+  NS_LOG_FUNCTION (this << a << b << traffic << delay);
+  NS_ABORT_MSG_IF (!delay.IsStrictlyPositive (), "Links between partitions need a delay");
+  Resize (std::max (a, b));
+  Link link;
+  link.a = a;
+  link.b = b;
+  link.traffic = traffic;
+  link.delay = delay;
+  m_links.push_back (link);
+}
+
+void
+CoalescingPartitionHelper::SetNodeLoad (uint32_t node, double load)
+{
+  Resize (node);
+  m_load[node] = load;
+  m_loadSet[node] = true;
+}
+
+void
+CoalescingPartitionHelper::SetImbalance (double imbalance)
+{
+  m_imbalance = imbalance;
+}
+
+CoalescingPartitionHelper::Graph
+CoalescingPartitionHelper::GetGraph (void) const
+{
+  Graph g;
+  g.weight = m_load;
+  g.adj.resize (m_load.size ());
+
+  Time minDelay = Time::Max ();
+  for (std::size_t i = 0; i < m_links.size (); ++i)
+    {
+      minDelay = std::min (minDelay, m_links[i].delay);
+    }
+
+  // parallel links are merged into one edge
+  std::vector<std::map<uint32_t, double> > edges (m_load.size ());
+  for (std::size_t i = 0; i < m_links.size (); ++i)
+    {
+      const Link &l = m_links[i];
+      if (!m_loadSet[l.a])
+        {
+          g.weight[l.a] += l.traffic;
+        }
+      if (!m_loadSet[l.b])
+        {
+          g.weight[l.b] += l.traffic;
+        }
+      if (l.a == l.b)
+        {
+          continue;
+        }
+      double cost = l.traffic * minDelay.GetSeconds () / l.delay.GetSeconds ();
+      edges[l.a][l.b] += cost;
+      edges[l.b][l.a] += cost;
+    }
+  for (std::size_t v = 0; v < edges.size (); ++v)
+    {
+      g.adj[v].assign (edges[v].begin (), edges[v].end ());
+    }
+  return g;
+}
+
+CoalescingPartitionHelper::Graph
+CoalescingPartitionHelper::MergeStubs (const Graph &g, double maxWeight, std::vector<uint32_t> &map)
+{
+  uint32_t n = g.weight.size ();
+
+  // vertex each vertex is merged into, itself if it is kept
+  std::vector<uint32_t> owner (n);
+  std::vector<double> weight (g.weight);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      owner[v] = v;
+    }
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      if (g.adj[v].size () != 1)
+        {
+          continue;
+        }
+      // a neighbour merged away is the other end of a lone link
+      uint32_t u = g.adj[v][0].first;
+      if (owner[u] == u && weight[u] + g.weight[v] <= maxWeight)
+        {
+          owner[v] = u;
+          weight[u] += g.weight[v];
+        }
+    }
+
+  map.assign (n, NONE);
+  uint32_t nc = 0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      if (owner[v] == v)
+        {
+          map[v] = nc++;
+        }
+    }
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      map[v] = map[owner[v]];
+    }
+  return Contract (g, map, nc);
+}
+
+CoalescingPartitionHelper::Graph
+CoalescingPartitionHelper::Coarsen (const Graph &g, double maxWeight, std::vector<uint32_t> &map)
+{
+  uint32_t n = g.weight.size ();
+
+  // light vertices are matched first, so that weights stay even
+  std::vector<uint32_t> order (n);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      order[v] = v;
+    }
+  std::stable_sort (order.begin (), order.end (), LighterVertex (g.weight));
+
+  std::vector<uint32_t> partner (n, NONE);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t v = order[i];
+      if (partner[v] != NONE)
+        {
+          continue;
+        }
+      partner[v] = v;
+      uint32_t best = NONE;
+      double bestCost = 0;
+      for (std::size_t j = 0; j < g.adj[v].size (); ++j)
+        {
+          uint32_t u = g.adj[v][j].first;
+          if (partner[u] == NONE && g.weight[u] + g.weight[v] <= maxWeight && g.adj[v][j].second > bestCost)
+            {
+              best = u;
+              bestCost = g.adj[v][j].second;
+            }
+        }
+      if (best != NONE)
+        {
+          partner[v] = best;
+          partner[best] = v;
+        }
+    }
+
+  map.assign (n, NONE);
+  uint32_t nc = 0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      if (map[v] == NONE)
+        {
+          map[v] = nc;
+          map[partner[v]] = nc;
+          nc++;
+        }
+    }
+  return Contract (g, map, nc);
+}
+
+CoalescingPartitionHelper::Graph
+CoalescingPartitionHelper::Contract (const Graph &g, const std::vector<uint32_t> &map, uint32_t nc)
+{
+  uint32_t n = g.weight.size ();
+  Graph coarse;
+  coarse.weight.assign (nc, 0);
+  std::vector<std::map<uint32_t, double> > edges (nc);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      coarse.weight[map[v]] += g.weight[v];
+      for (std::size_t j = 0; j < g.adj[v].size (); ++j)
+        {
+          uint32_t cu = map[g.adj[v][j].first];
+          if (cu != map[v])
+            {
+              edges[map[v]][cu] += g.adj[v][j].second;
+            }
+        }
+    }
+  coarse.adj.resize (nc);
+  for (uint32_t c = 0; c < nc; ++c)
+    {
+      coarse.adj[c].assign (edges[c].begin (), edges[c].end ());
+    }
+  return coarse;
+}
+
+std::vector<uint32_t>
+CoalescingPartitionHelper::Grow (const Graph &g, uint32_t n, double maxLoad)
+{
+  uint32_t nv = g.weight.size ();
+  std::vector<uint32_t> part (nv, NONE);
+  std::vector<double> load (n, 0);
+  std::vector<std::map<uint32_t, double> > frontier (n);
+  for (uint32_t left = nv; left > 0; --left)
+    {
+      // the lightest part grows along its heaviest edges from its frontier,
+      // so that the parts are filled together and none is left with the rest
+      uint32_t p = std::min_element (load.begin (), load.end ()) - load.begin ();
+      uint32_t next = NONE;
+      double nextGain = -1;
+      for (std::map<uint32_t, double>::const_iterator i = frontier[p].begin (); i != frontier[p].end (); ++i)
+        {
+          if (i->second > nextGain && load[p] + g.weight[i->first] <= maxLoad)
+            {
+              next = i->first;
+              nextGain = i->second;
+            }
+        }
+      if (next == NONE)
+        {
+          next = FindSeed (g, part, maxLoad - load[p]);
+        }
+      if (next == NONE)
+        {
+          // nothing fits, the lightest vertex left overloads the part least
+          for (uint32_t v = 0; v < nv; ++v)
+            {
+              if (part[v] == NONE && (next == NONE || g.weight[v] < g.weight[next]))
+                {
+                  next = v;
+                }
+            }
+        }
+      part[next] = p;
+      load[p] += g.weight[next];
+      for (uint32_t q = 0; q < n; ++q)
+        {
+          frontier[q].erase (next);
+        }
+      for (std::size_t j = 0; j < g.adj[next].size (); ++j)
+        {
+          uint32_t u = g.adj[next][j].first;
+          if (part[u] == NONE)
+            {
+              frontier[p][u] += g.adj[next][j].second;
+            }
+        }
+    }
+  return part;
+}
+
+uint32_t
+CoalescingPartitionHelper::FindSeed (const Graph &g, const std::vector<uint32_t> &part, double room)
+{
+  uint32_t nv = g.weight.size ();
+
+  // hops from the vertices taken, breadth first; a vertex of a component
+  // without any taken vertex stays at NONE, the farthest
+  std::vector<uint32_t> hops (nv, NONE);
+  std::vector<uint32_t> queue;
+  for (uint32_t v = 0; v < nv; ++v)
+    {
+      if (part[v] != NONE)
+        {
+          hops[v] = 0;
+          queue.push_back (v);
+        }
+    }
+  for (std::size_t i = 0; i < queue.size (); ++i)
+    {
+      uint32_t v = queue[i];
+      for (std::size_t j = 0; j < g.adj[v].size (); ++j)
+        {
+          uint32_t u = g.adj[v][j].first;
+          if (hops[u] == NONE)
+            {
+              hops[u] = hops[v] + 1;
+              queue.push_back (u);
+            }
+        }
+    }
+
+  uint32_t seed = NONE;
+  for (uint32_t v = 0; v < nv; ++v)
+    {
+      if (part[v] != NONE || g.weight[v] > room)
+        {
+          continue;
+        }
+      if (seed == NONE || hops[v] > hops[seed] || (hops[v] == hops[seed] && g.weight[v] > g.weight[seed]))
+        {
+          seed = v;
+        }
+    }
+  return seed;
+}
+
+void
+CoalescingPartitionHelper::Refine (const Graph &g, uint32_t n, double maxLoad, std::vector<uint32_t> &part)
+{
+  uint32_t nv = g.weight.size ();
+  std::vector<double> load (n, 0);
+  for (uint32_t v = 0; v < nv; ++v)
+    {
+      load[part[v]] += g.weight[v];
+    }
+
+  std::vector<double> conn (n, 0);
+  for (uint32_t pass = 0; pass < REFINE_PASSES; ++pass)
+    {
+      uint32_t moved = 0;
+      for (uint32_t v = 0; v < nv; ++v)
+        {
+          uint32_t p = part[v];
+          double w = g.weight[v];
+          std::fill (conn.begin (), conn.end (), 0);
+          for (std::size_t j = 0; j < g.adj[v].size (); ++j)
+            {
+              conn[part[g.adj[v][j].first]] += g.adj[v][j].second;
+            }
+
+          // a part over the limit gives vertices away even at a loss
+          bool overloaded = load[p] > maxLoad;
+          uint32_t best = p;
+          for (uint32_t q = 0; q < n; ++q)
+            {
+              if (q == p || load[q] + w > maxLoad)
+                {
+                  continue;
+                }
+              if (!overloaded && conn[q] == 0)
+                {
+                  continue;
+                }
+              double gain = conn[q] - conn[p];
+              bool better;
+              if (best == p)
+                {
+                  better = overloaded || gain > 0 || (gain == 0 && load[q] + w < load[p]);
+                }
+              else
+                {
+                  double bestGain = conn[best] - conn[p];
+                  better = gain > bestGain || (gain == bestGain && load[q] < load[best]);
+                }
+              if (better)
+                {
+                  best = q;
+                }
+            }
+          if (best != p)
+            {
+              part[v] = best;
+              load[p] -= w;
+              load[best] += w;
+              moved++;
+            }
+        }
+      // with no room for a move, the loads still allow an exchange
+      if (moved == 0 && Swap (g, n, maxLoad, part, load) == 0)
+        {
+          break;
+        }
+    }
+}
+
+uint32_t
+CoalescingPartitionHelper::Swap (const Graph &g, uint32_t n, double maxLoad, std::vector<uint32_t> &part,
+                                 std::vector<double> &load)
+{
+  uint32_t nv = g.weight.size ();
+
+  // boundary vertices of each part by the part they would move to, with
+  // the gain of the move
+  std::vector<std::vector<std::pair<double, uint32_t> > > moves (n * n);
+  std::vector<double> conn (n, 0);
+  for (uint32_t v = 0; v < nv; ++v)
+    {
+      uint32_t p = part[v];
+      std::fill (conn.begin (), conn.end (), 0);
+      for (std::size_t j = 0; j < g.adj[v].size (); ++j)
+        {
+          conn[part[g.adj[v][j].first]] += g.adj[v][j].second;
+        }
+      for (uint32_t q = 0; q < n; ++q)
+        {
+          if (q != p && conn[q] > 0)
+            {
+              moves[p * n + q].push_back (std::make_pair (conn[q] - conn[p], v));
+            }
+        }
+    }
+
+  // the gains of the neighbours of a swapped vertex change, so they wait
+  // for the next pass
+  std::vector<bool> locked (nv, false);
+  uint32_t swapped = 0;
+  for (uint32_t p = 0; p < n; ++p)
+    {
+      for (uint32_t q = p + 1; q < n; ++q)
+        {
+          std::vector<std::pair<double, uint32_t> > &a = moves[p * n + q];
+          std::vector<std::pair<double, uint32_t> > &b = moves[q * n + p];
+          std::sort (a.rbegin (), a.rend ());
+          std::sort (b.rbegin (), b.rend ());
+          a.resize (std::min<std::size_t> (a.size (), SWAP_CANDIDATES));
+          b.resize (std::min<std::size_t> (b.size (), SWAP_CANDIDATES));
+
+          double bestGain = 0;
+          uint32_t bestA = NONE;
+          uint32_t bestB = NONE;
+          for (std::size_t i = 0; i < a.size (); ++i)
+            {
+              uint32_t u = a[i].second;
+              for (std::size_t k = 0; k < b.size (); ++k)
+                {
+                  uint32_t v = b[k].second;
+                  if (locked[u] || locked[v] || load[p] - g.weight[u] + g.weight[v] > maxLoad
+                      || load[q] - g.weight[v] + g.weight[u] > maxLoad)
+                    {
+                      continue;
+                    }
+                  // an edge between the two stays cut, and was counted
+                  // as a gain by both
+                  double gain = a[i].first + b[k].first;
+                  for (std::size_t j = 0; j < g.adj[u].size (); ++j)
+                    {
+                      if (g.adj[u][j].first == v)
+                        {
+                          gain -= 2 * g.adj[u][j].second;
+                        }
+                    }
+                  if (gain > bestGain)
+                    {
+                      bestGain = gain;
+                      bestA = u;
+                      bestB = v;
+                    }
+                }
+            }
+          if (bestA == NONE)
+            {
+              continue;
+            }
+          part[bestA] = q;
+          part[bestB] = p;
+          load[p] += g.weight[bestB] - g.weight[bestA];
+          load[q] += g.weight[bestA] - g.weight[bestB];
+          swapped++;
+          uint32_t ends[2] = { bestA, bestB };
+          for (uint32_t e = 0; e < 2; ++e)
+            {
+              locked[ends[e]] = true;
+              for (std::size_t j = 0; j < g.adj[ends[e]].size (); ++j)
+                {
+                  locked[g.adj[ends[e]][j].first] = true;
+                }
+            }
+        }
+    }
+  return swapped;
+}
+
+std::vector<uint32_t>
+CoalescingPartitionHelper::Partition (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ABORT_MSG_IF (n == 0, "At least one partition is needed");
+
+  std::vector<Graph> levels (1, GetGraph ());
+  std::vector<std::vector<uint32_t> > maps;
+  double total = 0;
+  for (std::size_t v = 0; v < levels[0].weight.size (); ++v)
+    {
+      total += levels[0].weight[v];
+    }
+  double maxLoad = (1 + m_imbalance) * total / n;
+
+  std::vector<uint32_t> stubs;
+  Graph merged = MergeStubs (levels.back (), maxLoad / 2, stubs);
+  if (merged.weight.size () < levels.back ().weight.size ())
+    {
+      maps.push_back (stubs);
+      levels.push_back (merged);
+    }
+
+  while (levels.back ().weight.size () > COARSEST_PER_PART * n)
+    {
+      std::vector<uint32_t> map;
+      Graph coarse = Coarsen (levels.back (), maxLoad / 2, map);
+      if (coarse.weight.size () * 20 > levels.back ().weight.size () * 19)
+        {
+          // hardly any edge left to merge
+          break;
+        }
+      maps.push_back (map);
+      levels.push_back (coarse);
+    }
+  NS_LOG_LOGIC ("Coarsened " << levels[0].weight.size () << " nodes to " << levels.back ().weight.size ()
+                << " in " << maps.size () << " levels");
+
+  std::vector<uint32_t> part = Grow (levels.back (), n, maxLoad);
+  Refine (levels.back (), n, maxLoad, part);
+  for (std::size_t l = maps.size (); l > 0; --l)
+    {
+      const std::vector<uint32_t> &map = maps[l - 1];
+      std::vector<uint32_t> fine (map.size ());
+      for (std::size_t v = 0; v < map.size (); ++v)
+        {
+          fine[v] = part[map[v]];
+        }
+      part.swap (fine);
+      Refine (levels[l - 1], n, maxLoad, part);
+    }
+
+  m_part = part;
+  m_nParts = n;
+  return part;
+}
+
+double
+CoalescingPartitionHelper::GetCutTraffic (void) const
+{
+  double cut = 0;
+  for (std::size_t i = 0; i < m_links.size (); ++i)
+    {
+      if (!m_part.empty () && m_part[m_links[i].a] != m_part[m_links[i].b])
+        {
+          cut += m_links[i].traffic;
+        }
+    }
+  return cut;
+}
+
+Time
+CoalescingPartitionHelper::GetLookahead (void) const
+{
+  Time lookahead = Time::Max ();
+  for (std::size_t i = 0; i < m_links.size (); ++i)
+    {
+      if (!m_part.empty () && m_part[m_links[i].a] != m_part[m_links[i].b])
+        {
+          lookahead = std::min (lookahead, m_links[i].delay);
+        }
+    }
+  return lookahead;
+}
+
+std::vector<double>
+CoalescingPartitionHelper::GetPartLoads (void) const
+{
+  std::vector<double> loads (m_nParts, 0);
+  Graph g = GetGraph ();
+  for (std::size_t v = 0; v < m_part.size (); ++v)
+    {
+      loads[m_part[v]] += g.weight[v];
+    }
+  return loads;
+}
+
+} // namespace ns3
@@ -0,0 +1,239 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#ifndef COALESCING_PARTITION_HELPER_H
+#define COALESCING_PARTITION_HELPER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief Assign the nodes of a coalescing topology to partitions
+ *
+ * The topology is a graph whose vertices are the nodes, weighted by their
+ * expected event load, and whose edges are the links, weighted by their
+ * traffic.  Partition splits it into parts of about equal load with a
+ * multilevel scheme.  Nodes with a single link, such as the servers of a
+ * leaf, are first merged into their neighbour, since cutting their link
+ * never helps.  The graph is then coarsened by merging the ends of its
+ * heaviest edges, the coarsest graph is split by growing all parts
+ * together up to the allowed load, each part starting from the vertex
+ * farthest from the parts already started, and the split is refined on
+ * each level on the way back by moving boundary nodes to the part they are
+ * most connected to, or by swapping pairs of boundary nodes between two
+ * parts when the loads leave no room for a move.
+ *
+ * The cost of cutting a link is its traffic scaled by the smallest delay
+ * over its delay, so links with a long delay are cut first and the
+ * lookahead between the partitions stays large.
+ *
+ * A node keeps the system id it was created with, so the topology is
+ * built once to be partitioned and again with the result:
+ *
+ * \code
+ *   CoalescingPartitionHelper partitioner;
+ *   partitioner.AddDevices (devices);
+ *   std::vector<uint32_t> systemId = partitioner.Partition (4);
+ *   Simulator::Destroy ();
+ *   // create node i with CreateObject<Node> (systemId[i])
+ * \endcode
+ */
+class CoalescingPartitionHelper
+{
+public:
+  CoalescingPartitionHelper ();
+
+  /**
+   * \brief Add the links of coalescing devices
+   *
+   * Each link is added once, with the data rate of its devices as traffic
+   * and the delay of its channel.  Each node gets the traffic of its links
+   * as load, unless its load was set.
+   *
+   * \param devices devices of the topology
+   */
+  void AddDevices (NetDeviceContainer devices);
+
+  /**
+   * \brief Add a link
+   *
+   * \param a id of the node at one end
+   * \param b id of the node at the other end
+   * \param traffic expected traffic of the link, in the unit of the loads
+   * \param delay delay of the link
+   */
+  void AddLink (uint32_t a, uint32_t b, double traffic, Time delay);
+
+  /**
+   * \brief Set the expected event load of a node
+   *
+   * \param node id of the node
+   * \param load load, replacing the traffic of its links
+   */
+  void SetNodeLoad (uint32_t node, double load);
+
+  /**
+   * \brief Allow parts heavier than the mean load
+   *
+   * \param imbalance allowed excess over the mean load, 0.05 by default
+   */
+  void SetImbalance (double imbalance);
+
+  /**
+   * \brief Split the topology
+   *
+   * \param n number of partitions
+   * \return the partition of each node, indexed by node id
+   */
+  std::vector<uint32_t> Partition (uint32_t n);
+
+  /**
+   * \return the traffic of the links cut by the last partitioning
+   */
+  double GetCutTraffic (void) const;
+
+  /**
+   * \return the smallest delay of the links cut by the last partitioning,
+   * the lookahead of a distributed run, or Time::Max () if none is cut
+   */
+  Time GetLookahead (void) const;
+
+  /**
+   * \return the load of each part of the last partitioning
+   */
+  std::vector<double> GetPartLoads (void) const;
+
+private:
+  /// Link of the topology
+  struct Link
+  {
+    uint32_t a;       //!< Node at one end
+    uint32_t b;       //!< Node at the other end
+    double traffic;   //!< Expected traffic
+    Time delay;       //!< Delay
+  };
+
+  /// Graph of one level
+  struct Graph
+  {
+    std::vector<double> weight;                                 //!< Weight of each vertex
+    std::vector<std::vector<std::pair<uint32_t, double> > > adj; //!< Neighbours and edge weights
+  };
+
+  /**
+   * \brief Grow the vectors of the nodes up to a node id
+   *
+   * \param node id of a node
+   */
+  void Resize (uint32_t node);
+
+  /**
+   * \return the graph of the topology
+   */
+  Graph GetGraph (void) const;
+
+  /**
+   * \brief Merge vertices with a single neighbour into it
+   *
+   * \param g graph
+   * \param maxWeight largest weight of a merged vertex
+   * \param map coarse vertex of each vertex of g
+   * \return the coarse graph
+   */
+  static Graph MergeStubs (const Graph &g, double maxWeight, std::vector<uint32_t> &map);
+
+  /**
+   * \brief Merge the ends of heavy edges
+   *
+   * \param g graph
+   * \param maxWeight largest weight of a merged vertex
+   * \param map coarse vertex of each vertex of g
+   * \return the coarse graph
+   */
+  static Graph Coarsen (const Graph &g, double maxWeight, std::vector<uint32_t> &map);
+
+  /**
+   * \brief Build the graph of merged vertices
+   *
+   * \param g graph
+   * \param map coarse vertex of each vertex of g
+   * \param nc number of coarse vertices
+   * \return the coarse graph
+   */
+  static Graph Contract (const Graph &g, const std::vector<uint32_t> &map, uint32_t nc);
+
+  /**
+   * \brief Split a graph by growing the lightest part at each step
+   *
+   * \param g graph
+   * \param n number of parts
+   * \param maxLoad largest load of a part
+   * \return the part of each vertex
+   */
+  static std::vector<uint32_t> Grow (const Graph &g, uint32_t n, double maxLoad);
+
+  /**
+   * \brief Find the vertex a part starts from
+   *
+   * \param g graph
+   * \param part part of each vertex, NONE for vertices not taken yet
+   * \param room largest weight of the vertex
+   * \return the vertex not taken yet with the most hops to the taken
+   * ones, the heaviest of those, or NONE if none fits
+   */
+  static uint32_t FindSeed (const Graph &g, const std::vector<uint32_t> &part, double room);
+
+  /**
+   * \brief Move boundary vertices to the parts they are most connected to
+   *
+   * \param g graph
+   * \param n number of parts
+   * \param maxLoad largest load of a part
+   * \param part part of each vertex
+   */
+  static void Refine (const Graph &g, uint32_t n, double maxLoad, std::vector<uint32_t> &part);
+
+  /**
+   * \brief Swap pairs of boundary vertices between parts
+   *
+   * \param g graph
+   * \param n number of parts
+   * \param maxLoad largest load of a part
+   * \param part part of each vertex
+   * \param load load of each part
+   * \return the number of pairs swapped
+   */
+  static uint32_t Swap (const Graph &g, uint32_t n, double maxLoad, std::vector<uint32_t> &part,
+                        std::vector<double> &load);
+
+  std::vector<double> m_load;       //!< Load of each node
+  std::vector<bool> m_loadSet;      //!< Whether the load of the node was set
+  std::vector<Link> m_links;        //!< Links
+  double m_imbalance;               //!< Allowed excess over the mean load
+  std::vector<uint32_t> m_part;     //!< Result of the last partitioning
+  uint32_t m_nParts;                //!< Number of parts of the last partitioning
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_PARTITION_HELPER_H */
@@ -24,9 +24,15 @@
 #include "ns3/point-to-point-coalescing-net-device.h"
 #include "ns3/point-to-point-coalescing-channel.h"
 #include "ns3/point-to-point-coalescing-remote-channel.h"
-#include "ns3/queue.h"
+#include "ns3/point-to-point-coalescing-partition-channel.h"
+#include "ns3/coalescing-partition-interface.h"
+#include "ns3/coalescing-queue.h"
+#include "ns3/coalescing-timer-wheel.h"
 #include "ns3/net-device-queue-interface.h"
 #include "ns3/config.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
 #include "ns3/packet.h"
 #include "ns3/names.h"
 #include "ns3/mpi-interface.h"
@@ -41,10 +47,11 @@ NS_LOG_COMPONENT_DEFINE ("PointToPointCoalescingHelper");
 
 PointToPointCoalescingHelper::PointToPointCoalescingHelper ()
 {
-  m_queueFactory.SetTypeId ("ns3::DropTailQueue<Packet>");
+  m_queueFactory.SetTypeId ("ns3::CoalescingQueue");
   m_deviceFactory.SetTypeId ("ns3::PointToPointCoalescingNetDevice");
   m_channelFactory.SetTypeId ("ns3::PointToPointCoalescingChannel");
   m_remoteChannelFactory.SetTypeId ("ns3::PointToPointCoalescingRemoteChannel");
+  m_partitionChannelFactory.SetTypeId ("ns3::PointToPointCoalescingPartitionChannel");
 }
 
 void 
@@ -54,8 +61,14 @@ PointToPointCoalescingHelper::SetQueue (std::string type,
                               std::string n3, const AttributeValue &v3,
                               std::string n4, const AttributeValue &v4)
 {
-  QueueBase::AppendItemTypeIfNotPresent (type, "Packet");
-
+  if (type == "ns3::DropTailQueue<Packet>")
+    {
+      // the coalescing queue is a drop-tail queue with the same MaxSize
+      NS_LOG_WARN ("Using ns3::CoalescingQueue in place of " << type);
+      type = "ns3::CoalescingQueue";
+    }
+  NS_ABORT_MSG_UNLESS (TypeId::LookupByName (type).IsChildOf (CoalescingQueue::GetTypeId ()),
+                       "The queue of a coalescing device must be ns3::CoalescingQueue or a subclass of it, not " << type);
   m_queueFactory.SetTypeId (type);
   m_queueFactory.Set (n1, v1);
   m_queueFactory.Set (n2, v2);
@@ -63,6 +76,60 @@ PointToPointCoalescingHelper::SetQueue (std::string type,
   m_queueFactory.Set (n4, v4);
 }
 
+void 
+PointToPointCoalescingHelper::SetDeviceType (std::string type)
+{
+  m_deviceFactory.SetTypeId (type);
+}
+
+int64_t
+PointToPointCoalescingHelper::AssignStreams (NetDeviceContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (*i);
+      if (dev != 0)
+        {
+          currentStream += dev->AssignStreams (currentStream);
+        }
+    }
+  return (currentStream - stream);
+}
+
+void
+PointToPointCoalescingHelper::InstallTimerWheels (NetDeviceContainer c)
+{
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<PointToPointCoalescingNetDeviceBase> dev = DynamicCast<PointToPointCoalescingNetDeviceBase> (*i);
+      if (dev == 0)
+        {
+          continue;
+        }
+      Ptr<Node> node = dev->GetNode ();
+      Ptr<CoalescingTimerWheel> wheel = node->GetObject<CoalescingTimerWheel> ();
+      if (wheel == 0)
+        {
+          wheel = CreateObject<CoalescingTimerWheel> ();
+          node->AggregateObject (wheel);
+        }
+      dev->SetAttribute ("TimerWheel", PointerValue (wheel));
+    }
+}
+
+void
+PointToPointCoalescingHelper::SetCoalescingPolicy (CoalescingPolicy::Type policy)
+{
+  m_deviceFactory.Set ("CoalescingPolicy", EnumValue (policy));
+}
+
+void
+PointToPointCoalescingHelper::SetBatchBursts (bool batch)
+{
+  m_remoteChannelFactory.Set ("BatchBursts", BooleanValue (batch));
+}
+
 void 
 PointToPointCoalescingHelper::SetDeviceAttribute (std::string n1, const AttributeValue &v1)
 {
@@ -74,6 +141,7 @@ PointToPointCoalescingHelper::SetChannelAttribute (std::string n1, const Attribu
 {
   m_channelFactory.Set (n1, v1);
   m_remoteChannelFactory.Set (n1, v1);
+  m_partitionChannelFactory.Set (n1, v1);
 }
 
 void 
@@ -170,10 +238,10 @@ PointToPointCoalescingHelper::EnableAsciiInternal (
       // The "+", '-', and 'd' events are driven by trace sources actually in the
       // transmit queue.
       //
-      Ptr<Queue<Packet> > queue = device->GetQueue ();
-      asciiTraceHelper.HookDefaultEnqueueSinkWithoutContext<Queue<Packet> > (queue, "Enqueue", theStream);
-      asciiTraceHelper.HookDefaultDropSinkWithoutContext<Queue<Packet> > (queue, "Drop", theStream);
-      asciiTraceHelper.HookDefaultDequeueSinkWithoutContext<Queue<Packet> > (queue, "Dequeue", theStream);
+      Ptr<CoalescingQueue> queue = device->GetQueue ();
+      asciiTraceHelper.HookDefaultEnqueueSinkWithoutContext<CoalescingQueue> (queue, "Enqueue", theStream);
+      asciiTraceHelper.HookDefaultDropSinkWithoutContext<CoalescingQueue> (queue, "Drop", theStream);
+      asciiTraceHelper.HookDefaultDequeueSinkWithoutContext<CoalescingQueue> (queue, "Dequeue", theStream);
 
       // PhyRxDrop trace source for "d" event
       asciiTraceHelper.HookDefaultDropSinkWithoutContext<PointToPointCoalescingNetDevice> (device, "PhyRxDrop", theStream);
@@ -229,22 +297,23 @@ PointToPointCoalescingHelper::Install (Ptr<Node> a, Ptr<Node> b)
 {
   NetDeviceContainer container;
 
-  Ptr<PointToPointCoalescingNetDevice> devA = m_deviceFactory.Create<PointToPointCoalescingNetDevice> ();
+  Ptr<PointToPointCoalescingNetDeviceBase> devA = m_deviceFactory.Create<PointToPointCoalescingNetDeviceBase> ();
   devA->SetAddress (Mac48Address::Allocate ());
   a->AddDevice (devA);
-  Ptr<Queue<Packet> > queueA = m_queueFactory.Create<Queue<Packet> > ();
+  Ptr<CoalescingQueue> queueA = m_queueFactory.Create<CoalescingQueue> ();
   devA->SetQueue (queueA);
-  Ptr<PointToPointCoalescingNetDevice> devB = m_deviceFactory.Create<PointToPointCoalescingNetDevice> ();
+  Ptr<PointToPointCoalescingNetDeviceBase> devB = m_deviceFactory.Create<PointToPointCoalescingNetDeviceBase> ();
   devB->SetAddress (Mac48Address::Allocate ());
   b->AddDevice (devB);
-  Ptr<Queue<Packet> > queueB = m_queueFactory.Create<Queue<Packet> > ();
+  Ptr<CoalescingQueue> queueB = m_queueFactory.Create<CoalescingQueue> ();
   devB->SetQueue (queueB);
-  // Aggregate NetDeviceQueueInterface objects
+  // Aggregate NetDeviceQueueInterface objects.  The queue stops and wakes
+  // the device queue when it cannot take another frame of MTU size.
   Ptr<NetDeviceQueueInterface> ndqiA = CreateObject<NetDeviceQueueInterface> ();
-  ndqiA->GetTxQueue (0)->ConnectQueueTraces (queueA);
+  queueA->ConnectNetDeviceQueue (ndqiA->GetTxQueue (0), devA->GetMtu () + 2);
   devA->AggregateObject (ndqiA);
   Ptr<NetDeviceQueueInterface> ndqiB = CreateObject<NetDeviceQueueInterface> ();
-  ndqiB->GetTxQueue (0)->ConnectQueueTraces (queueB);
+  queueB->ConnectNetDeviceQueue (ndqiB->GetTxQueue (0), devB->GetMtu () + 2);
   devB->AggregateObject (ndqiB);
 
   // If MPI is enabled, we need to see if both nodes have the same system id 
@@ -263,17 +332,34 @@ PointToPointCoalescingHelper::Install (Ptr<Node> a, Ptr<Node> b)
           useNormalChannel = false;
         }
     }
-  if (useNormalChannel)
+  // Partitions of one machine exchange frames through shared memory
+  bool usePartitionChannel = CoalescingPartitionInterface::IsEnabled ()
+    && a->GetSystemId () != b->GetSystemId ();
+
+  if (usePartitionChannel)
+    {
+      channel = m_partitionChannelFactory.Create<PointToPointCoalescingPartitionChannel> ();
+    }
+  else if (useNormalChannel)
     {
       channel = m_channelFactory.Create<PointToPointCoalescingChannel> ();
     }
   else
     {
-      channel = m_remoteChannelFactory.Create<PointToPointCoalescingRemoteChannel> ();
+      Ptr<PointToPointCoalescingRemoteChannel> remote = m_remoteChannelFactory.Create<PointToPointCoalescingRemoteChannel> ();
+      channel = remote;
       Ptr<MpiReceiver> mpiRecA = CreateObject<MpiReceiver> ();
       Ptr<MpiReceiver> mpiRecB = CreateObject<MpiReceiver> ();
-      mpiRecA->SetReceiveCallback (MakeCallback (&PointToPointCoalescingNetDevice::Receive, devA));
-      mpiRecB->SetReceiveCallback (MakeCallback (&PointToPointCoalescingNetDevice::Receive, devB));
+      if (remote->GetBatchBursts ())
+        {
+          mpiRecA->SetReceiveCallback (MakeCallback (&PointToPointCoalescingNetDeviceBase::DoMpiReceiveBurst, devA));
+          mpiRecB->SetReceiveCallback (MakeCallback (&PointToPointCoalescingNetDeviceBase::DoMpiReceiveBurst, devB));
+        }
+      else
+        {
+          mpiRecA->SetReceiveCallback (MakeCallback (&PointToPointCoalescingNetDeviceBase::Receive, devA));
+          mpiRecB->SetReceiveCallback (MakeCallback (&PointToPointCoalescingNetDeviceBase::Receive, devB));
+        }
       devA->AggregateObject (mpiRecA);
       devB->AggregateObject (mpiRecB);
     }
@@ -28,6 +28,7 @@
 #include "ns3/node-container.h"
 
 #include "ns3/trace-helper.h"
+#include "ns3/coalescing-policy.h"
 
 namespace ns3 {
 
@@ -69,6 +70,10 @@ public:
    *
    * Set the type of queue to create and associated to each
    * PointToPointCoalescingNetDevice created through PointToPointCoalescingHelper::Install.
+   * The type must be ns3::CoalescingQueue or a subclass of it.  For the
+   * scripts written for PointToPointHelper, ns3::DropTailQueue<Packet> is
+   * taken as ns3::CoalescingQueue, which is a drop-tail queue with the same
+   * MaxSize attribute; any other queue type aborts.
    */
   void SetQueue (std::string type,
                  std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
@@ -76,6 +81,39 @@ public:
                  std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),
                  std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue ());
 
+  /**
+   * Set the type of device created by PointToPointCoalescingHelper::Install.
+   *
+   * \param type the type of device, ns3::PointToPointCoalescingNetDevice
+   * (the default) or ns3::PointToPointCoalescingLeanNetDevice
+   *
+   * The lean device has no trace sources, so pcap and ascii tracing
+   * cannot be enabled on it.
+   */
+  void SetDeviceType (std::string type);
+
+  /**
+   * Set the coalescing policy of the devices created by
+   * PointToPointCoalescingHelper::Install.
+   *
+   * \param policy the policy, CoalescingPolicy::BYTE_LIMIT by default
+   *
+   * The limits of the policies are set with the EeeByteLimit,
+   * EeePacketLimit and EeeLowByteLimit device attributes.
+   */
+  void SetCoalescingPolicy (CoalescingPolicy::Type policy);
+
+  /**
+   * Send the frames of a burst to another system in one MPI message, on
+   * the remote channels created by PointToPointCoalescingHelper::Install.
+   *
+   * \param batch true to batch bursts, false by default
+   *
+   * The receiving devices unpack the messages, so every system of the
+   * simulation must make the same choice.
+   */
+  void SetBatchBursts (bool batch);
+
   /**
    * Set an attribute value to be propagated to each NetDevice created by the
    * helper.
@@ -151,6 +189,34 @@ public:
    */
   NetDeviceContainer Install (std::string aNode, std::string bNode);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the devices.  Return the number of streams (possibly zero)
+   * that have been assigned.
+   *
+   * Streams are assigned in the order of the container, so they stay the
+   * same as long as the devices are created in the same order, whatever
+   * their EEE attributes.  Comparisons of EEE configurations then see the
+   * same packet losses on the coalescing links.
+   *
+   * \param c NetDeviceContainer of the set of devices
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by the helper
+   */
+  int64_t AssignStreams (NetDeviceContainer c, int64_t stream);
+
+  /**
+   * Give the devices of each node one shared timer wheel, which holds
+   * their coalescing timeout, sleep and wake-up events instead of the
+   * scheduler of the simulator.
+   *
+   * The wheel of a node is aggregated to it, so devices installed later
+   * on the node get the same wheel.
+   *
+   * \param c NetDeviceContainer of the set of devices
+   */
+  void InstallTimerWheels (NetDeviceContainer c);
+
 private:
   /**
    * \brief Enable pcap output the indicated net device.
@@ -185,6 +251,7 @@ private:
   ObjectFactory m_queueFactory;         //!< Queue Factory
   ObjectFactory m_channelFactory;       //!< Channel Factory
   ObjectFactory m_remoteChannelFactory; //!< Remote Channel Factory
+  ObjectFactory m_partitionChannelFactory; //!< Partition Channel Factory
   ObjectFactory m_deviceFactory;        //!< Device Factory
 };
 
@@ -0,0 +1,117 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cstdio>
+#include <fstream>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "coalescing-arrival-trace-sink.h"
+#include "coalescing-measurement-sink.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingArrivalTraceSink");
+
+NS_OBJECT_ENSURE_REGISTERED (CoalescingArrivalTraceSink);
+
+TypeId
+CoalescingArrivalTraceSink::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoalescingArrivalTraceSink")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<CoalescingArrivalTraceSink> ()
+    .AddAttribute ("OutputPath",
+                   "Path of the binary file the arrival traces are written to",
+                   StringValue ("arrivals.bin"),
+                   MakeStringAccessor (&CoalescingArrivalTraceSink::m_outputPath),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+CoalescingArrivalTraceSink::CoalescingArrivalTraceSink ()
+  : m_written (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CoalescingArrivalTraceSink::~CoalescingArrivalTraceSink ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CoalescingArrivalTraceSink::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  m_ports.clear ();
+  m_data.clear ();
+  Object::DoDispose ();
+}
+
+void
+CoalescingArrivalTraceSink::Add (uint32_t nodeId, uint32_t ifIndex, uint64_t dataRate, const CoalescingArrivalEncoder &arrivals)
+{
+  NS_LOG_FUNCTION (this << nodeId << ifIndex << arrivals.GetNArrivals ());
+  CoalescingArrivalTraceFormat::Port port;
+  port.nodeId = nodeId;
+  port.ifIndex = ifIndex;
+  port.dataRate = dataRate;
+  port.nArrivals = arrivals.GetNArrivals ();
+  port.offset = 0;
+  port.size = 0;
+  m_ports.push_back (port);
+  m_data.push_back (&arrivals.GetData ());
+  m_written = false;
+}
+
+void
+CoalescingArrivalTraceSink::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_written)
+    {
+      return;
+    }
+
+  //
+  // The file is written under a temporary name and renamed, so readers
+  // which map it never see a partial trace.
+  //
+  std::string path = CoalescingMeasurementSink::GetSystemPath (m_outputPath);
+  std::string tmp = path + ".part";
+  std::ofstream file (tmp.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS (file.is_open (), "Cannot open arrival trace file " << tmp);
+  CoalescingArrivalTraceFormat::Write (file, Simulator::Now ().GetNanoSeconds (), m_ports, m_data);
+  file.close ();
+  NS_ABORT_MSG_IF (std::rename (tmp.c_str (), path.c_str ()) != 0,
+                   "Cannot rename arrival trace file to " << path);
+  m_written = true;
+  NS_LOG_LOGIC ("Wrote arrivals of " << m_ports.size () << " ports to " << path);
+}
+
+uint32_t
+CoalescingArrivalTraceSink::GetNPorts (void) const
+{
+  return m_ports.size ();
+}
+
+} // namespace ns3
@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_ARRIVAL_TRACE_SINK_H
+#define COALESCING_ARRIVAL_TRACE_SINK_H
+
+#include <string>
+#include <vector>
+#include "ns3/object.h"
+#include "coalescing-arrival-trace.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Writer of the arrival traces of a run
+ *
+ * Devices with the RecordArrivals attribute encode the arrivals of their
+ * port in memory.  At the end of the run they are added to one sink,
+ * which writes them to one file when it is closed or disposed.
+ *
+ * In a distributed or partitioned run each system writes the arrivals of
+ * its own ports to a file of its own, the output path followed by "." and
+ * the system id.  The replay tools read the files of all systems together.
+ *
+ * \see CoalescingArrivalTraceFormat
+ */
+class CoalescingArrivalTraceSink : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Construct a CoalescingArrivalTraceSink
+   */
+  CoalescingArrivalTraceSink ();
+
+  /**
+   * \brief Destroy a CoalescingArrivalTraceSink
+   */
+  virtual ~CoalescingArrivalTraceSink ();
+
+  /**
+   * \brief Add the arrivals of a port
+   *
+   * The encoder must stay alive until the sink is closed.
+   *
+   * \param nodeId id of the node of the device
+   * \param ifIndex interface index of the device
+   * \param dataRate data rate of the device in bit/s
+   * \param arrivals encoded arrivals of the device
+   */
+  void Add (uint32_t nodeId, uint32_t ifIndex, uint64_t dataRate, const CoalescingArrivalEncoder &arrivals);
+
+  /**
+   * \brief Write the file, if ports have been added since the last write
+   *
+   * The trace ends at the current simulation time.
+   */
+  void Close (void);
+
+  /**
+   * \return The number of ports added
+   */
+  uint32_t GetNPorts (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  std::string m_outputPath;                               //!< Path of the output file
+  std::vector<CoalescingArrivalTraceFormat::Port> m_ports; //!< Directory of the ports
+  std::vector<const std::vector<uint8_t> *> m_data;       //!< Encoded arrivals of the ports
+  bool m_written;                                         //!< The file is up to date
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_ARRIVAL_TRACE_SINK_H */
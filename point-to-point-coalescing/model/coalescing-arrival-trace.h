@@ -0,0 +1,326 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_ARRIVAL_TRACE_H
+#define COALESCING_ARRIVAL_TRACE_H
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Compact encoding of the packet arrivals of one port
+ *
+ * Every arrival is stored as the difference of its time to the time of
+ * the previous arrival, in nanoseconds, followed by its size in bytes,
+ * both as unsigned LEB128 varints.  Arrivals closer than 128 ns and
+ * packets smaller than 128 bytes take one byte each, and a typical
+ * arrival of a data center trace takes four or five bytes.
+ */
+class CoalescingArrivalEncoder
+{
+public:
+  CoalescingArrivalEncoder ()
+    : m_lastNs (0),
+      m_nArrivals (0)
+  {
+  }
+
+  /**
+   * \param timeNs time of the arrival in nanoseconds, not earlier than
+   * the previous arrival
+   * \param size size of the packet in bytes
+   */
+  void Add (uint64_t timeNs, uint32_t size)
+  {
+    PutVarint (timeNs - m_lastNs);
+    PutVarint (size);
+    m_lastNs = timeNs;
+    m_nArrivals++;
+  }
+
+  /// \return the number of arrivals
+  uint64_t GetNArrivals (void) const
+  {
+    return m_nArrivals;
+  }
+
+  /// \return the encoded arrivals
+  const std::vector<uint8_t> &GetData (void) const
+  {
+    return m_data;
+  }
+
+private:
+  /// Appends v as unsigned LEB128
+  void PutVarint (uint64_t v)
+  {
+    while (v >= 0x80)
+      {
+        m_data.push_back (static_cast<uint8_t> (v | 0x80));
+        v >>= 7;
+      }
+    m_data.push_back (static_cast<uint8_t> (v));
+  }
+
+  std::vector<uint8_t> m_data;  //!< Encoded arrivals
+  uint64_t m_lastNs;            //!< Time of the last arrival
+  uint64_t m_nArrivals;         //!< Number of arrivals
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Decoder of the arrivals of one port, in place over a buffer
+ *
+ * The buffer is usually a memory-mapped trace file, so decoding does not
+ * copy or allocate.
+ */
+class CoalescingArrivalDecoder
+{
+public:
+  /**
+   * \param data first byte of the encoded arrivals
+   * \param size number of bytes of the encoded arrivals
+   */
+  CoalescingArrivalDecoder (const uint8_t *data, std::size_t size)
+    : m_p (data),
+      m_end (data + size),
+      m_timeNs (0)
+  {
+  }
+
+  /**
+   * \param timeNs time of the next arrival in nanoseconds
+   * \param size size of the next packet in bytes
+   * \return false if there are no more arrivals
+   */
+  bool Next (uint64_t &timeNs, uint32_t &size)
+  {
+    if (m_p >= m_end)
+      {
+        return false;
+      }
+    m_timeNs += GetVarint ();
+    timeNs = m_timeNs;
+    size = static_cast<uint32_t> (GetVarint ());
+    return true;
+  }
+
+private:
+  /// \return the next unsigned LEB128 value, truncated at the end of the buffer
+  uint64_t GetVarint (void)
+  {
+    uint64_t v = 0;
+    for (int shift = 0; m_p < m_end; shift += 7)
+      {
+        uint8_t b = *m_p++;
+        v |= static_cast<uint64_t> (b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+          {
+            break;
+          }
+      }
+    return v;
+  }
+
+  const uint8_t *m_p;    //!< Next byte
+  const uint8_t *m_end;  //!< End of the buffer
+  uint64_t m_timeNs;     //!< Time of the last decoded arrival
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief File format of the arrival traces of a run
+ *
+ * The file is laid out so that it can be memory-mapped and read in place:
+ *
+ * - the magic string "EEEARRV" and a terminating zero byte,
+ * - the format version as uint32,
+ * - the number of ports as uint32,
+ * - the simulation time at which the trace ends, in nanoseconds, as uint64,
+ * - a directory with one entry per port: node id and interface index as
+ *   uint32, data rate in bit/s, number of arrivals, offset of the encoded
+ *   arrivals from the start of the file and their size in bytes as uint64,
+ * - the encoded arrivals of every port, see CoalescingArrivalEncoder.
+ *
+ * All numbers are little-endian.  The directory entries are 40 bytes, so
+ * all of their fields are naturally aligned.
+ */
+class CoalescingArrivalTraceFormat
+{
+public:
+  /// Version of the format written by this header
+  static const uint32_t VERSION = 1;
+
+  /// Size of the file header in bytes
+  static const std::size_t HEADER_SIZE = 24;
+
+  /// Size of a directory entry in bytes
+  static const std::size_t ENTRY_SIZE = 40;
+
+  /// Directory entry of a port
+  struct Port
+  {
+    uint32_t nodeId;      //!< Id of the node of the device
+    uint32_t ifIndex;     //!< Interface index of the device
+    uint64_t dataRate;    //!< Data rate of the device, in bit/s
+    uint64_t nArrivals;   //!< Number of arrivals
+    uint64_t offset;      //!< Offset of the encoded arrivals in the file
+    uint64_t size;        //!< Size of the encoded arrivals in bytes
+  };
+
+  /**
+   * \return The magic string at the start of a file, 8 bytes with the terminating zero
+   */
+  static const char *GetMagic (void)
+  {
+    return "EEEARRV";
+  }
+
+  /**
+   * \brief Write a whole trace file
+   *
+   * The offsets of the ports are computed here.
+   *
+   * \param os Output stream
+   * \param endNs time at which the trace ends, in nanoseconds
+   * \param ports directory entries of the ports
+   * \param data encoded arrivals of each port
+   */
+  static void Write (std::ostream &os, uint64_t endNs, std::vector<Port> ports,
+                     const std::vector<const std::vector<uint8_t> *> &data)
+  {
+    os.write (GetMagic (), 8);
+    WriteU32 (os, VERSION);
+    WriteU32 (os, static_cast<uint32_t> (ports.size ()));
+    WriteU64 (os, endNs);
+    uint64_t offset = HEADER_SIZE + ENTRY_SIZE * ports.size ();
+    for (std::size_t i = 0; i < ports.size (); ++i)
+      {
+        ports[i].offset = offset;
+        ports[i].size = data[i]->size ();
+        offset += ports[i].size;
+        WriteU32 (os, ports[i].nodeId);
+        WriteU32 (os, ports[i].ifIndex);
+        WriteU64 (os, ports[i].dataRate);
+        WriteU64 (os, ports[i].nArrivals);
+        WriteU64 (os, ports[i].offset);
+        WriteU64 (os, ports[i].size);
+      }
+    for (std::size_t i = 0; i < ports.size (); ++i)
+      {
+        if (!data[i]->empty ())
+          {
+            os.write (reinterpret_cast<const char *> (&(*data[i])[0]), data[i]->size ());
+          }
+      }
+  }
+
+  /**
+   * \brief Read the header and the directory of a trace in memory
+   *
+   * \param base first byte of the file
+   * \param length size of the file in bytes
+   * \param endNs time at which the trace ends, in nanoseconds
+   * \param ports directory entries of the ports
+   * \return false if the buffer does not hold a valid trace of this version
+   */
+  static bool Read (const uint8_t *base, std::size_t length, uint64_t &endNs, std::vector<Port> &ports)
+  {
+    if (length < HEADER_SIZE || std::memcmp (base, GetMagic (), 8) != 0
+        || GetU32 (base + 8) != VERSION)
+      {
+        return false;
+      }
+    uint32_t n = GetU32 (base + 12);
+    endNs = GetU64 (base + 16);
+    if (length < HEADER_SIZE + ENTRY_SIZE * static_cast<uint64_t> (n))
+      {
+        return false;
+      }
+    ports.resize (n);
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        const uint8_t *e = base + HEADER_SIZE + ENTRY_SIZE * i;
+        ports[i].nodeId = GetU32 (e);
+        ports[i].ifIndex = GetU32 (e + 4);
+        ports[i].dataRate = GetU64 (e + 8);
+        ports[i].nArrivals = GetU64 (e + 16);
+        ports[i].offset = GetU64 (e + 24);
+        ports[i].size = GetU64 (e + 32);
+        if (ports[i].offset > length || ports[i].size > length - ports[i].offset)
+          {
+            return false;
+          }
+      }
+    return true;
+  }
+
+private:
+  /// Write v as little-endian
+  static void WriteU32 (std::ostream &os, uint32_t v)
+  {
+    char b[4];
+    for (int i = 0; i < 4; ++i)
+      {
+        b[i] = static_cast<char> ((v >> (8 * i)) & 0xff);
+      }
+    os.write (b, 4);
+  }
+
+  /// Write v as little-endian
+  static void WriteU64 (std::ostream &os, uint64_t v)
+  {
+    char b[8];
+    for (int i = 0; i < 8; ++i)
+      {
+        b[i] = static_cast<char> ((v >> (8 * i)) & 0xff);
+      }
+    os.write (b, 8);
+  }
+
+  /// \return Little-endian value at p
+  static uint32_t GetU32 (const uint8_t *p)
+  {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i)
+      {
+        v = (v << 8) | p[i];
+      }
+    return v;
+  }
+
+  /// \return Little-endian value at p
+  static uint64_t GetU64 (const uint8_t *p)
+  {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+      {
+        v = (v << 8) | p[i];
+      }
+    return v;
+  }
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_ARRIVAL_TRACE_H */
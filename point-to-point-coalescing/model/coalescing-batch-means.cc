@@ -0,0 +1,185 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cmath>
+#include <limits>
+#include "coalescing-batch-means.h"
+
+namespace ns3 {
+
+CoalescingBatchMeans::CoalescingBatchMeans (uint32_t batchSize)
+  : m_batchSize (batchSize > 0 ? batchSize : 1),
+    m_nInBatch (0),
+    m_value (0),
+    m_weight (0),
+    m_nObservations (0),
+    m_valid (false),
+    m_truncation (0),
+    m_mean (0),
+    m_variance (0)
+{
+}
+
+void
+CoalescingBatchMeans::SetBatchSize (uint32_t batchSize)
+{
+  m_batchSize = batchSize > 0 ? batchSize : 1;
+  Reset ();
+}
+
+uint32_t
+CoalescingBatchMeans::GetBatchSize (void) const
+{
+  return m_batchSize;
+}
+
+void
+CoalescingBatchMeans::Add (double value, double weight)
+{
+  m_value += value;
+  m_weight += weight;
+  m_nObservations++;
+  if (++m_nInBatch == m_batchSize)
+    {
+      m_batches.push_back (m_weight > 0 ? m_value / m_weight : 0);
+      m_nInBatch = 0;
+      m_value = 0;
+      m_weight = 0;
+      m_valid = false;
+    }
+}
+
+uint64_t
+CoalescingBatchMeans::GetNObservations (void) const
+{
+  return m_nObservations;
+}
+
+uint32_t
+CoalescingBatchMeans::GetNBatches (void) const
+{
+  return m_batches.size ();
+}
+
+uint32_t
+CoalescingBatchMeans::GetTruncation (void) const
+{
+  Update ();
+  return m_truncation;
+}
+
+double
+CoalescingBatchMeans::GetMean (void) const
+{
+  Update ();
+  return m_mean;
+}
+
+double
+CoalescingBatchMeans::GetHalfWidth (double z) const
+{
+  Update ();
+  uint32_t n = m_batches.size () - m_truncation;
+  if (n < 2)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  return z * std::sqrt (m_variance / n);
+}
+
+double
+CoalescingBatchMeans::GetRelativeHalfWidth (double z) const
+{
+  double hw = GetHalfWidth (z);
+  double mean = std::fabs (GetMean ());
+  if (mean == 0)
+    {
+      return hw == 0 ? 0 : std::numeric_limits<double>::infinity ();
+    }
+  return hw / mean;
+}
+
+bool
+CoalescingBatchMeans::IsConverged (double target, double z, uint32_t minBatches) const
+{
+  return GetNBatches () - GetTruncation () >= minBatches
+         && GetRelativeHalfWidth (z) <= target;
+}
+
+void
+CoalescingBatchMeans::Reset (void)
+{
+  m_nInBatch = 0;
+  m_value = 0;
+  m_weight = 0;
+  m_nObservations = 0;
+  m_batches.clear ();
+  m_valid = false;
+}
+
+void
+CoalescingBatchMeans::Update (void) const
+{
+  if (m_valid)
+    {
+      return;
+    }
+  m_valid = true;
+  m_truncation = 0;
+  m_mean = 0;
+  m_variance = 0;
+
+  uint32_t n = m_batches.size ();
+  if (n == 0)
+    {
+      return;
+    }
+
+  //
+  // Sums over the suffixes of the batch means give the MSER statistic of
+  // every truncation in one backward pass.
+  //
+  double sum = 0;
+  double sumSq = 0;
+  double best = std::numeric_limits<double>::infinity ();
+  for (uint32_t d = n; d-- > 0; )
+    {
+      sum += m_batches[d];
+      sumSq += m_batches[d] * m_batches[d];
+      if (d > n / 2)
+        {
+          continue;
+        }
+      double k = n - d;
+      double mean = sum / k;
+      double ss = sumSq - k * mean * mean;
+      if (ss < 0)
+        {
+          ss = 0;
+        }
+      double mser = ss / (k * k);
+      if (mser <= best)
+        {
+          best = mser;
+          m_truncation = d;
+          m_mean = mean;
+          m_variance = k > 1 ? ss / (k - 1) : 0;
+        }
+    }
+}
+
+} // namespace ns3
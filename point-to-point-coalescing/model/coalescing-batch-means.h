@@ -0,0 +1,124 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_BATCH_MEANS_H
+#define COALESCING_BATCH_MEANS_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Batch-means estimate of a steady-state mean within one run
+ *
+ * Observations are grouped into batches of a fixed number of
+ * observations.  Each observation has a value and a weight, and the mean
+ * of a batch is the sum of its values over the sum of its weights, so
+ * both plain means (weight 1) and ratios of sums can be estimated.
+ *
+ * The initial transient is removed by the MSER rule: the first d batches
+ * are deleted, with d chosen up to half of the batches so that the
+ * variance of the mean of the remaining batches, sum (Y_i - mean)^2 /
+ * (n - d)^2, is smallest.  The confidence interval is computed from the
+ * remaining batch means, which are treated as independent.
+ */
+class CoalescingBatchMeans
+{
+public:
+  /**
+   * \param batchSize number of observations of a batch
+   */
+  CoalescingBatchMeans (uint32_t batchSize = 32);
+
+  /**
+   * \brief Set the number of observations of a batch
+   *
+   * Observations already added are discarded.
+   *
+   * \param batchSize number of observations of a batch
+   */
+  void SetBatchSize (uint32_t batchSize);
+
+  /// \return the number of observations of a batch
+  uint32_t GetBatchSize (void) const;
+
+  /**
+   * \param value value of the observation
+   * \param weight weight of the observation
+   */
+  void Add (double value, double weight = 1);
+
+  /// \return the number of observations
+  uint64_t GetNObservations (void) const;
+
+  /// \return the number of complete batches
+  uint32_t GetNBatches (void) const;
+
+  /// \return the number of batches deleted as warm-up by the MSER rule
+  uint32_t GetTruncation (void) const;
+
+  /// \return the mean of the batches after the warm-up
+  double GetMean (void) const;
+
+  /**
+   * \param z quantile of the normal distribution, 1.96 for 95%
+   * \return the half-width of the confidence interval of the mean
+   */
+  double GetHalfWidth (double z) const;
+
+  /**
+   * \param z quantile of the normal distribution, 1.96 for 95%
+   * \return the half-width relative to the mean, or a large value if
+   * there are too few batches
+   */
+  double GetRelativeHalfWidth (double z) const;
+
+  /**
+   * \param target relative half-width to reach
+   * \param z quantile of the normal distribution
+   * \param minBatches batches needed after the warm-up
+   * \return true if the estimate is precise enough
+   */
+  bool IsConverged (double target, double z, uint32_t minBatches) const;
+
+  /**
+   * \brief Discard all observations
+   */
+  void Reset (void);
+
+private:
+  /// Computes the MSER truncation and the statistics of the rest
+  void Update (void) const;
+
+  uint32_t m_batchSize;                 //!< Observations of a batch
+  uint32_t m_nInBatch;                  //!< Observations of the current batch
+  double m_value;                       //!< Sum of values of the current batch
+  double m_weight;                      //!< Sum of weights of the current batch
+  uint64_t m_nObservations;             //!< Number of observations
+  std::vector<double> m_batches;        //!< Means of the complete batches
+
+  mutable bool m_valid;                 //!< Cached statistics are up to date
+  mutable uint32_t m_truncation;        //!< Cached MSER truncation
+  mutable double m_mean;                //!< Cached mean
+  mutable double m_variance;            //!< Cached variance of the batch means
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_BATCH_MEANS_H */
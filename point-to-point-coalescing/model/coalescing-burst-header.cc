@@ -0,0 +1,118 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "coalescing-burst-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingBurstHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (CoalescingBurstHeader);
+
+CoalescingBurstHeader::CoalescingBurstHeader ()
+{
+}
+
+CoalescingBurstHeader::~CoalescingBurstHeader ()
+{
+}
+
+TypeId
+CoalescingBurstHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoalescingBurstHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<CoalescingBurstHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+CoalescingBurstHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+CoalescingBurstHeader::Print (std::ostream &os) const
+{
+  os << "Coalesced burst of " << m_size.size () << " frames";
+}
+
+uint32_t
+CoalescingBurstHeader::GetSerializedSize (void) const
+{
+  // frame count, then size and offset of each frame
+  return 4 + m_size.size () * (4 + 8);
+}
+
+void
+CoalescingBurstHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU32 (m_size.size ());
+  for (std::size_t i = 0; i < m_size.size (); ++i)
+    {
+      start.WriteHtonU32 (m_size[i]);
+      start.WriteHtonU64 (m_offsetNs[i]);
+    }
+}
+
+uint32_t
+CoalescingBurstHeader::Deserialize (Buffer::Iterator start)
+{
+  uint32_t n = start.ReadNtohU32 ();
+  m_size.resize (n);
+  m_offsetNs.resize (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      m_size[i] = start.ReadNtohU32 ();
+      m_offsetNs[i] = start.ReadNtohU64 ();
+    }
+  return GetSerializedSize ();
+}
+
+void
+CoalescingBurstHeader::AddFrame (uint32_t size, Time rxOffset)
+{
+  NS_ASSERT (!rxOffset.IsStrictlyNegative ());
+  m_size.push_back (size);
+  m_offsetNs.push_back (rxOffset.GetNanoSeconds ());
+}
+
+uint32_t
+CoalescingBurstHeader::GetNFrames (void) const
+{
+  return m_size.size ();
+}
+
+uint32_t
+CoalescingBurstHeader::GetFrameSize (uint32_t i) const
+{
+  return m_size[i];
+}
+
+Time
+CoalescingBurstHeader::GetRxOffset (uint32_t i) const
+{
+  return NanoSeconds (m_offsetNs[i]);
+}
+
+} // namespace ns3
@@ -0,0 +1,103 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#ifndef COALESCING_BURST_HEADER_H
+#define COALESCING_BURST_HEADER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Header of a burst of frames sent to another system in one message
+ *
+ * The header lists the size of each frame and the time at which its last
+ * bit arrives, relative to the arrival of the first frame, which is the
+ * time of the message.  The frames follow the header in the same order,
+ * each serialized with Packet::Serialize, so that the receiving system
+ * rebuilds them with their uid, tags and metadata.
+ */
+class CoalescingBurstHeader : public Header
+{
+public:
+  /**
+   * \brief Construct an empty burst header.
+   */
+  CoalescingBurstHeader ();
+
+  /**
+   * \brief Destroy a burst header.
+   */
+  virtual ~CoalescingBurstHeader ();
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Get the TypeId of the instance
+   *
+   * \return The TypeId for this instance
+   */
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Append a frame
+   *
+   * \param size size of the serialized frame in bytes
+   * \param rxOffset arrival of the frame after the first one
+   */
+  void AddFrame (uint32_t size, Time rxOffset);
+
+  /**
+   * \return the number of frames
+   */
+  uint32_t GetNFrames (void) const;
+
+  /**
+   * \param i index of the frame
+   * \return the size of the serialized frame in bytes
+   */
+  uint32_t GetFrameSize (uint32_t i) const;
+
+  /**
+   * \param i index of the frame
+   * \return the arrival of the frame after the first one
+   */
+  Time GetRxOffset (uint32_t i) const;
+
+private:
+  std::vector<uint32_t> m_size;     //!< Serialized size of each frame
+  std::vector<uint64_t> m_offsetNs; //!< Arrival of each frame after the first, in nanoseconds
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_BURST_HEADER_H */
@@ -0,0 +1,96 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include "ns3/assert.h"
+#include "coalescing-energy-account.h"
+
+namespace ns3 {
+
+CoalescingEnergyAccount::CoalescingEnergyAccount (State state, Time now)
+  : m_state (state),
+    m_since (now)
+{
+  for (int i = 0; i < N_STATES; ++i)
+    {
+      m_residency[i] = Seconds (0);
+      m_entries[i] = 0;
+    }
+  m_entries[state] = 1;
+}
+
+void
+CoalescingEnergyAccount::SetState (State state, Time now)
+{
+  NS_ASSERT (now >= m_since);
+  if (state == m_state)
+    {
+      return;
+    }
+  m_residency[m_state] += now - m_since;
+  m_state = state;
+  m_since = now;
+  m_entries[state]++;
+}
+
+CoalescingEnergyAccount::State
+CoalescingEnergyAccount::GetState (void) const
+{
+  return m_state;
+}
+
+Time
+CoalescingEnergyAccount::GetResidency (State state, Time now) const
+{
+  if (state == m_state)
+    {
+      return m_residency[state] + (now - m_since);
+    }
+  return m_residency[state];
+}
+
+uint64_t
+CoalescingEnergyAccount::GetEntries (State state) const
+{
+  return m_entries[state];
+}
+
+double
+CoalescingEnergyAccount::GetEnergy (const double power[N_STATES], Time now) const
+{
+  double energy = 0;
+  for (int i = 0; i < N_STATES; ++i)
+    {
+      energy += power[i] * GetResidency (static_cast<State> (i), now).GetSeconds ();
+    }
+  return energy;
+}
+
+const char *
+CoalescingEnergyAccount::GetStateName (State state)
+{
+  switch (state)
+    {
+    case TRANSMIT: return "TRANSMIT";
+    case IDLE: return "IDLE";
+    case SLEEP: return "SLEEP";
+    case LOWPOWER: return "LOWPOWER";
+    case WAKEUP: return "WAKEUP";
+    default: return "UNKNOWN";
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,108 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_ENERGY_ACCOUNT_H
+#define COALESCING_ENERGY_ACCOUNT_H
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Time spent by an EEE port in each power state and its energy
+ *
+ * The account is told about every change of state and adds the time
+ * spent in the previous state to its residency, so each update costs
+ * the same regardless of the length of the run.  Residencies and energy
+ * can be queried at any time and include the time spent so far in the
+ * current state.  The power drawn is constant within a state, so the
+ * energy is exact.
+ */
+class CoalescingEnergyAccount
+{
+public:
+  /// Power states of an EEE port
+  enum State
+  {
+    TRANSMIT = 0, //!< Active and transmitting
+    IDLE,         //!< Active with nothing to transmit
+    SLEEP,        //!< Transition to low power
+    LOWPOWER,     //!< Low power
+    WAKEUP,       //!< Transition to active
+    N_STATES      //!< Number of states
+  };
+
+  /**
+   * \brief Create an account in the given state
+   *
+   * \param state Initial state
+   * \param now Current time
+   */
+  CoalescingEnergyAccount (State state, Time now);
+
+  /**
+   * \brief Change the current state
+   *
+   * \param state New state
+   * \param now Current time
+   */
+  void SetState (State state, Time now);
+
+  /**
+   * \return The current state
+   */
+  State GetState (void) const;
+
+  /**
+   * \param state The state
+   * \param now Current time
+   * \return The total time spent in the state
+   */
+  Time GetResidency (State state, Time now) const;
+
+  /**
+   * \param state The state
+   * \return The number of times the state was entered
+   */
+  uint64_t GetEntries (State state) const;
+
+  /**
+   * \param power Power drawn in each state, in watts or relative to the
+   * active power
+   * \param now Current time
+   * \return The energy consumed, the integral of the power of each state
+   * over the time spent in it
+   */
+  double GetEnergy (const double power[N_STATES], Time now) const;
+
+  /**
+   * \param state The state
+   * \return The name of the state
+   */
+  static const char * GetStateName (State state);
+
+private:
+  State m_state;                     //!< Current state
+  Time m_since;                      //!< Time at which the current state was entered
+  Time m_residency[N_STATES];        //!< Time spent in each state before the current interval
+  uint64_t m_entries[N_STATES];      //!< Number of times each state was entered
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_ENERGY_ACCOUNT_H */
@@ -0,0 +1,142 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cmath>
+#include "coalescing-measurement-aggregator.h"
+
+namespace ns3 {
+
+CoalescingWelford::CoalescingWelford ()
+  : m_n (0),
+    m_mean (0),
+    m_m2 (0)
+{
+}
+
+void
+CoalescingWelford::Add (double x)
+{
+  m_n++;
+  double delta = x - m_mean;
+  m_mean += delta / m_n;
+  m_m2 += delta * (x - m_mean);
+}
+
+uint64_t
+CoalescingWelford::GetCount (void) const
+{
+  return m_n;
+}
+
+double
+CoalescingWelford::GetMean (void) const
+{
+  return m_mean;
+}
+
+double
+CoalescingWelford::GetVariance (void) const
+{
+  return m_n > 0 ? m_m2 / m_n : 0;
+}
+
+double
+CoalescingWelford::GetMargin (double z) const
+{
+  return m_n > 0 ? z * std::sqrt (GetVariance () / m_n) : 0;
+}
+
+CoalescingMeasurementAggregator::CoalescingMeasurementAggregator (const std::vector<std::string> &names)
+  : m_names (names)
+{
+}
+
+CoalescingMeasurementAggregator::CoalescingMeasurementAggregator ()
+{
+  m_names.push_back ("eToff");
+  m_names.push_back ("packetCount");
+  m_names.push_back ("packetBytes");
+  m_names.push_back ("meanInterarrival");
+}
+
+void
+CoalescingMeasurementAggregator::Add (const Port &port, const std::vector<double> &values)
+{
+  std::vector<CoalescingWelford> &acc = m_ports[port];
+  acc.resize (m_names.size ());
+  for (std::size_t i = 0; i < acc.size () && i < values.size (); ++i)
+    {
+      acc[i].Add (values[i]);
+    }
+}
+
+bool
+CoalescingMeasurementAggregator::AddRecord (const CoalescingMeasurementRecord &r)
+{
+  if (r.packetCount == 0 || r.lpIntervals == 0)
+    {
+      return false;
+    }
+  std::vector<double> values (4);
+  values[0] = 1e-9 * r.lpTimeNs / r.lpIntervals;
+  values[1] = static_cast<double> (r.packetCount);
+  values[2] = static_cast<double> (r.packetBytes);
+  values[3] = r.meanInterarrival;
+  Add (Port (r.nodeId, r.ifIndex), values);
+  return true;
+}
+
+uint32_t
+CoalescingMeasurementAggregator::GetNPorts (void) const
+{
+  return m_ports.size ();
+}
+
+CoalescingWelford
+CoalescingMeasurementAggregator::Get (const Port &port, uint32_t quantity) const
+{
+  std::map<Port, std::vector<CoalescingWelford> >::const_iterator it = m_ports.find (port);
+  if (it == m_ports.end () || quantity >= it->second.size ())
+    {
+      return CoalescingWelford ();
+    }
+  return it->second[quantity];
+}
+
+void
+CoalescingMeasurementAggregator::Write (std::ostream &os, double z) const
+{
+  os << "# node port runs";
+  for (std::size_t i = 0; i < m_names.size (); ++i)
+    {
+      os << " " << m_names[i] << " " << m_names[i] << "Margin";
+    }
+  os << "\n";
+
+  for (std::map<Port, std::vector<CoalescingWelford> >::const_iterator it = m_ports.begin ();
+       it != m_ports.end (); ++it)
+    {
+      os << it->first.first << " " << it->first.second << " " << it->second[0].GetCount ();
+      for (std::size_t i = 0; i < it->second.size (); ++i)
+        {
+          os << " " << it->second[i].GetMean () << " " << it->second[i].GetMargin (z);
+        }
+      os << "\n";
+    }
+}
+
+} // namespace ns3
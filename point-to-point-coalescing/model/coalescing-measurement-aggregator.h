@@ -0,0 +1,141 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_MEASUREMENT_AGGREGATOR_H
+#define COALESCING_MEASUREMENT_AGGREGATOR_H
+
+#include <map>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "coalescing-measurement-format.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Running mean and variance of a sequence, by Welford's algorithm
+ */
+class CoalescingWelford
+{
+public:
+  CoalescingWelford ();
+
+  /**
+   * \param x next value of the sequence
+   */
+  void Add (double x);
+
+  /// \return the number of values
+  uint64_t GetCount (void) const;
+
+  /// \return the mean of the values
+  double GetMean (void) const;
+
+  /// \return the population variance of the values, as numpy.var
+  double GetVariance (void) const;
+
+  /**
+   * \param z quantile of the normal distribution, 2.33 for 98%
+   * \return the margin of error of the mean, z sigma / sqrt (n)
+   */
+  double GetMargin (double z) const;
+
+private:
+  uint64_t m_n;   //!< Number of values
+  double m_mean;  //!< Mean
+  double m_m2;    //!< Sum of squared differences from the mean
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Confidence intervals of per-port quantities over many runs
+ *
+ * Each run contributes one value of every quantity for every port.  The
+ * values are folded into running accumulators as they arrive, so memory
+ * depends only on the number of ports and quantities, and results can be
+ * written at any time.
+ */
+class CoalescingMeasurementAggregator
+{
+public:
+  /// Identifier of a port, node id and interface index
+  typedef std::pair<uint32_t, uint32_t> Port;
+
+  /**
+   * \param names names of the quantities
+   */
+  CoalescingMeasurementAggregator (const std::vector<std::string> &names);
+
+  /**
+   * \brief Aggregator of the quantities of measurement records
+   *
+   * The quantities are eToff (seconds), packetCount, packetBytes and
+   * meanInterarrival (seconds).
+   */
+  CoalescingMeasurementAggregator ();
+
+  /**
+   * \param port port of the values
+   * \param values one value of each quantity
+   */
+  void Add (const Port &port, const std::vector<double> &values);
+
+  /**
+   * \brief Fold a measurement record into the record quantities
+   *
+   * Records of ports which sent nothing or never went to low power are
+   * skipped.  Only valid with the default constructor.
+   *
+   * \param r measurement record
+   * \return true if the record was used
+   */
+  bool AddRecord (const CoalescingMeasurementRecord &r);
+
+  /// \return the number of ports
+  uint32_t GetNPorts (void) const;
+
+  /**
+   * \param port port
+   * \param quantity index of the quantity
+   * \return the accumulator, or an empty one if the port is unknown
+   */
+  CoalescingWelford Get (const Port &port, uint32_t quantity) const;
+
+  /**
+   * \brief Write the results of all ports
+   *
+   * A first line starting with # names the columns.  Every port has one
+   * line with its node id, interface index, number of runs and the mean
+   * and margin of error of each quantity.
+   *
+   * \param os output stream
+   * \param z quantile of the normal distribution, 2.33 for 98%
+   */
+  void Write (std::ostream &os, double z) const;
+
+private:
+  std::vector<std::string> m_names;                           //!< Names of the quantities
+  std::map<Port, std::vector<CoalescingWelford> > m_ports;    //!< Accumulators of each port
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_MEASUREMENT_AGGREGATOR_H */
@@ -0,0 +1,357 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_MEASUREMENT_FORMAT_H
+#define COALESCING_MEASUREMENT_FORMAT_H
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Measurements of one coalescing device at the end of a run
+ */
+struct CoalescingMeasurementRecord
+{
+  uint32_t nodeId;             //!< Id of the node of the device
+  uint32_t ifIndex;            //!< Interface index of the device
+  double lpTimeNs;             //!< Time spent in low power, in nanoseconds
+  uint64_t lpIntervals;        //!< Number of low power intervals counted in lpTimeNs
+  uint64_t packetCount;        //!< Number of transmitted packets
+  uint64_t packetBytes;        //!< Number of transmitted bytes
+  double meanInterarrival;     //!< Mean packet interarrival time, in seconds
+  uint64_t dataRate;           //!< Data rate of the device, in bit/s
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Binary file format of the coalescing measurements
+ *
+ * A file starts with a header which describes its columns:
+ *
+ * - the magic string "EEEMEAS" and a terminating zero byte,
+ * - the format version as uint32,
+ * - the number of columns as uint32,
+ * - for each column its type code as uint8, the length of its name as
+ *   uint8 and the name without terminating zero.
+ *
+ * Records follow the header, one per device, with the columns packed in
+ * header order and without padding.  All numbers are little-endian and
+ * doubles are IEEE 754.  ReadHeader looks the columns up by name and
+ * ReadRecord skips those it does not know, so that columns can be added
+ * in later versions without breaking older readers.  A file must still
+ * have every column of CoalescingMeasurementRecord, with its type.
+ */
+class CoalescingMeasurementFormat
+{
+public:
+  /// Type codes of the columns
+  enum ColumnType
+  {
+    UINT32 = 1,
+    UINT64 = 2,
+    DOUBLE = 3
+  };
+
+  /// Description of a column
+  struct Column
+  {
+    const char *name; //!< Name of the column
+    ColumnType type;  //!< Type of the column
+  };
+
+  /// Columns of a file, as read from its header
+  struct Layout
+  {
+    std::vector<int> field;           //!< Column of this version in each column of the file, -1 if unknown
+    std::vector<ColumnType> type;     //!< Type of each column of the file
+  };
+
+  /// Version of the format written by this header
+  static const uint32_t VERSION = 1;
+
+  /**
+   * \return The magic string at the start of a file, 8 bytes with the terminating zero
+   */
+  static const char *GetMagic (void)
+  {
+    return "EEEMEAS";
+  }
+
+  /**
+   * \return The number of columns of a record
+   */
+  static uint32_t GetNColumns (void)
+  {
+    return 8;
+  }
+
+  /**
+   * \param i Index of the column
+   * \return The description of the column
+   */
+  static const Column &GetColumn (uint32_t i)
+  {
+    static const Column columns[] = {
+      { "nodeId", UINT32 },
+      { "ifIndex", UINT32 },
+      { "lpTimeNs", DOUBLE },
+      { "lpIntervals", UINT64 },
+      { "packetCount", UINT64 },
+      { "packetBytes", UINT64 },
+      { "meanInterarrival", DOUBLE },
+      { "dataRate", UINT64 }
+    };
+    return columns[i];
+  }
+
+  /**
+   * \return The size of a record in bytes
+   */
+  static uint32_t GetRecordSize (void)
+  {
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < GetNColumns (); ++i)
+      {
+        size += GetColumn (i).type == UINT32 ? 4 : 8;
+      }
+    return size;
+  }
+
+  /**
+   * \brief Write the file header
+   * \param os Output stream
+   */
+  static void WriteHeader (std::ostream &os)
+  {
+    os.write (GetMagic (), 8);
+    WriteU32 (os, VERSION);
+    WriteU32 (os, GetNColumns ());
+    for (uint32_t i = 0; i < GetNColumns (); ++i)
+      {
+        const Column &c = GetColumn (i);
+        uint8_t len = static_cast<uint8_t> (std::strlen (c.name));
+        os.put (static_cast<char> (c.type));
+        os.put (static_cast<char> (len));
+        os.write (c.name, len);
+      }
+  }
+
+  /**
+   * \brief Write one record
+   * \param os Output stream
+   * \param r Record to write
+   */
+  static void WriteRecord (std::ostream &os, const CoalescingMeasurementRecord &r)
+  {
+    WriteU32 (os, r.nodeId);
+    WriteU32 (os, r.ifIndex);
+    WriteDouble (os, r.lpTimeNs);
+    WriteU64 (os, r.lpIntervals);
+    WriteU64 (os, r.packetCount);
+    WriteU64 (os, r.packetBytes);
+    WriteDouble (os, r.meanInterarrival);
+    WriteU64 (os, r.dataRate);
+  }
+
+  /**
+   * \brief Read the file header
+   *
+   * \param is Input stream
+   * \param layout Columns of the file, filled in
+   * \return true if the file has all columns of this version
+   */
+  static bool ReadHeader (std::istream &is, Layout &layout)
+  {
+    char magic[8];
+    is.read (magic, 8);
+    if (!is || std::memcmp (magic, GetMagic (), 8) != 0)
+      {
+        return false;
+      }
+    uint32_t version = ReadU32 (is);
+    uint32_t n = ReadU32 (is);
+    if (!is || version < 1)
+      {
+        return false;
+      }
+    layout.field.clear ();
+    layout.type.clear ();
+    std::vector<bool> found (GetNColumns (), false);
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        int type = is.get ();
+        int len = is.get ();
+        if (!is || (type != UINT32 && type != UINT64 && type != DOUBLE))
+          {
+            return false;
+          }
+        std::string name (static_cast<std::size_t> (len), '\0');
+        is.read (&name[0], len);
+        if (!is)
+          {
+            return false;
+          }
+        int field = -1;
+        for (uint32_t j = 0; j < GetNColumns (); ++j)
+          {
+            if (name == GetColumn (j).name)
+              {
+                if (type != GetColumn (j).type || found[j])
+                  {
+                    return false;
+                  }
+                field = j;
+                found[j] = true;
+              }
+          }
+        layout.field.push_back (field);
+        layout.type.push_back (static_cast<ColumnType> (type));
+      }
+    for (uint32_t j = 0; j < GetNColumns (); ++j)
+      {
+        if (!found[j])
+          {
+            return false;
+          }
+      }
+    return true;
+  }
+
+  /**
+   * \brief Read one record
+   *
+   * \param is Input stream positioned after the header
+   * \param layout Columns of the file, as read by ReadHeader
+   * \param r Record to fill
+   * \return false at the end of the file
+   */
+  static bool ReadRecord (std::istream &is, const Layout &layout, CoalescingMeasurementRecord &r)
+  {
+    r = CoalescingMeasurementRecord ();
+    for (std::size_t i = 0; i < layout.field.size (); ++i)
+      {
+        uint64_t v = layout.type[i] == UINT32 ? ReadU32 (is) : ReadU64 (is);
+        switch (layout.field[i])
+          {
+          case 0:
+            r.nodeId = static_cast<uint32_t> (v);
+            break;
+          case 1:
+            r.ifIndex = static_cast<uint32_t> (v);
+            break;
+          case 2:
+            r.lpTimeNs = ToDouble (v);
+            break;
+          case 3:
+            r.lpIntervals = v;
+            break;
+          case 4:
+            r.packetCount = v;
+            break;
+          case 5:
+            r.packetBytes = v;
+            break;
+          case 6:
+            r.meanInterarrival = ToDouble (v);
+            break;
+          case 7:
+            r.dataRate = v;
+            break;
+          default:
+            // a column of a later version
+            break;
+          }
+      }
+    return static_cast<bool> (is);
+  }
+
+private:
+  /// Write v as little-endian
+  static void WriteU32 (std::ostream &os, uint32_t v)
+  {
+    char b[4];
+    for (int i = 0; i < 4; ++i)
+      {
+        b[i] = static_cast<char> ((v >> (8 * i)) & 0xff);
+      }
+    os.write (b, 4);
+  }
+
+  /// Write v as little-endian
+  static void WriteU64 (std::ostream &os, uint64_t v)
+  {
+    char b[8];
+    for (int i = 0; i < 8; ++i)
+      {
+        b[i] = static_cast<char> ((v >> (8 * i)) & 0xff);
+      }
+    os.write (b, 8);
+  }
+
+  /// Write v as little-endian IEEE 754
+  static void WriteDouble (std::ostream &os, double v)
+  {
+    uint64_t u;
+    std::memcpy (&u, &v, sizeof (u));
+    WriteU64 (os, u);
+  }
+
+  /// \return Little-endian value read from is
+  static uint32_t ReadU32 (std::istream &is)
+  {
+    unsigned char b[4] = { 0, 0, 0, 0 };
+    is.read (reinterpret_cast<char *> (b), 4);
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i)
+      {
+        v = (v << 8) | b[i];
+      }
+    return v;
+  }
+
+  /// \return Little-endian value read from is
+  static uint64_t ReadU64 (std::istream &is)
+  {
+    unsigned char b[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    is.read (reinterpret_cast<char *> (b), 8);
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+      {
+        v = (v << 8) | b[i];
+      }
+    return v;
+  }
+
+  /// \return IEEE 754 value with the bits of u
+  static double ToDouble (uint64_t u)
+  {
+    double v;
+    std::memcpy (&v, &u, sizeof (v));
+    return v;
+  }
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_MEASUREMENT_FORMAT_H */
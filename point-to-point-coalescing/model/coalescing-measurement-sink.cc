@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cstdio>
+#include <vector>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/mpi-interface.h"
+#include "coalescing-measurement-sink.h"
+#include "coalescing-partition-interface.h"
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingMeasurementSink");
+
+NS_OBJECT_ENSURE_REGISTERED (CoalescingMeasurementSink);
+
+TypeId
+CoalescingMeasurementSink::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoalescingMeasurementSink")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<CoalescingMeasurementSink> ()
+    .AddAttribute ("OutputPath",
+                   "Path of the binary file the measurements are written to",
+                   StringValue ("data.bin"),
+                   MakeStringAccessor (&CoalescingMeasurementSink::m_outputPath),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+CoalescingMeasurementSink::CoalescingMeasurementSink ()
+  : m_nRecords (0),
+    m_nLocal (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CoalescingMeasurementSink::~CoalescingMeasurementSink ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CoalescingMeasurementSink::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  // gathering needs all systems, which do not dispose their sinks together
+  if (m_nLocal > 0)
+    {
+      NS_LOG_WARN ("Dropping " << m_nLocal << " measurement records which were not gathered");
+    }
+  if (m_file.is_open ())
+    {
+      Close ();
+    }
+  Object::DoDispose ();
+}
+
+void
+CoalescingMeasurementSink::Open (void)
+{
+  NS_LOG_FUNCTION (this << m_outputPath);
+
+  //
+  // A sink that is written to again after Close () appends to its file
+  // instead of starting a new one.
+  //
+  std::ios::openmode mode = std::ios::out | std::ios::binary;
+  mode |= m_nRecords == 0 ? std::ios::trunc : std::ios::app;
+  m_file.open (m_outputPath.c_str (), mode);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "Cannot open measurement file " << m_outputPath);
+  if (m_nRecords == 0)
+    {
+      CoalescingMeasurementFormat::WriteHeader (m_file);
+    }
+}
+
+void
+CoalescingMeasurementSink::Write (const CoalescingMeasurementRecord &record)
+{
+  NS_LOG_FUNCTION (this << record.nodeId << record.ifIndex);
+  if (IsDistributed ())
+    {
+      CoalescingMeasurementFormat::WriteRecord (m_local, record);
+      m_nLocal++;
+      return;
+    }
+  if (!m_file.is_open ())
+    {
+      Open ();
+    }
+  CoalescingMeasurementFormat::WriteRecord (m_file, record);
+  m_nRecords++;
+}
+
+void
+CoalescingMeasurementSink::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (IsDistributed ())
+    {
+      Gather ();
+    }
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+      NS_LOG_LOGIC ("Wrote " << m_nRecords << " records to " << m_outputPath);
+    }
+}
+
+bool
+CoalescingMeasurementSink::IsDistributed (void)
+{
+  return MpiInterface::IsEnabled () || CoalescingPartitionInterface::IsEnabled ();
+}
+
+void
+CoalescingMeasurementSink::Gather (void)
+{
+  NS_LOG_FUNCTION (this << m_nLocal);
+
+  std::string local = m_local.str ();
+  m_local.str ("");
+  uint64_t nLocal = m_nLocal;
+  m_nLocal = 0;
+
+  if (MpiInterface::IsEnabled ())
+    {
+#ifdef NS3_MPI
+      uint32_t rank = MpiInterface::GetSystemId ();
+      uint32_t n = MpiInterface::GetSize ();
+      // the number of records is sent along with the bytes
+      uint64_t counts[2] = { nLocal, local.size () };
+      std::vector<uint64_t> all (2 * n);
+      MPI_Gather (counts, 2, MPI_UINT64_T, &all[0], 2, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+      std::vector<int> sizes (n);
+      std::vector<int> displacements (n);
+      int total = 0;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          sizes[i] = static_cast<int> (all[2 * i + 1]);
+          displacements[i] = total;
+          total += sizes[i];
+        }
+      std::vector<char> records (total + 1);
+      MPI_Gatherv (const_cast<char *> (local.data ()), local.size (), MPI_CHAR,
+                   &records[0], &sizes[0], &displacements[0], MPI_CHAR, 0, MPI_COMM_WORLD);
+
+      if (rank == 0)
+        {
+          if (!m_file.is_open ())
+            {
+              Open ();
+            }
+          m_file.write (&records[0], total);
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              m_nRecords += all[2 * i];
+            }
+        }
+      else
+        {
+          m_nRecords += nLocal;
+        }
+#else
+      NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+      return;
+    }
+
+  //
+  // Partitions write their records to a shard next to the output file,
+  // which partition 0 appends to the file once all shards are complete.
+  //
+  uint32_t partition = CoalescingPartitionInterface::GetPartition ();
+  uint32_t n = CoalescingPartitionInterface::GetNPartitions ();
+  if (partition != 0)
+    {
+      std::string path = GetSystemPath (m_outputPath);
+      std::ofstream shard (path.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+      NS_ABORT_MSG_UNLESS (shard.is_open (), "Cannot open measurement shard " << path);
+      shard.write (local.data (), local.size ());
+      shard.close ();
+      m_nRecords += nLocal;
+    }
+  CoalescingPartitionInterface::Barrier ();
+  if (partition != 0)
+    {
+      return;
+    }
+
+  if (!m_file.is_open ())
+    {
+      Open ();
+    }
+  m_file.write (local.data (), local.size ());
+  m_nRecords += nLocal;
+  for (uint32_t i = 1; i < n; ++i)
+    {
+      std::ostringstream path;
+      path << m_outputPath << "." << i;
+      std::ifstream shard (path.str ().c_str (), std::ios::in | std::ios::binary);
+      NS_ABORT_MSG_UNLESS (shard.is_open (), "Cannot open measurement shard " << path.str ());
+      std::ostringstream records;
+      records << shard.rdbuf ();
+      shard.close ();
+      std::remove (path.str ().c_str ());
+
+      std::string bytes = records.str ();
+      m_file.write (bytes.data (), bytes.size ());
+      m_nRecords += bytes.size () / CoalescingMeasurementFormat::GetRecordSize ();
+    }
+}
+
+uint64_t
+CoalescingMeasurementSink::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+std::string
+CoalescingMeasurementSink::GetSystemPath (std::string path)
+{
+  std::ostringstream os;
+  os << path;
+  if (CoalescingPartitionInterface::IsEnabled ())
+    {
+      os << "." << CoalescingPartitionInterface::GetPartition ();
+    }
+  else if (MpiInterface::IsEnabled ())
+    {
+      os << "." << MpiInterface::GetSystemId ();
+    }
+  return os.str ();
+}
+
+} // namespace ns3
@@ -0,0 +1,127 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_MEASUREMENT_SINK_H
+#define COALESCING_MEASUREMENT_SINK_H
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "ns3/object.h"
+#include "coalescing-measurement-format.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Writer of the coalescing measurements of a run
+ *
+ * One sink is created per run and the measurements of all devices are
+ * written to it.  The output file is opened when the first record is
+ * written and stays open until the sink is closed or disposed, so the
+ * file is opened once regardless of the number of devices.
+ *
+ * In a distributed or partitioned run each system keeps the records of
+ * its devices in memory until the sink is closed.  Close is then
+ * collective: the records of all systems are gathered, in the order of the
+ * systems, into the file of system 0, and the other systems write nothing.
+ * Every system must close its sink, and records which are not gathered
+ * when the sink is disposed are dropped.
+ *
+ * \see CoalescingMeasurementFormat
+ */
+class CoalescingMeasurementSink : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Construct a CoalescingMeasurementSink
+   */
+  CoalescingMeasurementSink ();
+
+  /**
+   * \brief Destroy a CoalescingMeasurementSink
+   */
+  virtual ~CoalescingMeasurementSink ();
+
+  /**
+   * \brief Append a record to the output file
+   *
+   * \param record Measurements of a device
+   */
+  void Write (const CoalescingMeasurementRecord &record);
+
+  /**
+   * \brief Flush and close the output file, or gather the records of all
+   * systems in a distributed run
+   */
+  void Close (void);
+
+  /**
+   * \return The number of records written, in a distributed run the
+   * number of records of all systems in system 0 and of its own records
+   * in the other systems
+   */
+  uint64_t GetNRecords (void) const;
+
+  /**
+   * \brief Get the path of the output of this system
+   *
+   * Outputs which are not gathered are written by each system of a
+   * distributed or partitioned run to its own file.
+   *
+   * \param path Path of the output of the whole run
+   * \return path followed by "." and the system id in a distributed or
+   * partitioned run, path otherwise
+   */
+  static std::string GetSystemPath (std::string path);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Open the output file and write the header
+   */
+  void Open (void);
+
+  /**
+   * \return true in a distributed or partitioned run
+   */
+  static bool IsDistributed (void);
+
+  /**
+   * \brief Write the records of all systems to the file of system 0
+   */
+  void Gather (void);
+
+  std::string m_outputPath;  //!< Path of the output file
+  std::ofstream m_file;      //!< Output file
+  uint64_t m_nRecords;       //!< Number of records written
+  std::ostringstream m_local; //!< Records of this system not yet gathered
+  uint64_t m_nLocal;         //!< Number of records not yet gathered
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_MEASUREMENT_SINK_H */
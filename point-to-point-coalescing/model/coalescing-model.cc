@@ -0,0 +1,438 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cmath>
+#include "coalescing-model.h"
+
+namespace ns3 {
+
+CoalescingModel::Parameters
+CoalescingModel::GetDefaultParameters (void)
+{
+  Parameters p;
+  p.policy = CoalescingPolicy::BYTE_LIMIT;
+  p.limits.byteLimit = 24000;
+  p.limits.packetLimit = 16;
+  p.limits.lowByteLimit = 0;
+  p.timeout = 800;
+  p.sleepTime = 2.88;
+  p.wakeUpTime = 4.48;
+  p.dataRate = 10000000000ULL;
+  p.interframeGapNs = 0;
+  p.burstTransmit = true;
+  p.power[TRANSMIT] = 1.0;
+  p.power[IDLE] = 1.0;
+  p.power[SLEEP] = 1.0;
+  p.power[LOWPOWER] = 0.1;
+  p.power[WAKEUP] = 1.0;
+  return p;
+}
+
+CoalescingModel::CoalescingModel (const Parameters &p)
+  : m_p (p),
+    m_timeoutNs (std::llround (p.timeout * 1000)),
+    m_sleepNs (std::llround (p.sleepTime * 1000)),
+    m_wakeUpNs (std::llround (p.wakeUpTime * 1000)),
+    m_now (0),
+    m_state (LOW_POWER),
+    m_busy (false),
+    m_sleepAt (NEVER),
+    m_timerAt (NEVER),
+    m_wakeUpAt (NEVER),
+    m_txAt (NEVER),
+    m_queueBytes (0),
+    m_queuePackets (0),
+    m_queueTxNs (0),
+    m_queue (64),
+    m_head (0),
+    m_queueArrivalNs (0),
+    m_queueOffsetNs (0),
+    m_lowPowerStart (0),
+    m_lpTimeNs (0),
+    m_lpIntervals (0),
+    m_packetCount (0),
+    m_packetBytes (0),
+    m_sumInterarrivalNs (0),
+    m_delayNs (0),
+    m_lastArrivalNs (0),
+    m_nEvents (0),
+    m_powerState (LOWPOWER),
+    m_powerSince (0)
+{
+  for (int i = 0; i < N_POWER_STATES; ++i)
+    {
+      m_residency[i] = 0;
+    }
+}
+
+const CoalescingModel::Parameters &
+CoalescingModel::GetParameters (void) const
+{
+  return m_p;
+}
+
+void
+CoalescingModel::Arrival (uint64_t timeNs, uint32_t size)
+{
+  Advance (timeNs);
+  m_now = timeNs;
+  m_nEvents++;
+
+  // as Send of the device
+  CheckTimer ();
+
+  if (m_lastArrivalNs > 0)
+    {
+      m_sumInterarrivalNs += timeNs - m_lastArrivalNs;
+    }
+  m_lastArrivalNs = timeNs;
+
+  if (!m_p.burstTransmit)
+    {
+      if (m_queuePackets == m_queue.size ())
+        {
+          // grow the ring, moving the wrapped part after the old end
+          std::size_t n = m_queue.size ();
+          m_queue.resize (2 * n);
+          for (std::size_t i = 0; i < m_head; ++i)
+            {
+              m_queue[n + i] = m_queue[i];
+            }
+        }
+      QueuedPacket &packet = m_queue[(m_head + m_queuePackets) & (m_queue.size () - 1)];
+      packet.size = size;
+      packet.arrivalNs = timeNs;
+    }
+  else
+    {
+      // the packet starts after the packets queued before it in the burst
+      m_queueOffsetNs += m_queueTxNs;
+      m_queueArrivalNs += timeNs;
+    }
+  m_queueBytes += size;
+  m_queuePackets++;
+  m_queueTxNs += GetTxNs (size);
+
+  QueueLimit ();
+  if (m_state == SEND && !m_busy)
+    {
+      Transmit ();
+    }
+}
+
+void
+CoalescingModel::Finish (uint64_t endNs)
+{
+  Advance (endNs);
+  if (endNs > m_now)
+    {
+      m_now = endNs;
+    }
+  UpdatePowerState ();
+}
+
+void
+CoalescingModel::Advance (uint64_t t)
+{
+  for (;;)
+    {
+      uint64_t next = m_sleepAt;
+      next = m_timerAt < next ? m_timerAt : next;
+      next = m_wakeUpAt < next ? m_wakeUpAt : next;
+      next = m_txAt < next ? m_txAt : next;
+      if (next > t)
+        {
+          return;
+        }
+      m_now = next;
+      m_nEvents++;
+
+      //
+      // The sleep transition and the timer are the only events that can be
+      // due at the same time, and the device schedules the sleep first.
+      //
+      if (m_sleepAt == next)
+        {
+          m_sleepAt = NEVER;
+          SleepEnd ();
+        }
+      else if (m_txAt == next)
+        {
+          m_txAt = NEVER;
+          TransmitComplete ();
+        }
+      else if (m_wakeUpAt == next)
+        {
+          m_wakeUpAt = NEVER;
+          WakeUpEnd ();
+        }
+      else
+        {
+          m_timerAt = NEVER;
+          TimeOut ();
+        }
+    }
+}
+
+uint64_t
+CoalescingModel::GetTxNs (uint32_t size) const
+{
+  return static_cast<uint64_t> (size) * 8000000000ULL / m_p.dataRate + m_p.interframeGapNs;
+}
+
+bool
+CoalescingModel::WakeUpDue (void) const
+{
+  switch (m_p.policy)
+    {
+    case CoalescingPolicy::TIMER_ONLY:
+      return CoalescingTimerOnlyPolicy::WakeUp (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::PACKET_COUNT:
+      return CoalescingPacketCountPolicy::WakeUp (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::HYBRID:
+      return CoalescingHybridPolicy::WakeUp (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::HYSTERESIS:
+      return CoalescingHysteresisPolicy::WakeUp (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::BYTE_LIMIT:
+    default:
+      return CoalescingByteLimitPolicy::WakeUp (m_p.limits, m_queueBytes, m_queuePackets);
+    }
+}
+
+bool
+CoalescingModel::SleepDue (void) const
+{
+  switch (m_p.policy)
+    {
+    case CoalescingPolicy::TIMER_ONLY:
+      return CoalescingTimerOnlyPolicy::Sleep (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::PACKET_COUNT:
+      return CoalescingPacketCountPolicy::Sleep (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::HYBRID:
+      return CoalescingHybridPolicy::Sleep (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::HYSTERESIS:
+      return CoalescingHysteresisPolicy::Sleep (m_p.limits, m_queueBytes, m_queuePackets);
+    case CoalescingPolicy::BYTE_LIMIT:
+    default:
+      return CoalescingByteLimitPolicy::Sleep (m_p.limits, m_queueBytes, m_queuePackets);
+    }
+}
+
+void
+CoalescingModel::CheckTimer (void)
+{
+  // the first packet of a low-power cycle starts the timer
+  if (m_queueBytes == 0 && m_timerAt == NEVER
+      && (m_state == SLEEPING || m_state == LOW_POWER))
+    {
+      m_timerAt = m_now + m_timeoutNs;
+    }
+}
+
+void
+CoalescingModel::QueueLimit (void)
+{
+  if (m_state == LOW_POWER && WakeUpDue ())
+    {
+      m_state = WAKING_UP;
+      UpdatePowerState ();
+      m_timerAt = NEVER;
+      m_wakeUpAt = m_now + m_wakeUpNs;
+    }
+}
+
+void
+CoalescingModel::QueueEmptied (void)
+{
+  m_state = SLEEPING;
+  UpdatePowerState ();
+  m_sleepAt = m_now + m_sleepNs;
+  // packets left by the policy are the first of the next cycle
+  m_timerAt = m_queuePackets > 0 ? m_now + m_timeoutNs : NEVER;
+}
+
+void
+CoalescingModel::TimeOut (void)
+{
+  if (m_state == LOW_POWER)
+    {
+      m_state = WAKING_UP;
+      UpdatePowerState ();
+      m_wakeUpAt = m_now + m_wakeUpNs;
+    }
+}
+
+void
+CoalescingModel::SleepEnd (void)
+{
+  if (m_state == SLEEPING)
+    {
+      m_state = LOW_POWER;
+      UpdatePowerState ();
+      m_lowPowerStart = m_now;
+    }
+}
+
+void
+CoalescingModel::WakeUpEnd (void)
+{
+  if (m_state != WAKING_UP)
+    {
+      return;
+    }
+  m_state = SEND;
+  UpdatePowerState ();
+
+  if (m_lpIntervals > 0)
+    {
+      m_lpTimeNs += m_now - m_lowPowerStart;
+    }
+  m_lpIntervals++;
+
+  if (m_queuePackets == 0)
+    {
+      QueueEmptied ();
+      return;
+    }
+  Transmit ();
+}
+
+void
+CoalescingModel::TransmitComplete (void)
+{
+  m_busy = false;
+  UpdatePowerState ();
+  if (SleepDue ())
+    {
+      QueueEmptied ();
+      return;
+    }
+  Transmit ();
+}
+
+void
+CoalescingModel::Transmit (void)
+{
+  m_busy = true;
+  UpdatePowerState ();
+  if (m_p.burstTransmit)
+    {
+      // the whole queue back to back
+      m_txAt = m_now + m_queueTxNs;
+      m_delayNs += static_cast<double> (m_queuePackets) * m_now + m_queueOffsetNs - m_queueArrivalNs;
+      m_packetCount += m_queuePackets;
+      m_packetBytes += m_queueBytes;
+      m_queueBytes = 0;
+      m_queuePackets = 0;
+      m_queueTxNs = 0;
+      m_queueArrivalNs = 0;
+      m_queueOffsetNs = 0;
+      return;
+    }
+  uint32_t size = m_queue[m_head].size;
+  m_delayNs += m_now - m_queue[m_head].arrivalNs;
+  m_head = (m_head + 1) & (m_queue.size () - 1);
+  uint64_t txNs = GetTxNs (size);
+  m_txAt = m_now + txNs;
+  m_packetCount++;
+  m_packetBytes += size;
+  m_queueBytes -= size;
+  m_queuePackets--;
+  m_queueTxNs -= txNs;
+}
+
+void
+CoalescingModel::UpdatePowerState (void)
+{
+  PowerState state = LOWPOWER;
+  switch (m_state)
+    {
+    case SEND:
+      state = m_busy ? TRANSMIT : IDLE;
+      break;
+    case SLEEPING:
+      state = SLEEP;
+      break;
+    case LOW_POWER:
+      state = LOWPOWER;
+      break;
+    case WAKING_UP:
+      state = WAKEUP;
+      break;
+    }
+  m_residency[m_powerState] += m_now - m_powerSince;
+  m_powerState = state;
+  m_powerSince = m_now;
+}
+
+CoalescingMeasurementRecord
+CoalescingModel::GetMeasurementRecord (uint32_t nodeId, uint32_t ifIndex) const
+{
+  CoalescingMeasurementRecord r;
+  r.nodeId = nodeId;
+  r.ifIndex = ifIndex;
+  r.lpTimeNs = m_lpTimeNs;
+  r.lpIntervals = m_lpIntervals > 0 ? m_lpIntervals - 1 : 0;
+  r.packetCount = m_packetCount;
+  r.packetBytes = m_packetBytes;
+  r.meanInterarrival = m_packetCount > 1 ? m_sumInterarrivalNs / 1e9 / (m_packetCount - 1) : 0;
+  r.dataRate = m_p.dataRate;
+  return r;
+}
+
+double
+CoalescingModel::GetResidency (PowerState state) const
+{
+  return 1e-9 * m_residency[state];
+}
+
+double
+CoalescingModel::GetEnergy (void) const
+{
+  double energy = 0;
+  for (int i = 0; i < N_POWER_STATES; ++i)
+    {
+      energy += m_p.power[i] * GetResidency (static_cast<PowerState> (i));
+    }
+  return energy;
+}
+
+double
+CoalescingModel::GetEnergyWithoutEee (void) const
+{
+  double total = 0;
+  for (int i = 0; i < N_POWER_STATES; ++i)
+    {
+      total += GetResidency (static_cast<PowerState> (i));
+    }
+  double transmit = GetResidency (TRANSMIT);
+  return m_p.power[TRANSMIT] * transmit + m_p.power[IDLE] * (total - transmit);
+}
+
+uint64_t
+CoalescingModel::GetNEvents (void) const
+{
+  return m_nEvents;
+}
+
+double
+CoalescingModel::GetMeanDelay (void) const
+{
+  return m_packetCount > 0 ? 1e-9 * m_delayNs / m_packetCount : 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,214 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_MODEL_H
+#define COALESCING_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "coalescing-policy.h"
+#include "coalescing-measurement-format.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Coalescing state machine of one port, without ns-3
+ *
+ * The model makes the same transitions as PointToPointCoalescingNetDevice
+ * for a given sequence of packet arrivals at Send: it sleeps when the
+ * policy lets it after a transmission, goes to low power after the sleep
+ * time, starts the coalescing timer with the first packet of a cycle,
+ * wakes up on the timer or when the policy asks for it, and transmits
+ * packet by packet or in bursts.  Its pending events are kept as four times,
+ * one per kind of event of the device, so an arrival costs a few comparisons
+ * and no allocation.
+ *
+ * Times are integer nanoseconds, as in the example, which sets the time
+ * resolution of ns-3 to nanoseconds.  The transmission time of a packet is
+ * rounded down to a nanosecond.  Internal events due at the time of an
+ * arrival are processed before it.  The transmit queue has no limit, so
+ * the replay of a trace recorded with drops at Send does not drop them.
+ */
+class CoalescingModel
+{
+public:
+  /// Power states, as those of CoalescingEnergyAccount
+  enum PowerState
+  {
+    TRANSMIT = 0,
+    IDLE,
+    SLEEP,
+    LOWPOWER,
+    WAKEUP,
+    N_POWER_STATES
+  };
+
+  /// Parameters of the port, with the names of the device attributes
+  struct Parameters
+  {
+    CoalescingPolicy::Type policy;      //!< CoalescingPolicy
+    CoalescingPolicy::Parameters limits; //!< EeeByteLimit, EeePacketLimit and EeeLowByteLimit
+    double timeout;                     //!< EeeCoalescingTimeout, in microseconds
+    double sleepTime;                   //!< EeeSleepTime, in microseconds
+    double wakeUpTime;                  //!< EeeWakeUpTime, in microseconds
+    uint64_t dataRate;                  //!< DataRate, in bit/s
+    uint64_t interframeGapNs;           //!< InterframeGap, in nanoseconds
+    bool burstTransmit;                 //!< BurstTransmit
+    double power[N_POWER_STATES];       //!< EeePower* of each power state
+  };
+
+  /**
+   * \return the default attribute values of the device, at 10 Gbps and
+   * with BurstTransmit as in the example
+   */
+  static Parameters GetDefaultParameters (void);
+
+  /**
+   * \param p parameters of the port
+   */
+  CoalescingModel (const Parameters &p);
+
+  /// \return the parameters of the port
+  const Parameters &GetParameters (void) const;
+
+  /**
+   * \brief Process the events due until a packet arrives, and the arrival
+   *
+   * \param timeNs time of the arrival, not earlier than the previous one
+   * \param size size of the packet in bytes, with its PPP header
+   */
+  void Arrival (uint64_t timeNs, uint32_t size);
+
+  /**
+   * \brief Process the events due until the end of the run
+   *
+   * \param endNs time at which the run ends
+   */
+  void Finish (uint64_t endNs);
+
+  /**
+   * \param nodeId node id of the record
+   * \param ifIndex interface index of the record
+   * \return the measurements of the port, as
+   * PointToPointCoalescingNetDeviceBase::GetMeasurementRecord
+   */
+  CoalescingMeasurementRecord GetMeasurementRecord (uint32_t nodeId, uint32_t ifIndex) const;
+
+  /**
+   * \param state power state
+   * \return the time spent in the state until the last event, in seconds
+   */
+  double GetResidency (PowerState state) const;
+
+  /// \return the energy consumed according to the power profile
+  double GetEnergy (void) const;
+
+  /// \return the energy consumed if the port never went to low power
+  double GetEnergyWithoutEee (void) const;
+
+  /// \return the number of events processed, arrivals included
+  uint64_t GetNEvents (void) const;
+
+  /**
+   * \return the mean time from the arrival of a packet to the start of
+   * its transmission, in seconds
+   */
+  double GetMeanDelay (void) const;
+
+private:
+  /// Coalescing states, as those of the device
+  enum State
+  {
+    SEND,
+    SLEEPING,
+    LOW_POWER,
+    WAKING_UP
+  };
+
+  /// Packet in the transmit queue
+  struct QueuedPacket
+  {
+    uint32_t size;             //!< Size in bytes
+    uint64_t arrivalNs;        //!< Time of the arrival
+  };
+
+  /// Time of an event that is not scheduled
+  static const uint64_t NEVER = ~static_cast<uint64_t> (0);
+
+  /// Processes the events due at or before t
+  void Advance (uint64_t t);
+
+  /// \return the transmission time of a packet in nanoseconds, gap included
+  uint64_t GetTxNs (uint32_t size) const;
+
+  bool WakeUpDue (void) const;
+  bool SleepDue (void) const;
+
+  void CheckTimer (void);
+  void QueueLimit (void);
+  void QueueEmptied (void);
+  void TimeOut (void);
+  void SleepEnd (void);
+  void WakeUpEnd (void);
+  void TransmitComplete (void);
+  void Transmit (void);
+
+  /// Accounts the time since the last change to the current power state
+  void UpdatePowerState (void);
+
+  Parameters m_p;              //!< Parameters
+  uint64_t m_timeoutNs;        //!< Coalescing timeout
+  uint64_t m_sleepNs;          //!< Sleep time
+  uint64_t m_wakeUpNs;         //!< Wake-up time
+
+  uint64_t m_now;              //!< Time of the current event
+  State m_state;               //!< Coalescing state
+  bool m_busy;                 //!< A transmission is on the wire
+
+  uint64_t m_sleepAt;          //!< Time of the end of the sleep transition
+  uint64_t m_timerAt;          //!< Time at which the coalescing timer fires
+  uint64_t m_wakeUpAt;         //!< Time of the end of the wake-up transition
+  uint64_t m_txAt;             //!< Time at which the transmission completes
+
+  uint32_t m_queueBytes;       //!< Bytes in the queue
+  uint32_t m_queuePackets;     //!< Packets in the queue
+  uint64_t m_queueTxNs;        //!< Transmission time of the queued packets
+  std::vector<QueuedPacket> m_queue; //!< Queued packets, as a ring
+  std::size_t m_head;          //!< Index of the first queued packet
+  double m_queueArrivalNs;     //!< Sum of the arrival times of the queued packets, in bursts
+  double m_queueOffsetNs;      //!< Sum of the offsets of the queued packets in their burst
+
+  uint64_t m_lowPowerStart;    //!< Start of the last low-power state
+  double m_lpTimeNs;           //!< Time in low power, first interval excluded
+  uint64_t m_lpIntervals;      //!< Number of low-power intervals
+  uint64_t m_packetCount;      //!< Packets transmitted
+  uint64_t m_packetBytes;      //!< Bytes transmitted
+  double m_sumInterarrivalNs;  //!< Sum of the interarrival times
+  double m_delayNs;            //!< Sum of the delays of the transmitted packets
+  uint64_t m_lastArrivalNs;    //!< Time of the last arrival
+  uint64_t m_nEvents;          //!< Events processed
+
+  PowerState m_powerState;     //!< Current power state
+  uint64_t m_powerSince;       //!< Time of the last power state change
+  uint64_t m_residency[N_POWER_STATES]; //!< Time spent in each power state
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_MODEL_H */
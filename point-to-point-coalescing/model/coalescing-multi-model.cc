@@ -0,0 +1,288 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cmath>
+#include <limits>
+#include "coalescing-multi-model.h"
+
+namespace ns3 {
+
+namespace {
+
+const double NEVER = std::numeric_limits<double>::infinity ();
+
+} // namespace
+
+CoalescingMultiModel::CoalescingMultiModel (const std::vector<Configuration> &configurations,
+                                            const CoalescingModel::Parameters &p)
+  : m_n (configurations.size ()),
+    m_dataRate (p.dataRate),
+    m_interframeGapNs (p.interframeGapNs),
+    m_lastArrivalNs (0),
+    m_sumInterarrivalNs (0),
+    m_byteLimit (m_n),
+    m_timeoutNs (m_n),
+    m_sleepNs (m_n),
+    m_wakeUpNs (m_n),
+    m_state (m_n, LOW_POWER),
+    m_stateAt (m_n, NEVER),
+    m_timerAt (m_n, NEVER),
+    m_since (m_n, 0),
+    m_lowPowerStart (m_n, 0),
+    m_queueBytes (m_n, 0),
+    m_queuePackets (m_n, 0),
+    m_queueTxNs (m_n, 0),
+    m_queueArrivalNs (m_n, 0),
+    m_queueOffsetNs (m_n, 0),
+    m_lpTimeNs (m_n, 0),
+    m_lpIntervals (m_n, 0),
+    m_packetCount (m_n, 0),
+    m_packetBytes (m_n, 0),
+    m_delayNs (m_n, 0)
+{
+  for (int i = 0; i < CoalescingModel::N_POWER_STATES; ++i)
+    {
+      m_power[i] = p.power[i];
+    }
+  for (int s = 0; s < 4; ++s)
+    {
+      m_residency[s].assign (m_n, 0);
+    }
+  // as CoalescingModel, which rounds the times of the attributes to nanoseconds
+  for (uint32_t i = 0; i < m_n; ++i)
+    {
+      m_byteLimit[i] = configurations[i].byteLimit;
+      m_timeoutNs[i] = std::llround (configurations[i].timeout * 1000);
+      m_sleepNs[i] = std::llround (configurations[i].sleepTime * 1000);
+      m_wakeUpNs[i] = std::llround (configurations[i].wakeUpTime * 1000);
+    }
+}
+
+//
+// The loops over the lanes below have no branches and no calls, and the
+// lanes are independent, which ivdep tells the compiler, so that it
+// vectorizes them.  Every condition is computed for all lanes and applied with a
+// select.  Conditions are doubles, 1 or 0, combined by products, since
+// the compiler does not vectorize bool values next to double lanes.
+// GCC turns a select whose arm adds or subtracts into a branch, and only
+// if-converts it back when floating point operations may not trap, so the
+// loops are vectorized with -fno-trapping-math only.  The model does not
+// use floating point exceptions, and the results do not change.
+//
+bool
+CoalescingMultiModel::Step (double t)
+{
+  double *state = &m_state[0];
+  double *stateAt = &m_stateAt[0];
+  double *timerAt = &m_timerAt[0];
+  double *since = &m_since[0];
+  double *lowPowerStart = &m_lowPowerStart[0];
+  double *queueBytes = &m_queueBytes[0];
+  double *queuePackets = &m_queuePackets[0];
+  double *queueTxNs = &m_queueTxNs[0];
+  double *queueArrivalNs = &m_queueArrivalNs[0];
+  double *queueOffsetNs = &m_queueOffsetNs[0];
+  double *lpTimeNs = &m_lpTimeNs[0];
+  double *lpIntervals = &m_lpIntervals[0];
+  double *packetCount = &m_packetCount[0];
+  double *packetBytes = &m_packetBytes[0];
+  double *delayNs = &m_delayNs[0];
+  double *resSend = &m_residency[SEND][0];
+  double *resSleep = &m_residency[SLEEPING][0];
+  double *resLowPower = &m_residency[LOW_POWER][0];
+  double *resWakeUp = &m_residency[WAKING_UP][0];
+  const double *sleepNs = &m_sleepNs[0];
+  const double *wakeUpNs = &m_wakeUpNs[0];
+
+  int more = 0;
+#pragma GCC ivdep
+  for (uint32_t i = 0; i < m_n; ++i)
+    {
+      double s = state[i];
+      // the end of a state comes before the timer due at the same time
+      double isState = stateAt[i] <= timerAt[i] ? 1 : 0;
+      double e = isState != 0 ? stateAt[i] : timerAt[i];
+      double due = e <= t ? 1 : 0;
+      double stateEvent = due * isState;
+      double timerEvent = due * (1 - isState);
+
+      double dt = due != 0 ? e - since[i] : 0;
+      resSend[i] += s == SEND ? dt : 0;
+      resSleep[i] += s == SLEEPING ? dt : 0;
+      resLowPower[i] += s == LOW_POWER ? dt : 0;
+      resWakeUp[i] += s == WAKING_UP ? dt : 0;
+      since[i] = due != 0 ? e : since[i];
+
+      // transmission or wake-up complete, a burst starts or the link sleeps
+      double active = stateEvent * ((s == SEND ? 1 : 0) + (s == WAKING_UP ? 1 : 0));
+      double empty = queuePackets[i] == 0 ? 1 : 0;
+      double burst = active * (1 - empty);
+      double sleep = active * empty;
+      double lowPower = stateEvent * (s == SLEEPING ? 1 : 0);
+      double wokenUp = stateEvent * (s == WAKING_UP ? 1 : 0);
+      double wakeUp = timerEvent * (s == LOW_POWER ? 1 : 0);
+
+      lpTimeNs[i] += wokenUp * (lpIntervals[i] > 0 ? 1 : 0) != 0 ? e - lowPowerStart[i] : 0;
+      lpIntervals[i] += wokenUp;
+      lowPowerStart[i] = lowPower != 0 ? e : lowPowerStart[i];
+
+      delayNs[i] += burst != 0 ? queuePackets[i] * e + queueOffsetNs[i] - queueArrivalNs[i] : 0;
+      packetCount[i] += burst * queuePackets[i];
+      packetBytes[i] += burst * queueBytes[i];
+
+      double at = stateAt[i];
+      at = burst != 0 ? e + queueTxNs[i] : at;
+      at = sleep != 0 ? e + sleepNs[i] : at;
+      at = lowPower != 0 ? NEVER : at;
+      at = wakeUp != 0 ? e + wakeUpNs[i] : at;
+      stateAt[i] = at;
+
+      s = burst != 0 ? static_cast<double> (SEND) : s;
+      s = sleep != 0 ? static_cast<double> (SLEEPING) : s;
+      s = lowPower != 0 ? static_cast<double> (LOW_POWER) : s;
+      s = wakeUp != 0 ? static_cast<double> (WAKING_UP) : s;
+      state[i] = s;
+
+      timerAt[i] = timerEvent != 0 ? NEVER : timerAt[i];
+
+      queueBytes[i] = burst != 0 ? 0 : queueBytes[i];
+      queuePackets[i] = burst != 0 ? 0 : queuePackets[i];
+      queueTxNs[i] = burst != 0 ? 0 : queueTxNs[i];
+      queueArrivalNs[i] = burst != 0 ? 0 : queueArrivalNs[i];
+      queueOffsetNs[i] = burst != 0 ? 0 : queueOffsetNs[i];
+
+      double next = stateAt[i] < timerAt[i] ? stateAt[i] : timerAt[i];
+      more |= next <= t;
+    }
+  return more != 0;
+}
+
+void
+CoalescingMultiModel::Arrival (uint64_t timeNs, uint32_t size)
+{
+  double t = timeNs;
+  while (Step (t))
+    {
+    }
+
+  if (m_lastArrivalNs > 0)
+    {
+      m_sumInterarrivalNs += timeNs - m_lastArrivalNs;
+    }
+  m_lastArrivalNs = timeNs;
+
+  double txNs = static_cast<double> (static_cast<uint64_t> (size) * 8000000000ULL / m_dataRate + m_interframeGapNs);
+  double bytes = size;
+
+  double *state = &m_state[0];
+  double *stateAt = &m_stateAt[0];
+  double *timerAt = &m_timerAt[0];
+  double *since = &m_since[0];
+  double *queueBytes = &m_queueBytes[0];
+  double *queuePackets = &m_queuePackets[0];
+  double *queueTxNs = &m_queueTxNs[0];
+  double *queueArrivalNs = &m_queueArrivalNs[0];
+  double *queueOffsetNs = &m_queueOffsetNs[0];
+  double *resLowPower = &m_residency[LOW_POWER][0];
+  const double *byteLimit = &m_byteLimit[0];
+  const double *timeoutNs = &m_timeoutNs[0];
+  const double *wakeUpNs = &m_wakeUpNs[0];
+
+#pragma GCC ivdep
+  for (uint32_t i = 0; i < m_n; ++i)
+    {
+      double s = state[i];
+
+      // the first packet of a low-power cycle starts the timer
+      double start = (queueBytes[i] == 0 ? 1 : 0) * (timerAt[i] == NEVER ? 1 : 0)
+        * ((s == SLEEPING ? 1 : 0) + (s == LOW_POWER ? 1 : 0));
+      timerAt[i] = start != 0 ? t + timeoutNs[i] : timerAt[i];
+
+      queueOffsetNs[i] += queueTxNs[i];
+      queueArrivalNs[i] += t;
+      queueTxNs[i] += txNs;
+      queueBytes[i] += bytes;
+      queuePackets[i] += 1;
+
+      // the byte limit wakes the link up
+      double wakeUp = (s == LOW_POWER ? 1 : 0) * (queueBytes[i] >= byteLimit[i] ? 1 : 0);
+      resLowPower[i] += wakeUp != 0 ? t - since[i] : 0;
+      since[i] = wakeUp != 0 ? t : since[i];
+      state[i] = wakeUp != 0 ? static_cast<double> (WAKING_UP) : s;
+      stateAt[i] = wakeUp != 0 ? t + wakeUpNs[i] : stateAt[i];
+      timerAt[i] = wakeUp != 0 ? NEVER : timerAt[i];
+    }
+}
+
+void
+CoalescingMultiModel::Finish (uint64_t endNs)
+{
+  double t = endNs;
+  while (Step (t))
+    {
+    }
+  for (uint32_t i = 0; i < m_n; ++i)
+    {
+      double dt = t > m_since[i] ? t - m_since[i] : 0;
+      m_residency[static_cast<int> (m_state[i])][i] += dt;
+      m_since[i] += dt;
+    }
+}
+
+uint32_t
+CoalescingMultiModel::GetN (void) const
+{
+  return m_n;
+}
+
+CoalescingMeasurementRecord
+CoalescingMultiModel::GetMeasurementRecord (uint32_t i, uint32_t nodeId, uint32_t ifIndex) const
+{
+  CoalescingMeasurementRecord r;
+  r.nodeId = nodeId;
+  r.ifIndex = ifIndex;
+  r.lpTimeNs = m_lpTimeNs[i];
+  r.lpIntervals = m_lpIntervals[i] > 0 ? static_cast<uint64_t> (m_lpIntervals[i]) - 1 : 0;
+  r.packetCount = static_cast<uint64_t> (m_packetCount[i]);
+  r.packetBytes = static_cast<uint64_t> (m_packetBytes[i]);
+  r.meanInterarrival = r.packetCount > 1 ? m_sumInterarrivalNs / 1e9 / (r.packetCount - 1) : 0;
+  r.dataRate = m_dataRate;
+  return r;
+}
+
+double
+CoalescingMultiModel::GetEnergyRatio (uint32_t i) const
+{
+  double send = m_residency[SEND][i];
+  double total = send + m_residency[SLEEPING][i] + m_residency[LOW_POWER][i] + m_residency[WAKING_UP][i];
+  // the link transmits whenever it is active, so it is never idle with EEE
+  double energy = m_power[CoalescingModel::TRANSMIT] * send
+    + m_power[CoalescingModel::SLEEP] * m_residency[SLEEPING][i]
+    + m_power[CoalescingModel::LOWPOWER] * m_residency[LOW_POWER][i]
+    + m_power[CoalescingModel::WAKEUP] * m_residency[WAKING_UP][i];
+  double withoutEee = m_power[CoalescingModel::TRANSMIT] * send
+    + m_power[CoalescingModel::IDLE] * (total - send);
+  return withoutEee > 0 ? energy / withoutEee : 0;
+}
+
+double
+CoalescingMultiModel::GetMeanDelay (uint32_t i) const
+{
+  return m_packetCount[i] > 0 ? 1e-9 * m_delayNs[i] / m_packetCount[i] : 0;
+}
+
+} // namespace ns3
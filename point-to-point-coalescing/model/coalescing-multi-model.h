@@ -0,0 +1,164 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_MULTI_MODEL_H
+#define COALESCING_MULTI_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "coalescing-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Coalescing state machine of one port under many configurations
+ *
+ * The model advances one CoalescingModel per configuration over the same
+ * arrivals, in one pass.  The state of the configurations is kept as a
+ * structure of arrays, one array per variable with one lane per
+ * configuration, and every step updates all lanes with the same
+ * branch-free code, so the compiler vectorizes the loops over the lanes
+ * for the instruction set of the target, AVX2 or AVX-512 with
+ * -O3 -march=native -fno-trapping-math.  Without -fno-trapping-math GCC
+ * keeps the loops scalar, with the same results.
+ *
+ * The configurations differ in byte limit, coalescing timeout, sleep time
+ * and wake-up time.  The model covers the ByteLimit policy with
+ * BurstTransmit, the setup of the example, where the link transmits
+ * whenever it is active, so every lane has at most one transition and one
+ * coalescing timer pending.  Its results are those of CoalescingModel
+ * with the same parameters.
+ *
+ * Besides the measurements of the device, the model accounts the delay
+ * from the arrival of every packet to the start of its transmission.
+ */
+class CoalescingMultiModel
+{
+public:
+  /// Parameters which differ between the configurations
+  struct Configuration
+  {
+    double byteLimit;     //!< EeeByteLimit
+    double timeout;       //!< EeeCoalescingTimeout, in microseconds
+    double sleepTime;     //!< EeeSleepTime, in microseconds
+    double wakeUpTime;    //!< EeeWakeUpTime, in microseconds
+  };
+
+  /**
+   * \param configurations configurations to evaluate
+   * \param p data rate, interframe gap and power profile of the port;
+   * the other fields are ignored
+   */
+  CoalescingMultiModel (const std::vector<Configuration> &configurations,
+                        const CoalescingModel::Parameters &p);
+
+  /**
+   * \brief Process the events due until a packet arrives, and the arrival
+   *
+   * \param timeNs time of the arrival, not earlier than the previous one
+   * \param size size of the packet in bytes, with its PPP header
+   */
+  void Arrival (uint64_t timeNs, uint32_t size);
+
+  /**
+   * \brief Process the events due until the end of the run
+   *
+   * \param endNs time at which the run ends
+   */
+  void Finish (uint64_t endNs);
+
+  /// \return the number of configurations
+  uint32_t GetN (void) const;
+
+  /**
+   * \param i index of the configuration
+   * \param nodeId node id of the record
+   * \param ifIndex interface index of the record
+   * \return the measurements of the port, as CoalescingModel::GetMeasurementRecord
+   */
+  CoalescingMeasurementRecord GetMeasurementRecord (uint32_t i, uint32_t nodeId, uint32_t ifIndex) const;
+
+  /**
+   * \param i index of the configuration
+   * \return the energy consumed over the energy consumed without EEE
+   */
+  double GetEnergyRatio (uint32_t i) const;
+
+  /**
+   * \param i index of the configuration
+   * \return the mean time from the arrival of a packet to the start of
+   * its transmission, in seconds
+   */
+  double GetMeanDelay (uint32_t i) const;
+
+private:
+  /// Coalescing states of the lanes, stored as doubles like all lane variables
+  enum State
+  {
+    SEND = 0,
+    SLEEPING = 1,
+    LOW_POWER = 2,
+    WAKING_UP = 3
+  };
+
+  /**
+   * \brief Process the earliest event of every lane due at or before t
+   *
+   * \param t time up to which events are processed
+   * \return true if some lane has another event due at or before t
+   */
+  bool Step (double t);
+
+  uint32_t m_n;                   //!< Number of lanes
+  uint64_t m_dataRate;            //!< Data rate, in bit/s
+  uint64_t m_interframeGapNs;     //!< Interframe gap
+  double m_power[CoalescingModel::N_POWER_STATES]; //!< Power profile
+  uint64_t m_lastArrivalNs;       //!< Time of the last arrival
+  double m_sumInterarrivalNs;     //!< Sum of the interarrival times
+
+  // parameters of the lanes, in nanoseconds
+  std::vector<double> m_byteLimit;   //!< Byte limit
+  std::vector<double> m_timeoutNs;   //!< Coalescing timeout
+  std::vector<double> m_sleepNs;     //!< Sleep time
+  std::vector<double> m_wakeUpNs;    //!< Wake-up time
+
+  // state of the lanes
+  std::vector<double> m_state;       //!< Coalescing state
+  std::vector<double> m_stateAt;     //!< Time of the end of the current state, infinity in low power
+  std::vector<double> m_timerAt;     //!< Time at which the coalescing timer fires, or infinity
+  std::vector<double> m_since;       //!< Start of the current state
+  std::vector<double> m_lowPowerStart; //!< Start of the last low-power state
+  std::vector<double> m_queueBytes;  //!< Bytes in the queue
+  std::vector<double> m_queuePackets; //!< Packets in the queue
+  std::vector<double> m_queueTxNs;   //!< Transmission time of the queued packets
+  std::vector<double> m_queueArrivalNs; //!< Sum of the arrival times of the queued packets
+  std::vector<double> m_queueOffsetNs;  //!< Sum of the offsets of the queued packets in their burst
+
+  // results of the lanes
+  std::vector<double> m_lpTimeNs;    //!< Time in low power, first interval excluded
+  std::vector<double> m_lpIntervals; //!< Number of low-power intervals
+  std::vector<double> m_packetCount; //!< Packets transmitted
+  std::vector<double> m_packetBytes; //!< Bytes transmitted
+  std::vector<double> m_delayNs;     //!< Sum of the delays of the transmitted packets
+  std::vector<double> m_residency[4]; //!< Time spent in each state
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_MULTI_MODEL_H */
@@ -0,0 +1,450 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/mpi-interface.h"
+#include "coalescing-partition-interface.h"
+#include "point-to-point-coalescing-net-device.h"
+#include "point-to-point-coalescing-channel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingPartitionInterface");
+
+namespace {
+
+// end of a window when no frame can cross partitions
+const uint64_t NEVER = ~static_cast<uint64_t> (0);
+
+// barrier shared by the partitions
+struct Control
+{
+  std::atomic<uint32_t> count;  // partitions at the barrier
+  std::atomic<uint32_t> sense;  // flipped by the last partition to arrive
+  std::atomic<uint32_t> failed; // set by a partition which found a peer gone
+};
+
+// what a partition reports at the end of a window
+struct Slot
+{
+  uint64_t nextNs;    // earliest arrival of a frame it sends
+  uint32_t finished;  // no events left
+  uint32_t stop;      // asked to stop the run
+};
+
+// ring of the frames sent from one partition to another, followed by its
+// data; head and tail count bytes and only grow
+struct Ring
+{
+  std::atomic<uint64_t> head;  // written by the consumer
+  uint8_t pad1[56];
+  std::atomic<uint64_t> tail;  // written by the producer
+  uint8_t pad2[56];
+};
+
+// frame in a ring, followed by the serialized packet padded to 8 bytes
+struct Record
+{
+  uint64_t rxTimeNs;
+  uint32_t node;
+  uint32_t dev;
+  uint32_t size;
+  uint32_t pad;
+};
+
+const std::size_t CONTROL_SIZE = 64;
+
+std::size_t
+GetSlotsSize (uint32_t n)
+{
+  return (2 * n * sizeof (Slot) + 63) & ~static_cast<std::size_t> (63);
+}
+
+Control *
+GetControl (uint8_t *shared)
+{
+  return reinterpret_cast<Control *> (shared);
+}
+
+Slot *
+GetSlot (uint8_t *shared, uint32_t n, uint64_t round, uint32_t partition)
+{
+  return reinterpret_cast<Slot *> (shared + CONTROL_SIZE) + (round % 2) * n + partition;
+}
+
+Ring *
+GetRing (uint8_t *shared, uint32_t n, uint32_t ringSize, uint32_t from, uint32_t to)
+{
+  std::size_t offset = CONTROL_SIZE + GetSlotsSize (n) + (from * n + to) * (sizeof (Ring) + ringSize);
+  return reinterpret_cast<Ring *> (shared + offset);
+}
+
+// copy to the data of a ring, wrapping at its end
+void
+RingWrite (Ring *ring, uint32_t ringSize, uint64_t pos, const void *src, std::size_t len)
+{
+  uint8_t *data = reinterpret_cast<uint8_t *> (ring + 1);
+  std::size_t offset = pos % ringSize;
+  std::size_t first = std::min (len, ringSize - offset);
+  std::memcpy (data + offset, src, first);
+  std::memcpy (data, static_cast<const uint8_t *> (src) + first, len - first);
+}
+
+// copy from the data of a ring, wrapping at its end
+void
+RingRead (Ring *ring, uint32_t ringSize, uint64_t pos, void *dst, std::size_t len)
+{
+  const uint8_t *data = reinterpret_cast<const uint8_t *> (ring + 1);
+  std::size_t offset = pos % ringSize;
+  std::size_t first = std::min (len, ringSize - offset);
+  std::memcpy (dst, data + offset, first);
+  std::memcpy (static_cast<uint8_t *> (dst) + first, data, len - first);
+}
+
+} // namespace
+
+uint32_t CoalescingPartitionInterface::m_partition = 0;
+uint32_t CoalescingPartitionInterface::m_nPartitions = 0;
+uint32_t CoalescingPartitionInterface::m_ringSize = 0;
+uint8_t *CoalescingPartitionInterface::m_shared = 0;
+std::size_t CoalescingPartitionInterface::m_sharedSize = 0;
+uint32_t CoalescingPartitionInterface::m_sense = 0;
+uint64_t CoalescingPartitionInterface::m_round = 0;
+bool CoalescingPartitionInterface::m_stop = false;
+bool CoalescingPartitionInterface::m_windowPending = false;
+pid_t CoalescingPartitionInterface::m_parent = 0;
+std::vector<pid_t> CoalescingPartitionInterface::m_children;
+uint32_t CoalescingPartitionInterface::m_failed = 0;
+std::vector<uint8_t> CoalescingPartitionInterface::m_buffer;
+
+void
+CoalescingPartitionInterface::Enable (uint32_t n, uint32_t ringSize)
+{
+  NS_LOG_FUNCTION (n << ringSize);
+  NS_ABORT_MSG_IF (n == 0, "At least one partition is needed");
+  NS_ABORT_MSG_IF (IsEnabled (), "Partitions are already enabled");
+  NS_ABORT_MSG_IF (MpiInterface::IsEnabled (), "Partitions cannot be combined with distributed simulation");
+
+  m_ringSize = (ringSize + 63) & ~static_cast<uint32_t> (63);
+  m_sharedSize = CONTROL_SIZE + GetSlotsSize (n) + n * n * (sizeof (Ring) + m_ringSize);
+  void *shared = mmap (0, m_sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  NS_ABORT_MSG_IF (shared == MAP_FAILED, "Cannot map " << m_sharedSize << " bytes of shared memory");
+  m_shared = static_cast<uint8_t *> (shared);
+
+  // the mapping is zeroed, the atomics are constructed in place
+  Control *control = new (m_shared) Control;
+  control->count.store (0);
+  control->sense.store (0);
+  control->failed.store (0);
+  for (uint32_t from = 0; from < n; ++from)
+    {
+      for (uint32_t to = 0; to < n; ++to)
+        {
+          Ring *ring = new (GetRing (m_shared, n, m_ringSize, from, to)) Ring;
+          ring->head.store (0);
+          ring->tail.store (0);
+        }
+    }
+
+  m_nPartitions = n;
+  m_partition = 0;
+  m_sense = 0;
+  m_round = 0;
+  m_stop = false;
+  m_failed = 0;
+  m_children.clear ();
+
+  // buffered output would otherwise be written by every process
+  std::fflush (0);
+  pid_t parent = getpid ();
+  for (uint32_t i = 1; i < n; ++i)
+    {
+      pid_t pid = fork ();
+      NS_ABORT_MSG_IF (pid < 0, "Cannot fork partition " << i);
+      if (pid == 0)
+        {
+          m_partition = i;
+          m_parent = parent;
+          m_children.clear ();
+          break;
+        }
+      m_children.push_back (pid);
+    }
+
+  m_windowPending = true;
+  Simulator::ScheduleNow (&CoalescingPartitionInterface::Synchronize);
+}
+
+void
+CoalescingPartitionInterface::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (!IsEnabled ())
+    {
+      return;
+    }
+
+  for (std::size_t i = 0; i < m_children.size (); ++i)
+    {
+      int status;
+      if (waitpid (m_children[i], &status, 0) < 0 || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          NS_LOG_WARN ("Partition " << i + 1 << " failed");
+          m_failed++;
+        }
+    }
+  m_children.clear ();
+
+  munmap (m_shared, m_sharedSize);
+  m_shared = 0;
+  m_nPartitions = 0;
+}
+
+bool
+CoalescingPartitionInterface::IsEnabled (void)
+{
+  return m_nPartitions > 0;
+}
+
+uint32_t
+CoalescingPartitionInterface::GetPartition (void)
+{
+  return m_partition;
+}
+
+uint32_t
+CoalescingPartitionInterface::GetNPartitions (void)
+{
+  return m_nPartitions;
+}
+
+uint32_t
+CoalescingPartitionInterface::GetNFailed (void)
+{
+  return m_failed;
+}
+
+void
+CoalescingPartitionInterface::Stop (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ASSERT (IsEnabled ());
+
+  // without windows the partitions do not wait for each other
+  if (!m_windowPending)
+    {
+      Simulator::Stop ();
+      return;
+    }
+  m_stop = true;
+}
+
+void
+CoalescingPartitionInterface::Send (Ptr<Packet> p, Time rxTime, uint32_t partition, uint32_t node, uint32_t dev)
+{
+  NS_LOG_FUNCTION (p << rxTime << partition << node << dev);
+  NS_ASSERT (IsEnabled () && partition < m_nPartitions && partition != m_partition);
+
+  Record record;
+  record.rxTimeNs = rxTime.GetNanoSeconds ();
+  record.node = node;
+  record.dev = dev;
+  record.size = p->GetSerializedSize ();
+  record.pad = 0;
+  m_buffer.resize (record.size);
+  NS_ABORT_MSG_IF (p->Serialize (&m_buffer[0], record.size) == 0, "Cannot serialize packet " << p->GetUid ());
+
+  // only this process writes the tail, so it is read without ordering
+  Ring *ring = GetRing (m_shared, m_nPartitions, m_ringSize, m_partition, partition);
+  uint64_t tail = ring->tail.load (std::memory_order_relaxed);
+  uint64_t head = ring->head.load (std::memory_order_acquire);
+  uint64_t length = sizeof (Record) + ((record.size + 7) & ~static_cast<uint64_t> (7));
+  NS_ABORT_MSG_IF (tail + length - head > m_ringSize,
+                   "Ring from partition " << m_partition << " to " << partition << " is full, increase its size");
+
+  RingWrite (ring, m_ringSize, tail, &record, sizeof (Record));
+  RingWrite (ring, m_ringSize, tail + sizeof (Record), &m_buffer[0], record.size);
+  ring->tail.store (tail + length, std::memory_order_release);
+}
+
+void
+CoalescingPartitionInterface::Receive (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  // the rings are taken in the order of the partitions, so the frames are
+  // scheduled in the same order in every run
+  for (uint32_t from = 0; from < m_nPartitions; ++from)
+    {
+      if (from == m_partition)
+        {
+          continue;
+        }
+      Ring *ring = GetRing (m_shared, m_nPartitions, m_ringSize, from, m_partition);
+      uint64_t head = ring->head.load (std::memory_order_relaxed);
+      uint64_t tail = ring->tail.load (std::memory_order_acquire);
+      while (head < tail)
+        {
+          Record record;
+          RingRead (ring, m_ringSize, head, &record, sizeof (Record));
+          m_buffer.resize (record.size);
+          RingRead (ring, m_ringSize, head + sizeof (Record), &m_buffer[0], record.size);
+          head += sizeof (Record) + ((record.size + 7) & ~static_cast<uint64_t> (7));
+
+          Ptr<Packet> p = Create<Packet> (&m_buffer[0], record.size, true);
+          Ptr<PointToPointCoalescingNetDeviceBase> dev =
+            DynamicCast<PointToPointCoalescingNetDeviceBase> (NodeList::GetNode (record.node)->GetDevice (record.dev));
+          NS_ASSERT (dev != 0);
+          Time delay = NanoSeconds (record.rxTimeNs) - Simulator::Now ();
+          NS_ASSERT_MSG (!delay.IsStrictlyNegative (), "Frame from partition " << from << " arrived too late");
+          Simulator::ScheduleWithContext (record.node, delay, &PointToPointCoalescingNetDeviceBase::Receive, dev, p);
+        }
+      ring->head.store (head, std::memory_order_release);
+    }
+}
+
+void
+CoalescingPartitionInterface::Barrier (void)
+{
+  Control *control = GetControl (m_shared);
+  m_sense = !m_sense;
+  if (control->count.fetch_add (1) + 1 == m_nPartitions)
+    {
+      control->count.store (0);
+      control->sense.store (m_sense);
+    }
+  else
+    {
+      uint32_t spins = 0;
+      while (control->sense.load () != m_sense)
+        {
+          if (++spins % 1024 == 0 && IsPeerGone ())
+            {
+              // a peer may exit right after the last one reached the barrier
+              if (control->sense.load () == m_sense)
+                {
+                  break;
+                }
+              control->failed.store (1);
+              NS_FATAL_ERROR ("Partition " << m_partition << " waits at a barrier which a partition left");
+            }
+          sched_yield ();
+        }
+    }
+}
+
+bool
+CoalescingPartitionInterface::IsPeerGone (void)
+{
+  if (GetControl (m_shared)->failed.load () != 0)
+    {
+      return true;
+    }
+  if (m_partition != 0)
+    {
+      // partition 0 waits for the others in Disable, so it exits last
+      return getppid () != m_parent;
+    }
+  for (std::size_t i = 0; i < m_children.size (); ++i)
+    {
+      // the exit is only looked at, Disable still collects it
+      siginfo_t info;
+      info.si_pid = 0;
+      if (waitid (P_PID, m_children[i], &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+CoalescingPartitionInterface::Synchronize (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  // all partitions reached the end of the window, so the frames sent
+  // during it are in the rings
+  Barrier ();
+  Receive ();
+
+  Slot *mine = GetSlot (m_shared, m_nPartitions, m_round, m_partition);
+  Time earliest = PointToPointCoalescingChannel::GetEarliestArrival (m_partition);
+  mine->nextNs = earliest == Time::Max () ? NEVER : earliest.GetNanoSeconds ();
+  mine->finished = Simulator::IsFinished ();
+  mine->stop = m_stop;
+  Barrier ();
+
+  // the slots alternate between windows, so a partition may fill the next
+  // one while another still reads these
+  uint64_t next = NEVER;
+  bool finished = true;
+  bool stop = true;
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      Slot *slot = GetSlot (m_shared, m_nPartitions, m_round, i);
+      next = std::min (next, slot->nextNs);
+      finished = finished && slot->finished;
+      stop = stop && slot->stop;
+    }
+  m_round++;
+  m_windowPending = false;
+
+  if (finished)
+    {
+      NS_LOG_LOGIC ("All partitions finished at " << Simulator::Now ());
+      return;
+    }
+  if (stop)
+    {
+      // every partition leaves Simulator::Run after this event, at the
+      // same time, so they reach their next barrier together
+      NS_LOG_LOGIC ("All partitions stop at " << Simulator::Now ());
+      m_stop = false;
+      Simulator::Stop ();
+      return;
+    }
+  if (next != NEVER)
+    {
+      NS_LOG_LOGIC ("Next window ends at " << NanoSeconds (next));
+      m_windowPending = true;
+      Simulator::Schedule (NanoSeconds (next) - Simulator::Now (), &CoalescingPartitionInterface::Synchronize);
+    }
+  else if (m_stop)
+    {
+      Simulator::Stop ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,176 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#ifndef COALESCING_PARTITION_INTERFACE_H
+#define COALESCING_PARTITION_INTERFACE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup point-to-point
+ * \brief Partitioned execution on one machine without MPI
+ *
+ * The simulation is split into partitions by the system id of the nodes,
+ * as for distributed simulation.  Enable forks one process per partition
+ * before the topology is built, so every partition builds the same
+ * topology and, like an MPI rank, runs the events of its own nodes.
+ * Frames crossing partitions are written by a
+ * PointToPointCoalescingPartitionChannel to a lock-free single producer,
+ * single consumer ring in memory shared by the processes.
+ *
+ * The partitions synchronize conservatively.  At the end of each window
+ * they meet at a barrier, take the frames sent to them during the window
+ * out of their rings and agree on the end of the next window, which is
+ * the earliest time a frame of any partition can arrive at another one.
+ * That is the link delay while the links are awake, and more while the
+ * ports of the links that cross partitions are in low power.  The run ends
+ * when no partition has events left, or at the end of the first window at
+ * which all partitions asked to stop with Stop.
+ *
+ * A partition must not leave Simulator::Run on its own, since the others
+ * would wait for it at the end of the window.  Simulator::Stop (Time) is
+ * fine when every partition calls it with the same time before
+ * Simulator::Run; a stop decided during the run goes through Stop.
+ *
+ * \code
+ *   CoalescingPartitionInterface::Enable (4);
+ *   uint32_t partition = CoalescingPartitionInterface::GetPartition ();
+ *   // create nodes with CreateObject<Node> (systemId), install devices
+ *   // and the applications of the nodes of this partition
+ *   Simulator::Run ();
+ *   // write the measurements of the devices of this partition
+ *   Simulator::Destroy ();
+ *   CoalescingPartitionInterface::Disable ();
+ * \endcode
+ *
+ * Processes are used instead of threads because the simulator core keeps
+ * global state which is not thread safe; the partitions share nothing but
+ * the rings.
+ */
+class CoalescingPartitionInterface
+{
+public:
+  /**
+   * \brief Fork the processes of the partitions
+   *
+   * \param n number of partitions
+   * \param ringSize size in bytes of the ring of each pair of partitions,
+   * which must hold all frames sent from one to the other in a window
+   */
+  static void Enable (uint32_t n, uint32_t ringSize = 16 * 1024 * 1024);
+
+  /**
+   * \brief Release the shared memory, and in partition 0 wait for the
+   * processes of the other partitions
+   */
+  static void Disable (void);
+
+  /**
+   * \return true between Enable and Disable
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \return the partition of this process, which runs the nodes of that
+   * system id
+   */
+  static uint32_t GetPartition (void);
+
+  /**
+   * \return the number of partitions
+   */
+  static uint32_t GetNPartitions (void);
+
+  /**
+   * \return the number of partitions whose process did not exit
+   * successfully, valid in partition 0 after Disable
+   */
+  static uint32_t GetNFailed (void);
+
+  /**
+   * \brief Ask to stop the run
+   *
+   * The partitions stop together, at the end of the first window at
+   * which every partition has asked to stop.  When no window is pending,
+   * the partitions do not depend on each other and this one stops at once.
+   */
+  static void Stop (void);
+
+  /**
+   * \brief Send a frame to the device of another partition
+   *
+   * \param p the frame
+   * \param rxTime absolute time at which the last bit arrives
+   * \param partition partition of the receiving node
+   * \param node id of the receiving node
+   * \param dev interface index of the receiving device
+   */
+  static void Send (Ptr<Packet> p, Time rxTime, uint32_t partition, uint32_t node, uint32_t dev);
+
+  /**
+   * \brief Wait until all partitions have reached the barrier
+   *
+   * Every partition must call it the same number of times, outside of
+   * Simulator::Run or after it returned.  When a partition exits or
+   * fails before it reaches the barrier, the others abort instead of
+   * waiting for it.
+   */
+  static void Barrier (void);
+
+private:
+  /**
+   * \return true if another partition exited, or failed at a barrier
+   */
+  static bool IsPeerGone (void);
+
+  /**
+   * \brief End a window: exchange frames and schedule the next window
+   */
+  static void Synchronize (void);
+
+  /**
+   * \brief Schedule the reception of the frames sent to this partition
+   */
+  static void Receive (void);
+
+  static uint32_t m_partition;         //!< Partition of this process
+  static uint32_t m_nPartitions;       //!< Number of partitions, 0 when disabled
+  static uint32_t m_ringSize;          //!< Size of the data of a ring
+  static uint8_t *m_shared;            //!< Shared memory
+  static std::size_t m_sharedSize;     //!< Size of the shared memory
+  static uint32_t m_sense;             //!< Sense of the barrier of this process
+  static uint64_t m_round;             //!< Number of windows ended
+  static bool m_stop;                  //!< This partition asked to stop
+  static bool m_windowPending;         //!< The end of a window is scheduled
+  static pid_t m_parent;               //!< Process of partition 0, in the other partitions
+  static std::vector<pid_t> m_children; //!< Processes of the other partitions, in partition 0
+  static uint32_t m_failed;            //!< Processes which failed
+  static std::vector<uint8_t> m_buffer; //!< Serialized frame
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_PARTITION_INTERFACE_H */
@@ -0,0 +1,187 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_POLICY_H
+#define COALESCING_POLICY_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Coalescing policies of the device and their parameters
+ *
+ * A policy makes the two decisions of a coalescing cycle:
+ *
+ * - WakeUp: called in low power after a packet has been enqueued, returns
+ *   true if the link has to wake up before the coalescing timer fires;
+ * - Sleep: called when a transmission completes, returns true if the link
+ *   has to go to low power with the packets left in the queue.
+ *
+ * The coalescing timer bounds the delay of the first packet of a cycle
+ * under every policy.
+ *
+ * Each policy is a class with static inline WakeUp and Sleep functions.
+ * The device picks the class with a switch on its policy type, and the
+ * compiler inlines the function of each case.  The parameters are kept
+ * by the device, so the decisions only read them.  New policies are added
+ * by writing such a class, a value of Type and a case of the switch.
+ */
+class CoalescingPolicy
+{
+public:
+  /// Policies known to the device
+  enum Type
+  {
+    BYTE_LIMIT,   //!< Wake up on byte limit or timeout
+    TIMER_ONLY,   //!< Wake up on timeout only
+    PACKET_COUNT, //!< Wake up on packet limit or timeout
+    HYBRID,       //!< Wake up on byte limit, packet limit or timeout
+    HYSTERESIS    //!< As BYTE_LIMIT, but sleep below a low byte limit
+  };
+
+  /// Parameters of the policies
+  struct Parameters
+  {
+    double byteLimit;      //!< Bytes in the queue which wake the link up
+    uint32_t packetLimit;  //!< Packets in the queue which wake the link up
+    double lowByteLimit;   //!< Bytes in the queue at or below which the link sleeps
+  };
+
+  /**
+   * \param type Policy
+   * \return The name of the policy, as used by the CoalescingPolicy attribute
+   */
+  static const char *GetName (Type type)
+  {
+    switch (type)
+      {
+      case BYTE_LIMIT:
+        return "ByteLimit";
+      case TIMER_ONLY:
+        return "TimerOnly";
+      case PACKET_COUNT:
+        return "PacketCount";
+      case HYBRID:
+        return "Hybrid";
+      case HYSTERESIS:
+        return "Hysteresis";
+      }
+    return "Unknown";
+  }
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Wake up when the queue holds byteLimit bytes, sleep when it is empty
+ *
+ * This is the policy of the original device and the default.
+ */
+class CoalescingByteLimitPolicy
+{
+public:
+  static bool WakeUp (const CoalescingPolicy::Parameters &p, uint32_t queueBytes, uint32_t)
+  {
+    return queueBytes >= p.byteLimit;
+  }
+
+  static bool Sleep (const CoalescingPolicy::Parameters &, uint32_t, uint32_t queuePackets)
+  {
+    return queuePackets == 0;
+  }
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Wake up only when the coalescing timer fires
+ */
+class CoalescingTimerOnlyPolicy
+{
+public:
+  static bool WakeUp (const CoalescingPolicy::Parameters &, uint32_t, uint32_t)
+  {
+    return false;
+  }
+
+  static bool Sleep (const CoalescingPolicy::Parameters &, uint32_t, uint32_t queuePackets)
+  {
+    return queuePackets == 0;
+  }
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Wake up when the queue holds packetLimit packets
+ */
+class CoalescingPacketCountPolicy
+{
+public:
+  static bool WakeUp (const CoalescingPolicy::Parameters &p, uint32_t, uint32_t queuePackets)
+  {
+    return queuePackets >= p.packetLimit;
+  }
+
+  static bool Sleep (const CoalescingPolicy::Parameters &, uint32_t, uint32_t queuePackets)
+  {
+    return queuePackets == 0;
+  }
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Wake up when either the byte or the packet limit is reached
+ */
+class CoalescingHybridPolicy
+{
+public:
+  static bool WakeUp (const CoalescingPolicy::Parameters &p, uint32_t queueBytes, uint32_t queuePackets)
+  {
+    return queueBytes >= p.byteLimit || queuePackets >= p.packetLimit;
+  }
+
+  static bool Sleep (const CoalescingPolicy::Parameters &, uint32_t, uint32_t queuePackets)
+  {
+    return queuePackets == 0;
+  }
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Wake up at byteLimit bytes, sleep at or below lowByteLimit bytes
+ *
+ * The packets left in the queue when the link goes to sleep are sent in
+ * the next cycle, whose timer starts immediately.  With a lowByteLimit of
+ * zero the policy behaves as CoalescingByteLimitPolicy.
+ */
+class CoalescingHysteresisPolicy
+{
+public:
+  static bool WakeUp (const CoalescingPolicy::Parameters &p, uint32_t queueBytes, uint32_t)
+  {
+    return queueBytes >= p.byteLimit;
+  }
+
+  static bool Sleep (const CoalescingPolicy::Parameters &p, uint32_t queueBytes, uint32_t queuePackets)
+  {
+    return queuePackets == 0 || queueBytes <= p.lowByteLimit;
+  }
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_POLICY_H */
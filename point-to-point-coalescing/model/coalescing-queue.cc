@@ -0,0 +1,311 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/net-device-queue-interface.h"
+#include "coalescing-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (CoalescingQueue);
+
+TypeId
+CoalescingQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoalescingQueue")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<CoalescingQueue> ()
+    .AddAttribute ("MaxSize",
+                   "The max queue size",
+                   QueueSizeValue (QueueSize ("100p")),
+                   MakeQueueSizeAccessor (&CoalescingQueue::SetMaxSize,
+                                          &CoalescingQueue::GetMaxSize),
+                   MakeQueueSizeChecker ())
+    .AddTraceSource ("PacketsInQueue",
+                     "Number of packets currently stored in the queue",
+                     MakeTraceSourceAccessor (&CoalescingQueue::m_nPackets),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("BytesInQueue",
+                     "Number of bytes currently stored in the queue",
+                     MakeTraceSourceAccessor (&CoalescingQueue::m_nBytes),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("Enqueue", "Enqueue a packet in the queue.",
+                     MakeTraceSourceAccessor (&CoalescingQueue::m_traceEnqueue),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("Dequeue", "Dequeue a packet from the queue.",
+                     MakeTraceSourceAccessor (&CoalescingQueue::m_traceDequeue),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("Drop", "Drop a packet stored in the queue.",
+                     MakeTraceSourceAccessor (&CoalescingQueue::m_traceDrop),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+CoalescingQueue::CoalescingQueue ()
+  : m_ring (1),
+    m_head (0),
+    m_mask (0),
+    m_nPackets (0),
+    m_nBytes (0),
+    m_nTotalDroppedPackets (0),
+    m_maxPacketSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CoalescingQueue::~CoalescingQueue ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CoalescingQueue::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ring.clear ();
+  m_head = 0;
+  m_mask = 0;
+  m_nPackets = 0;
+  m_nBytes = 0;
+  m_devQueue = 0;
+  Object::DoDispose ();
+}
+
+bool
+CoalescingQueue::Enqueue (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  uint32_t size = p->GetSize ();
+  if (!HasRoomFor (size))
+    {
+      NS_LOG_LOGIC ("Queue full -- dropping pkt");
+      m_nTotalDroppedPackets++;
+      m_traceDrop (p);
+      return false;
+    }
+
+  if (m_nPackets > m_mask)
+    {
+      Grow (2 * (m_mask + 1));
+    }
+
+  m_ring[(m_head + m_nPackets) & m_mask] = p;
+  m_nPackets++;
+  m_nBytes += size;
+  m_traceEnqueue (p);
+
+  if (m_devQueue != 0 && !HasRoomFor (m_maxPacketSize))
+    {
+      m_devQueue->Stop ();
+    }
+  return true;
+}
+
+Ptr<Packet>
+CoalescingQueue::Dequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_nPackets == 0)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<Packet> p = m_ring[m_head];
+  m_ring[m_head] = 0;
+  m_head = (m_head + 1) & m_mask;
+  m_nPackets--;
+  m_nBytes -= p->GetSize ();
+  m_traceDequeue (p);
+
+  PacketDequeued ();
+  return p;
+}
+
+uint32_t
+CoalescingQueue::DequeueAll (std::vector<Ptr<Packet> > &packets)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t n = m_nPackets;
+  packets.reserve (packets.size () + n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Ptr<Packet> &slot = m_ring[(m_head + i) & m_mask];
+      m_traceDequeue (slot);
+      packets.push_back (slot);
+      slot = 0;
+    }
+  m_head = 0;
+  m_nPackets = 0;
+  m_nBytes = 0;
+
+  PacketDequeued ();
+  return n;
+}
+
+Ptr<const Packet>
+CoalescingQueue::Peek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_nPackets == 0)
+    {
+      return 0;
+    }
+  return m_ring[m_head];
+}
+
+void
+CoalescingQueue::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (uint32_t i = 0; i < m_nPackets; ++i)
+    {
+      Ptr<Packet> &slot = m_ring[(m_head + i) & m_mask];
+      m_traceDrop (slot);
+      slot = 0;
+    }
+  m_head = 0;
+  m_nPackets = 0;
+  m_nBytes = 0;
+
+  PacketDequeued ();
+}
+
+bool
+CoalescingQueue::IsEmpty (void) const
+{
+  return m_nPackets == 0;
+}
+
+uint32_t
+CoalescingQueue::GetNPackets (void) const
+{
+  return m_nPackets;
+}
+
+uint32_t
+CoalescingQueue::GetNBytes (void) const
+{
+  return m_nBytes;
+}
+
+uint32_t
+CoalescingQueue::GetTotalDroppedPackets (void) const
+{
+  return m_nTotalDroppedPackets;
+}
+
+void
+CoalescingQueue::SetMaxSize (QueueSize size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_maxSize = size;
+}
+
+QueueSize
+CoalescingQueue::GetMaxSize (void) const
+{
+  return m_maxSize;
+}
+
+void
+CoalescingQueue::Reserve (uint32_t nPackets)
+{
+  NS_LOG_FUNCTION (this << nPackets);
+
+  if (m_maxSize.GetUnit () == QueueSizeUnit::PACKETS && nPackets > m_maxSize.GetValue ())
+    {
+      nPackets = m_maxSize.GetValue ();
+    }
+
+  uint32_t capacity = m_mask + 1;
+  while (capacity < nPackets)
+    {
+      capacity *= 2;
+    }
+  if (capacity > m_mask + 1)
+    {
+      Grow (capacity);
+    }
+}
+
+uint32_t
+CoalescingQueue::GetCapacity (void) const
+{
+  return m_mask + 1;
+}
+
+void
+CoalescingQueue::ConnectNetDeviceQueue (Ptr<NetDeviceQueue> devQueue, uint32_t maxPacketSize)
+{
+  NS_LOG_FUNCTION (this << devQueue << maxPacketSize);
+  m_devQueue = devQueue;
+  m_maxPacketSize = maxPacketSize;
+}
+
+void
+CoalescingQueue::Grow (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  NS_ASSERT_MSG ((capacity & (capacity - 1)) == 0, "Capacity must be a power of two");
+  NS_ASSERT (capacity > m_nPackets);
+
+  //
+  // Move the packets to the start of the new buffer in queue order, so the
+  // head is at slot zero again.
+  //
+  std::vector<Ptr<Packet> > ring (capacity);
+  for (uint32_t i = 0; i < m_nPackets; ++i)
+    {
+      ring[i] = m_ring[(m_head + i) & m_mask];
+    }
+  m_ring.swap (ring);
+  m_head = 0;
+  m_mask = capacity - 1;
+}
+
+bool
+CoalescingQueue::HasRoomFor (uint32_t size) const
+{
+  if (m_maxSize.GetUnit () == QueueSizeUnit::PACKETS)
+    {
+      return m_nPackets + 1 <= m_maxSize.GetValue ();
+    }
+  return m_nBytes + size <= m_maxSize.GetValue ();
+}
+
+void
+CoalescingQueue::PacketDequeued (void)
+{
+  if (m_devQueue != 0 && m_devQueue->IsStopped () && HasRoomFor (m_maxPacketSize))
+    {
+      m_devQueue->Wake ();
+    }
+}
+
+} // namespace ns3
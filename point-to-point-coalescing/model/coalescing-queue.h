@@ -0,0 +1,207 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_QUEUE_H
+#define COALESCING_QUEUE_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/queue-size.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class NetDeviceQueue;
+
+/**
+ * \ingroup point-to-point
+ * \brief Drop-tail transmit queue of a PointToPointCoalescingNetDevice
+ *
+ * Packets are kept in a ring buffer of contiguous slots whose size is a
+ * power of two, so enqueue and dequeue do not allocate once the buffer is
+ * large enough.  The number of packets and bytes in the queue are kept
+ * up to date on every operation.  All packets can be dequeued at once
+ * when the link wakes up and sends the queued burst.
+ *
+ * The queue fires the Enqueue, Dequeue and Drop trace sources with the
+ * same signatures as the ns-3 Queue, so the standard ascii trace sinks
+ * can be connected to it.
+ */
+class CoalescingQueue : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Construct an empty CoalescingQueue
+   */
+  CoalescingQueue ();
+
+  /**
+   * \brief Destroy a CoalescingQueue
+   */
+  virtual ~CoalescingQueue ();
+
+  /**
+   * \brief Place a packet at the tail of the queue
+   *
+   * \param p Packet to enqueue
+   * \return true if the packet was enqueued, false if it was dropped
+   */
+  bool Enqueue (Ptr<Packet> p);
+
+  /**
+   * \brief Remove the packet at the head of the queue
+   *
+   * \return The packet, or 0 if the queue is empty
+   */
+  Ptr<Packet> Dequeue (void);
+
+  /**
+   * \brief Remove all packets from the queue
+   *
+   * The packets are appended to the given vector in queue order and the
+   * Dequeue trace is fired for each of them.
+   *
+   * \param packets Vector which receives the packets
+   * \return The number of packets dequeued
+   */
+  uint32_t DequeueAll (std::vector<Ptr<Packet> > &packets);
+
+  /**
+   * \brief Get the packet at the head of the queue without removing it
+   *
+   * \return The packet, or 0 if the queue is empty
+   */
+  Ptr<const Packet> Peek (void) const;
+
+  /**
+   * \brief Drop all packets in the queue
+   */
+  void Flush (void);
+
+  /**
+   * \return true if the queue is empty
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \return The number of packets in the queue
+   */
+  uint32_t GetNPackets (void) const;
+
+  /**
+   * \return The number of bytes in the queue
+   */
+  uint32_t GetNBytes (void) const;
+
+  /**
+   * \return The number of packets dropped on enqueue
+   */
+  uint32_t GetTotalDroppedPackets (void) const;
+
+  /**
+   * \brief Set the maximum size of the queue
+   *
+   * \param size Maximum size in packets or bytes
+   */
+  void SetMaxSize (QueueSize size);
+
+  /**
+   * \return The maximum size of the queue
+   */
+  QueueSize GetMaxSize (void) const;
+
+  /**
+   * \brief Preallocate slots for the given number of packets
+   *
+   * The buffer is rounded up to a power of two and never shrinks.  It is
+   * not made larger than needed for the maximum size in packets.
+   *
+   * \param nPackets Number of packets the queue should hold without growing
+   */
+  void Reserve (uint32_t nPackets);
+
+  /**
+   * \return The number of packets the queue can hold without growing
+   */
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * \brief Stop and wake a device transmission queue as this queue fills
+   *
+   * The device queue is stopped when this queue has no room for a packet
+   * of the given size and woken when a dequeue makes room again.  This is
+   * what NetDeviceQueue::ConnectQueueTraces does for an ns-3 Queue.
+   *
+   * \param devQueue Device transmission queue
+   * \param maxPacketSize Size of the largest packet the device sends
+   */
+  void ConnectNetDeviceQueue (Ptr<NetDeviceQueue> devQueue, uint32_t maxPacketSize);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Move the packets into a larger buffer
+   *
+   * \param capacity New number of slots, a power of two
+   */
+  void Grow (uint32_t capacity);
+
+  /**
+   * \param size Packet size in bytes
+   * \return true if a packet of the given size fits into the queue
+   */
+  bool HasRoomFor (uint32_t size) const;
+
+  /**
+   * \brief Wake the device queue if a dequeue made room in this queue
+   */
+  void PacketDequeued (void);
+
+  std::vector<Ptr<Packet> > m_ring;      //!< Packet slots
+  uint32_t m_head;                       //!< Slot of the packet at the head
+  uint32_t m_mask;                       //!< Number of slots minus one
+  TracedValue<uint32_t> m_nPackets;      //!< Number of packets in the queue
+  TracedValue<uint32_t> m_nBytes;        //!< Number of bytes in the queue
+  uint32_t m_nTotalDroppedPackets;       //!< Number of packets dropped on enqueue
+  QueueSize m_maxSize;                   //!< Maximum size of the queue
+
+  Ptr<NetDeviceQueue> m_devQueue;        //!< Device queue to stop and wake
+  uint32_t m_maxPacketSize;              //!< Size of the largest packet of the device
+
+  /// Traced callback: fired when a packet is enqueued
+  TracedCallback<Ptr<const Packet> > m_traceEnqueue;
+  /// Traced callback: fired when a packet is dequeued
+  TracedCallback<Ptr<const Packet> > m_traceDequeue;
+  /// Traced callback: fired when a packet is dropped
+  TracedCallback<Ptr<const Packet> > m_traceDrop;
+};
+
+} // namespace ns3
+
+#endif /* COALESCING_QUEUE_H */
@@ -0,0 +1,380 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "coalescing-timer-wheel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoalescingTimerWheel");
+
+NS_OBJECT_ENSURE_REGISTERED (CoalescingTimerWheel);
+
+namespace {
+
+// time of no event
+const uint64_t NEVER = ~static_cast<uint64_t> (0);
+
+// slot of the entries being invoked
+const uint32_t DUE_SLOT = ~static_cast<uint32_t> (0) - 1;
+
+} // namespace
+
+TypeId
+CoalescingTimerWheel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoalescingTimerWheel")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<CoalescingTimerWheel> ()
+    .AddAttribute ("Granularity",
+                   "Duration of a slot of the first level of the wheel, which only "
+                   "affects the cost of the wheel since timers keep their exact time",
+                   TimeValue (MicroSeconds (1)),
+                   MakeTimeAccessor (&CoalescingTimerWheel::m_granularity),
+                   MakeTimeChecker (NanoSeconds (1)))
+  ;
+  return tid;
+}
+
+CoalescingTimerWheel::CoalescingTimerWheel ()
+  : m_granularityNs (1000),
+    m_tick (0),
+    m_free (NIL),
+    m_nPending (0),
+    m_seq (0),
+    m_nSimulatorEvents (0),
+    m_eventNs (NEVER)
+{
+  NS_LOG_FUNCTION (this);
+  std::fill (m_head, m_head + OVERFLOW_SLOT + 1, NIL);
+  std::fill (m_occupied, m_occupied + LEVELS, 0);
+}
+
+CoalescingTimerWheel::~CoalescingTimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CoalescingTimerWheel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  m_eventNs = NEVER;
+  m_entries.clear ();
+  m_free = NIL;
+  m_nPending = 0;
+  std::fill (m_head, m_head + OVERFLOW_SLOT + 1, NIL);
+  std::fill (m_occupied, m_occupied + LEVELS, 0);
+  Object::DoDispose ();
+}
+
+uint64_t
+CoalescingTimerWheel::GetTick (uint64_t timeNs) const
+{
+  return timeNs / m_granularityNs;
+}
+
+CoalescingTimerWheel::Timer
+CoalescingTimerWheel::Schedule (Time const &delay, const Ptr<EventImpl> &event)
+{
+  uint64_t nowNs = Simulator::Now ().GetNanoSeconds ();
+  if (m_nPending == 0)
+    {
+      // an empty wheel can restart from the current step with a new granularity
+      m_granularityNs = std::max<int64_t> (m_granularity.GetNanoSeconds (), 1);
+      m_tick = GetTick (nowNs);
+    }
+
+  uint32_t index = m_free;
+  if (index == NIL)
+    {
+      Entry e;
+      e.generation = 1;
+      m_entries.push_back (e);
+      index = m_entries.size () - 1;
+    }
+  else
+    {
+      m_free = m_entries[index].next;
+    }
+  Entry &e = m_entries[index];
+  e.timeNs = nowNs + delay.GetNanoSeconds ();
+  e.seq = m_seq++;
+  e.event = event;
+  Link (index);
+  m_nPending++;
+
+  ScheduleAt (e.timeNs);
+  return (static_cast<uint64_t> (e.generation) << 32) | index;
+}
+
+void
+CoalescingTimerWheel::Cancel (Timer timer)
+{
+  if (!IsRunning (timer))
+    {
+      return;
+    }
+  uint32_t index = timer & 0xffffffff;
+  if (m_entries[index].slot != DUE_SLOT)
+    {
+      Unlink (index);
+    }
+  Free (index);
+  m_nPending--;
+  // the event of the wheel is left in the simulator and finds nothing due
+}
+
+bool
+CoalescingTimerWheel::IsRunning (Timer timer) const
+{
+  uint32_t index = timer & 0xffffffff;
+  return timer != 0 && index < m_entries.size () && m_entries[index].generation == (timer >> 32)
+         && m_entries[index].slot != NIL;
+}
+
+uint32_t
+CoalescingTimerWheel::GetNPending (void) const
+{
+  return m_nPending;
+}
+
+uint64_t
+CoalescingTimerWheel::GetNScheduled (void) const
+{
+  return m_seq;
+}
+
+uint64_t
+CoalescingTimerWheel::GetNSimulatorEvents (void) const
+{
+  return m_nSimulatorEvents;
+}
+
+//
+// An entry goes to the lowest level whose slots, from the current step,
+// reach its step: level n when the steps agree above the bits of level n.
+// The slots of level n at or before the current one are then always empty,
+// and all entries of a level are later than those of the levels below.
+//
+void
+CoalescingTimerWheel::Link (uint32_t index)
+{
+  Entry &e = m_entries[index];
+  uint64_t tick = std::max (GetTick (e.timeNs), m_tick);
+  uint32_t slot = OVERFLOW_SLOT;
+  for (uint32_t level = 0; level < LEVELS; ++level)
+    {
+      uint32_t shift = SLOT_BITS * (level + 1);
+      if ((tick >> shift) == (m_tick >> shift))
+        {
+          uint32_t i = (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+          slot = level * SLOTS + i;
+          m_occupied[level] |= static_cast<uint64_t> (1) << i;
+          break;
+        }
+    }
+  e.slot = slot;
+  e.prev = NIL;
+  e.next = m_head[slot];
+  if (e.next != NIL)
+    {
+      m_entries[e.next].prev = index;
+    }
+  m_head[slot] = index;
+}
+
+void
+CoalescingTimerWheel::Unlink (uint32_t index)
+{
+  Entry &e = m_entries[index];
+  if (e.prev != NIL)
+    {
+      m_entries[e.prev].next = e.next;
+    }
+  else
+    {
+      m_head[e.slot] = e.next;
+    }
+  if (e.next != NIL)
+    {
+      m_entries[e.next].prev = e.prev;
+    }
+  if (m_head[e.slot] == NIL && e.slot != OVERFLOW_SLOT)
+    {
+      m_occupied[e.slot / SLOTS] &= ~(static_cast<uint64_t> (1) << (e.slot % SLOTS));
+    }
+}
+
+void
+CoalescingTimerWheel::Free (uint32_t index)
+{
+  Entry &e = m_entries[index];
+  e.event = 0;
+  e.slot = NIL;
+  e.generation++;
+  e.next = m_free;
+  m_free = index;
+}
+
+void
+CoalescingTimerWheel::Cascade (uint32_t slot)
+{
+  uint32_t index = m_head[slot];
+  m_head[slot] = NIL;
+  if (slot != OVERFLOW_SLOT)
+    {
+      m_occupied[slot / SLOTS] &= ~(static_cast<uint64_t> (1) << (slot % SLOTS));
+    }
+  while (index != NIL)
+    {
+      uint32_t next = m_entries[index].next;
+      Link (index);
+      index = next;
+    }
+}
+
+//
+// The wheel only moves to the time of its earliest timer, so the steps
+// skipped hold no entry of level 0 and only the starts of the occupied
+// slots of the higher levels need to be visited.
+//
+void
+CoalescingTimerWheel::Advance (uint64_t tick)
+{
+  while (m_tick < tick)
+    {
+      uint64_t next = tick;
+      for (uint32_t level = 1; level < LEVELS; ++level)
+        {
+          if (m_occupied[level] != 0)
+            {
+              uint32_t shift = SLOT_BITS * (level + 1);
+              uint64_t i = __builtin_ctzll (m_occupied[level]);
+              next = std::min (next, ((m_tick >> shift) << shift) | (i << (SLOT_BITS * level)));
+            }
+        }
+      uint32_t top = SLOT_BITS * LEVELS;
+      if (m_head[OVERFLOW_SLOT] != NIL)
+        {
+          next = std::min (next, ((m_tick >> top) + 1) << top);
+        }
+      m_tick = next;
+
+      if ((m_tick & ((static_cast<uint64_t> (1) << top) - 1)) == 0 && m_head[OVERFLOW_SLOT] != NIL)
+        {
+          Cascade (OVERFLOW_SLOT);
+        }
+      for (uint32_t level = LEVELS - 1; level > 0; --level)
+        {
+          uint32_t shift = SLOT_BITS * level;
+          uint32_t i = (m_tick >> shift) & (SLOTS - 1);
+          if ((m_tick & ((static_cast<uint64_t> (1) << shift) - 1)) == 0
+              && (m_occupied[level] & (static_cast<uint64_t> (1) << i)) != 0)
+            {
+              Cascade (level * SLOTS + i);
+            }
+        }
+    }
+}
+
+uint64_t
+CoalescingTimerWheel::GetNextTime (void) const
+{
+  uint32_t slot = OVERFLOW_SLOT;
+  for (uint32_t level = 0; level < LEVELS; ++level)
+    {
+      if (m_occupied[level] != 0)
+        {
+          slot = level * SLOTS + __builtin_ctzll (m_occupied[level]);
+          break;
+        }
+    }
+  uint64_t next = NEVER;
+  for (uint32_t index = m_head[slot]; index != NIL; index = m_entries[index].next)
+    {
+      next = std::min (next, m_entries[index].timeNs);
+    }
+  return next;
+}
+
+void
+CoalescingTimerWheel::ScheduleAt (uint64_t timeNs)
+{
+  if (timeNs >= m_eventNs)
+    {
+      return;
+    }
+  Simulator::Remove (m_event);
+  m_event = Simulator::Schedule (NanoSeconds (timeNs) - Simulator::Now (), &CoalescingTimerWheel::Expire, this);
+  m_eventNs = timeNs;
+  m_nSimulatorEvents++;
+}
+
+void
+CoalescingTimerWheel::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_eventNs = NEVER;
+  uint64_t nowNs = Simulator::Now ().GetNanoSeconds ();
+  Advance (GetTick (nowNs));
+
+  // the entries due now are in the slot of the current step
+  m_due.clear ();
+  uint32_t slot = m_tick & (SLOTS - 1);
+  uint32_t index = m_head[slot];
+  while (index != NIL)
+    {
+      uint32_t next = m_entries[index].next;
+      Entry &e = m_entries[index];
+      if (e.timeNs <= nowNs)
+        {
+          Unlink (index);
+          e.slot = DUE_SLOT;
+          m_due.push_back (std::make_pair (e.seq, (static_cast<uint64_t> (e.generation) << 32) | index));
+        }
+      index = next;
+    }
+  std::sort (m_due.begin (), m_due.end ());
+
+  for (std::size_t i = 0; i < m_due.size (); ++i)
+    {
+      // a timer invoked before may have cancelled this one
+      Timer timer = m_due[i].second;
+      if (!IsRunning (timer))
+        {
+          continue;
+        }
+      index = timer & 0xffffffff;
+      Ptr<EventImpl> event = m_entries[index].event;
+      Free (index);
+      m_nPending--;
+      event->Invoke ();
+    }
+
+  uint64_t next = GetNextTime ();
+  if (next != NEVER)
+    {
+      ScheduleAt (next);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,237 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef COALESCING_TIMER_WHEEL_H
+#define COALESCING_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Hierarchical timing wheel for the EEE timers of the devices of a node
+ *
+ * The coalescing timeout, sleep and wake-up events of all devices that
+ * share a wheel are kept in four levels of 64 slots instead of the event
+ * queue of the simulator.  A slot of level 0 spans one granularity step,
+ * a slot of level n 64^n steps, and timers further away than 64^4 steps
+ * wait in an overflow list.  Inserting and cancelling a timer unlink it
+ * from one slot, in constant time, and a slot of a higher level is moved
+ * down when the wheel reaches its start.
+ *
+ * Timers keep their exact time: the wheel has a single event in the
+ * simulator, at the time of its earliest timer, which runs all timers due
+ * at that time in the order they were inserted and schedules the next one.
+ * Only the order between the timers and other events of the same
+ * nanosecond can differ from that of events scheduled one by one.
+ *
+ * The events run in the context of the event that fires the wheel, which
+ * is the context of the node when the wheel is only used by the devices
+ * of one node.
+ */
+class CoalescingTimerWheel : public Object
+{
+public:
+  /// Handle of a timer, 0 for none
+  typedef uint64_t Timer;
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Construct a CoalescingTimerWheel
+   */
+  CoalescingTimerWheel ();
+
+  /**
+   * \brief Destroy a CoalescingTimerWheel
+   */
+  virtual ~CoalescingTimerWheel ();
+
+  /**
+   * \brief Schedule a method of an object, as Simulator::Schedule
+   *
+   * \param delay delay after which the method is invoked
+   * \param mem method
+   * \param obj object
+   * \return the handle of the timer
+   */
+  template <typename MEM, typename OBJ>
+  Timer Schedule (Time const &delay, MEM mem, OBJ obj);
+
+  /**
+   * \brief Schedule an event
+   *
+   * \param delay delay after which the event is invoked
+   * \param event event
+   * \return the handle of the timer
+   */
+  Timer Schedule (Time const &delay, const Ptr<EventImpl> &event);
+
+  /**
+   * \brief Cancel a timer
+   *
+   * Timers that already expired or were cancelled are ignored.
+   *
+   * \param timer handle of the timer
+   */
+  void Cancel (Timer timer);
+
+  /**
+   * \param timer handle of the timer
+   * \return true if the timer has neither expired nor been cancelled
+   */
+  bool IsRunning (Timer timer) const;
+
+  /**
+   * \return the number of pending timers
+   */
+  uint32_t GetNPending (void) const;
+
+  /**
+   * \return the number of timers scheduled so far
+   */
+  uint64_t GetNScheduled (void) const;
+
+  /**
+   * \return the number of events the wheel scheduled in the simulator
+   */
+  uint64_t GetNSimulatorEvents (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Number of levels
+  static const uint32_t LEVELS = 4;
+  /// Number of bits of the slot index
+  static const uint32_t SLOT_BITS = 6;
+  /// Number of slots of a level
+  static const uint32_t SLOTS = 1 << SLOT_BITS;
+  /// Index of the overflow list among the slots
+  static const uint32_t OVERFLOW_SLOT = LEVELS * SLOTS;
+  /// End of a list
+  static const uint32_t NIL = ~static_cast<uint32_t> (0);
+
+  /// Timer in a slot list
+  struct Entry
+  {
+    uint64_t timeNs;          //!< Time of expiry
+    uint64_t seq;             //!< Insertion order, for timers of the same time
+    Ptr<EventImpl> event;     //!< Event to invoke
+    uint32_t prev;            //!< Previous entry of the slot
+    uint32_t next;            //!< Next entry of the slot, or of the free list
+    uint32_t slot;            //!< Slot of the entry, NIL when free
+    uint32_t generation;      //!< Incremented when the entry is freed
+  };
+
+  /**
+   * \param timeNs time in nanoseconds
+   * \return the granularity step of the time
+   */
+  uint64_t GetTick (uint64_t timeNs) const;
+
+  /**
+   * \brief Put an entry in the slot of its time, relative to the current step
+   *
+   * \param index index of the entry
+   */
+  void Link (uint32_t index);
+
+  /**
+   * \brief Remove an entry from its slot
+   *
+   * \param index index of the entry
+   */
+  void Unlink (uint32_t index);
+
+  /**
+   * \brief Return an entry to the free list
+   *
+   * \param index index of the entry
+   */
+  void Free (uint32_t index);
+
+  /**
+   * \brief Move the current step forward, moving down the slots reached
+   *
+   * \param tick step to move to
+   */
+  void Advance (uint64_t tick);
+
+  /**
+   * \brief Move the entries of a slot to the slots of their time
+   *
+   * \param slot index of the slot
+   */
+  void Cascade (uint32_t slot);
+
+  /**
+   * \return the time of the earliest pending timer, or ~0
+   */
+  uint64_t GetNextTime (void) const;
+
+  /**
+   * \brief Schedule the event of the wheel at a time, if it is earlier
+   * than the scheduled one
+   *
+   * \param timeNs time in nanoseconds
+   */
+  void ScheduleAt (uint64_t timeNs);
+
+  /**
+   * \brief Invoke the timers due now
+   */
+  void Expire (void);
+
+  Time m_granularity;                //!< Granularity attribute
+  uint64_t m_granularityNs;          //!< Duration of a step of level 0, fixed while timers are pending
+  uint64_t m_tick;                   //!< Current step
+  std::vector<Entry> m_entries;      //!< Timers, pending and free
+  uint32_t m_free;                   //!< First free entry
+  uint32_t m_head[LEVELS * SLOTS + 1]; //!< First entry of each slot, overflow last
+  uint64_t m_occupied[LEVELS];       //!< Slots of each level which hold entries
+  uint32_t m_nPending;               //!< Number of pending timers
+  uint64_t m_seq;                    //!< Number of timers scheduled
+  uint64_t m_nSimulatorEvents;       //!< Number of events scheduled in the simulator
+  EventId m_event;                   //!< Event of the wheel in the simulator
+  uint64_t m_eventNs;                //!< Time of that event, ~0 if none
+  std::vector<std::pair<uint64_t, Timer> > m_due; //!< Timers being invoked, with their insertion order
+};
+
+template <typename MEM, typename OBJ>
+CoalescingTimerWheel::Timer
+CoalescingTimerWheel::Schedule (Time const &delay, MEM mem, OBJ obj)
+{
+  return Schedule (delay, Ptr<EventImpl> (MakeEvent (mem, obj), false));
+}
+
+} // namespace ns3
+
+#endif /* COALESCING_TIMER_WHEEL_H */
@@ -0,0 +1,198 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <cmath>
+#include "eee-analytical-model.h"
+
+namespace ns3 {
+
+EeeAnalyticalModel::Parameters
+EeeAnalyticalModel::GetDefaultParameters (void)
+{
+  Parameters p;
+  p.ts = 2.88e-6;
+  p.tw = 4.48e-6;
+  p.phiOff = 0.1;
+  p.nTerms = 3500;
+  return p;
+}
+
+EeeAnalyticalModel::EeeAnalyticalModel ()
+  : m_parameters (GetDefaultParameters ()),
+    m_hits (0)
+{
+}
+
+EeeAnalyticalModel::EeeAnalyticalModel (const Parameters &parameters)
+  : m_parameters (parameters),
+    m_hits (0)
+{
+}
+
+bool
+EeeAnalyticalModel::Key::operator < (const Key &o) const
+{
+  if (lambda != o.lambda)
+    {
+      return lambda < o.lambda;
+    }
+  if (ex != o.ex)
+    {
+      return ex < o.ex;
+    }
+  if (c != o.c)
+    {
+      return c < o.c;
+    }
+  return to < o.to;
+}
+
+void
+EeeAnalyticalModel::UpperGammaSeries (double x, std::vector<double> &q)
+{
+  if (q.empty ())
+    {
+      return;
+    }
+  q[0] = 0;
+  if (x == 0)
+    {
+      for (std::size_t n = 1; n < q.size (); ++n)
+        {
+          q[n] = 1;
+        }
+      return;
+    }
+
+  //
+  // Q(n + 1, x) = Q(n, x) + e^-x x^n / n!, with the terms computed in log
+  // space so that they neither overflow nor underflow on the way.
+  //
+  double logX = std::log (x);
+  double logTerm = -x;
+  double sum = 0;
+  for (std::size_t n = 1; n < q.size (); ++n)
+    {
+      if (n > 1)
+        {
+          logTerm += logX - std::log (static_cast<double> (n - 1));
+        }
+      sum += std::exp (logTerm);
+      q[n] = sum < 1 ? sum : 1;
+    }
+}
+
+EeeAnalyticalModel::Sums
+EeeAnalyticalModel::Compute (const Key &k)
+{
+  const double ts = m_parameters.ts;
+  const uint32_t n = m_parameters.nTerms;
+
+  double tpp = 1 / k.lambda;
+  double idle = tpp > ts ? tpp - ts : 0;
+  double as = k.lambda * ts;
+  double ao = k.lambda * k.to + k.lambda * (idle + ts);
+
+  m_qs.resize (n + 2);
+  m_qo.resize (n + 2);
+  UpperGammaSeries (as, m_qs);
+  UpperGammaSeries (ao, m_qo);
+
+  //
+  // Number of packets that make up the byte limit, Poisson with mean
+  // C / E[x], by the recurrence p(j) = p(j - 1) mean / j.
+  //
+  double mean = k.c / k.ex;
+  double logMean = std::log (mean);
+  double logP = -mean;
+
+  double s = 0;
+  double pTo = 0;
+  for (uint32_t j = 1; j < n; ++j)
+    {
+      logP += logMean - std::log (static_cast<double> (j));
+      double p = std::exp (logP);
+      double gs = (j + 1) * m_qs[j + 2] - as * m_qs[j + 1];
+      double go = (j + 1) * m_qo[j + 2] - ao * m_qo[j + 1];
+      s += p * (gs - go);
+      pTo += p * m_qo[j + 1];
+    }
+  s /= k.lambda;
+
+  Sums r;
+  r.eToff = (1 - pTo) * s + pTo * (k.to + idle - ts);
+  r.pTo = pTo;
+  return r;
+}
+
+EeeAnalyticalModel::Output
+EeeAnalyticalModel::Evaluate (const Input &in)
+{
+  Key k;
+  k.lambda = in.lambda;
+  k.ex = in.ex;
+  k.c = in.c;
+  k.to = in.to;
+
+  std::map<Key, Sums>::iterator it = m_memo.find (k);
+  if (it == m_memo.end ())
+    {
+      it = m_memo.insert (std::make_pair (k, Compute (k))).first;
+    }
+  else
+    {
+      m_hits++;
+    }
+
+  Output out;
+  out.eToff = it->second.eToff;
+  out.pTo = it->second.pTo;
+  out.phi = GetPhi (out.eToff, in.rho);
+  return out;
+}
+
+void
+EeeAnalyticalModel::Evaluate (const std::vector<Input> &in, std::vector<Output> &out)
+{
+  out.resize (in.size ());
+  for (std::size_t i = 0; i < in.size (); ++i)
+    {
+      out[i] = Evaluate (in[i]);
+    }
+}
+
+double
+EeeAnalyticalModel::GetPhi (double eToff, double rho) const
+{
+  const Parameters &p = m_parameters;
+  return 1 - (1 - p.phiOff) * (1 - rho) * eToff / (eToff + p.ts + p.tw);
+}
+
+uint64_t
+EeeAnalyticalModel::GetNHits (void) const
+{
+  return m_hits;
+}
+
+void
+EeeAnalyticalModel::Clear (void)
+{
+  m_memo.clear ();
+  m_hits = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,167 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#ifndef EEE_ANALYTICAL_MODEL_H
+#define EEE_ANALYTICAL_MODEL_H
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Analytical model of a port with byte based coalescing
+ *
+ * Computes the mean duration of the low-power state E[Toff] and the ratio
+ * phi of the energy consumed with and without EEE, for Poisson arrivals
+ * of rate lambda, mean packet size E[x], byte limit C and coalescing
+ * timeout To:
+ *
+ *   E[Toff] = (1 - P(To)) S + P(To) (To + max (1/lambda - Ts, 0) - Ts)
+ *   phi = 1 - (1 - phiOff) (1 - rho) E[Toff] / (E[Toff] + Ts + Tw)
+ *
+ * where S and P(To) are sums over the number of packets j which make up
+ * the byte limit, j Poisson distributed with mean C / E[x], of terms with
+ * regularized upper incomplete gamma functions Q(j + 1, .) and
+ * Q(j + 2, .).  These are the sums of etoff2 in calculate.py.
+ *
+ * The Poisson probabilities and the Q functions of consecutive j are
+ * computed by recurrences in log space, so each sum costs one pass over
+ * j.  Results are memoised on (lambda, E[x], C, To).
+ */
+class EeeAnalyticalModel
+{
+public:
+  /// Constants of the model
+  struct Parameters
+  {
+    double ts;        //!< Duration of transition to low power, in seconds
+    double tw;        //!< Duration of transition to active, in seconds
+    double phiOff;    //!< Power in low power relative to active power
+    uint32_t nTerms;  //!< Number of terms of the sums
+  };
+
+  /// Operating point of a port
+  struct Input
+  {
+    double lambda;    //!< Packet arrival rate, in packets per second
+    double ex;        //!< Mean packet size, in bytes
+    double c;         //!< Byte limit, in bytes
+    double to;        //!< Coalescing timeout, in seconds
+    double rho;       //!< Load of the port
+  };
+
+  /// Results of the model
+  struct Output
+  {
+    double eToff;     //!< Mean duration of the low-power state, in seconds
+    double pTo;       //!< Probability that the timeout ends the low-power state
+    double phi;       //!< Energy with EEE relative to energy without it
+  };
+
+  /**
+   * \return the parameters of calculate.py: Ts = 2.88 us, Tw = 4.48 us,
+   * phiOff = 0.1 and 3500 terms
+   */
+  static Parameters GetDefaultParameters (void);
+
+  EeeAnalyticalModel ();
+
+  /**
+   * \param parameters constants of the model
+   */
+  EeeAnalyticalModel (const Parameters &parameters);
+
+  /**
+   * \param in operating point of a port
+   * \return the results of the model
+   */
+  Output Evaluate (const Input &in);
+
+  /**
+   * \brief Evaluate the model for many ports
+   *
+   * Ports with the same (lambda, E[x], C, To) are computed once.
+   *
+   * \param in operating points of the ports
+   * \param out results, in the order of in
+   */
+  void Evaluate (const std::vector<Input> &in, std::vector<Output> &out);
+
+  /**
+   * \return number of evaluations answered from the memo
+   */
+  uint64_t GetNHits (void) const;
+
+  /**
+   * \brief Forget memoised results
+   */
+  void Clear (void);
+
+  /**
+   * \brief Energy ratio for a given E[Toff]
+   *
+   * \param eToff mean duration of the low-power state, in seconds
+   * \param rho load of the port
+   * \return phi
+   */
+  double GetPhi (double eToff, double rho) const;
+
+  /**
+   * \brief Regularized upper incomplete gamma function for integer a
+   *
+   * Fills q[n] = Q(n, x) for n = 0 .. q.size () - 1.
+   *
+   * \param x argument, non-negative
+   * \param q values to fill
+   */
+  static void UpperGammaSeries (double x, std::vector<double> &q);
+
+private:
+  /// Memo key
+  struct Key
+  {
+    double lambda;  //!< Arrival rate
+    double ex;      //!< Mean packet size
+    double c;       //!< Byte limit
+    double to;      //!< Timeout
+    /// \return true if this key orders before o
+    bool operator < (const Key &o) const;
+  };
+
+  /// Memoised part of the results, which does not depend on rho
+  struct Sums
+  {
+    double eToff;   //!< Mean duration of the low-power state
+    double pTo;     //!< Probability of timeout
+  };
+
+  /// Computes the sums of a key
+  Sums Compute (const Key &k);
+
+  Parameters m_parameters;            //!< Constants of the model
+  std::map<Key, Sums> m_memo;         //!< Memoised results
+  uint64_t m_hits;                    //!< Number of memo hits
+  std::vector<double> m_qs;           //!< Scratch Q (., lambda Ts)
+  std::vector<double> m_qo;           //!< Scratch Q (., lambda To')
+};
+
+} // namespace ns3
+
+#endif /* EEE_ANALYTICAL_MODEL_H */
@@ -18,12 +18,16 @@
  * by Natasa Maksic, maksicn@etf.rs
 */
 
+#include <algorithm>
+
 #include "point-to-point-coalescing-channel.h"
 #include "point-to-point-coalescing-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/channel-list.h"
 
 namespace ns3 {
 
@@ -65,7 +69,7 @@ PointToPointCoalescingChannel::PointToPointCoalescingChannel()
 }
 
 void
-PointToPointCoalescingChannel::Attach (Ptr<PointToPointCoalescingNetDevice> device)
+PointToPointCoalescingChannel::Attach (Ptr<PointToPointCoalescingNetDeviceBase> device)
 {
   NS_LOG_FUNCTION (this << device);
   NS_ASSERT_MSG (m_nDevices < N_DEVICES, "Only two devices permitted");
@@ -88,7 +92,7 @@ PointToPointCoalescingChannel::Attach (Ptr<PointToPointCoalescingNetDevice> devi
 bool
 PointToPointCoalescingChannel::TransmitStart (
   Ptr<const Packet> p,
-  Ptr<PointToPointCoalescingNetDevice> src,
+  Ptr<PointToPointCoalescingNetDeviceBase> src,
   Time txTime)
 {
   NS_LOG_FUNCTION (this << p << src);
@@ -99,15 +103,53 @@ PointToPointCoalescingChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
+  //
+  // The packet is not copied: the transmitting device hands it over and the
+  // receiving device becomes its only user.
+  //
   Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointCoalescingNetDevice::Receive,
-                                  m_link[wire].m_dst, p->Copy ());
+                                  txTime + m_delay, &PointToPointCoalescingNetDeviceBase::Receive,
+                                  m_link[wire].m_dst, ConstCast<Packet> (p));
 
   // Call the tx anim callback on the net device
   m_txrxPointToPointCoalescing (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
   return true;
 }
 
+bool
+PointToPointCoalescingChannel::TransmitBurst (
+  const std::vector<Ptr<Packet> > &packets,
+  const std::vector<Time> &txEnd,
+  Ptr<PointToPointCoalescingNetDeviceBase> src)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+  NS_ASSERT (packets.size () == txEnd.size ());
+
+  NS_ASSERT (m_link[0].m_state != INITIALIZING);
+  NS_ASSERT (m_link[1].m_state != INITIALIZING);
+
+  uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  Ptr<PointToPointCoalescingNetDeviceBase> dst = m_link[wire].m_dst;
+
+  //
+  // All packets of the burst travel in one receive event which delivers
+  // them at their own arrival times.  As for single packets, they are
+  // handed over without a copy.
+  //
+  Time now = Simulator::Now ();
+  Ptr<PointToPointCoalescingRxBurst> burst = Create<PointToPointCoalescingRxBurst> (dst, packets.size ());
+  for (std::size_t i = 0; i < packets.size (); ++i)
+    {
+      NS_LOG_LOGIC ("UID is " << packets[i]->GetUid () << ")");
+      burst->Add (packets[i], now + txEnd[i] + m_delay);
+
+      // Call the tx anim callback on the net device
+      m_txrxPointToPointCoalescing (packets[i], src, dst, txEnd[i], txEnd[i] + m_delay);
+    }
+  dst->ReceiveBurst (burst);
+  return true;
+}
+
 std::size_t
 PointToPointCoalescingChannel::GetNDevices (void) const
 {
@@ -115,7 +157,7 @@ PointToPointCoalescingChannel::GetNDevices (void) const
   return m_nDevices;
 }
 
-Ptr<PointToPointCoalescingNetDevice>
+Ptr<PointToPointCoalescingNetDeviceBase>
 PointToPointCoalescingChannel::GetPointToPointCoalescingDevice (std::size_t i) const
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -130,19 +172,53 @@ PointToPointCoalescingChannel::GetDevice (std::size_t i) const
   return GetPointToPointCoalescingDevice (i);
 }
 
+Time
+PointToPointCoalescingChannel::GetEarliestRemoteArrival (uint32_t systemId) const
+{
+  NS_LOG_FUNCTION (this << systemId);
+
+  Time earliest = Time::Max ();
+  for (uint32_t i = 0; i < m_nDevices; ++i)
+    {
+      Ptr<PointToPointCoalescingNetDeviceBase> src = GetSource (i);
+      Ptr<PointToPointCoalescingNetDeviceBase> dst = GetDestination (i);
+      if (dst != 0 && src->GetNode ()->GetSystemId () == systemId
+          && dst->GetNode ()->GetSystemId () != systemId)
+        {
+          earliest = std::min (earliest, src->GetEarliestTransmitTime () + GetDelay ());
+        }
+    }
+  return earliest;
+}
+
+Time
+PointToPointCoalescingChannel::GetEarliestArrival (uint32_t systemId)
+{
+  Time earliest = Time::Max ();
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); ++i)
+    {
+      Ptr<PointToPointCoalescingChannel> channel = DynamicCast<PointToPointCoalescingChannel> (*i);
+      if (channel != 0)
+        {
+          earliest = std::min (earliest, channel->GetEarliestRemoteArrival (systemId));
+        }
+    }
+  return earliest;
+}
+
 Time
 PointToPointCoalescingChannel::GetDelay (void) const
 {
   return m_delay;
 }
 
-Ptr<PointToPointCoalescingNetDevice>
+Ptr<PointToPointCoalescingNetDeviceBase>
 PointToPointCoalescingChannel::GetSource (uint32_t i) const
 {
   return m_link[i].m_src;
 }
 
-Ptr<PointToPointCoalescingNetDevice>
+Ptr<PointToPointCoalescingNetDeviceBase>
 PointToPointCoalescingChannel::GetDestination (uint32_t i) const
 {
   return m_link[i].m_dst;
@@ -22,6 +22,7 @@
 #define POINT_TO_POINT_COALESCING_CHANNEL_H
 
 #include <list>
+#include <vector>
 #include "ns3/channel.h"
 #include "ns3/ptr.h"
 #include "ns3/nstime.h"
@@ -30,7 +31,7 @@
 
 namespace ns3 {
 
-class PointToPointCoalescingNetDevice;
+class PointToPointCoalescingNetDeviceBase;
 class Packet;
 
 /**
@@ -71,16 +72,37 @@ public:
    * \brief Attach a given netdevice to this channel
    * \param device pointer to the netdevice to attach to the channel
    */
-  void Attach (Ptr<PointToPointCoalescingNetDevice> device);
+  void Attach (Ptr<PointToPointCoalescingNetDeviceBase> device);
 
   /**
    * \brief Transmit a packet over this channel
+   *
+   * The packet is delivered to the receiving device without a copy, so the
+   * caller must not use it once it has been received.
+   *
    * \param p Packet to transmit
-   * \param src Source PointToPointCoalescingNetDevice
+   * \param src Source PointToPointCoalescingNetDeviceBase
    * \param txTime Transmit time to apply
    * \returns true if successful (currently always true)
    */
-  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointCoalescingNetDevice> src, Time txTime);
+  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointCoalescingNetDeviceBase> src, Time txTime);
+
+  /**
+   * \brief Transmit a burst of back-to-back packets over this channel
+   *
+   * All packets of the burst are handed to the channel at the time the
+   * first bit of the first packet is put on the wire.  As in
+   * TransmitStart(), the packets are delivered without a copy.
+   *
+   * \param packets Packets to transmit, in transmission order
+   * \param txEnd Time at which the last bit of each packet is transmitted,
+   * relative to the start of the burst
+   * \param src Source PointToPointCoalescingNetDeviceBase
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitBurst (const std::vector<Ptr<Packet> > &packets,
+                              const std::vector<Time> &txEnd,
+                              Ptr<PointToPointCoalescingNetDeviceBase> src);
 
   /**
    * \brief Get number of devices on this channel
@@ -89,11 +111,11 @@ public:
   virtual std::size_t GetNDevices (void) const;
 
   /**
-   * \brief Get PointToPointCoalescingNetDevice corresponding to index i on this channel
+   * \brief Get PointToPointCoalescingNetDeviceBase corresponding to index i on this channel
    * \param i Index number of the device requested
-   * \returns Ptr to PointToPointCoalescingNetDevice requested
+   * \returns Ptr to PointToPointCoalescingNetDeviceBase requested
    */
-  Ptr<PointToPointCoalescingNetDevice> GetPointToPointCoalescingDevice (std::size_t i) const;
+  Ptr<PointToPointCoalescingNetDeviceBase> GetPointToPointCoalescingDevice (std::size_t i) const;
 
   /**
    * \brief Get NetDevice corresponding to index i on this channel
@@ -102,6 +124,34 @@ public:
    */
   virtual Ptr<NetDevice> GetDevice (std::size_t i) const;
 
+  /**
+   * \brief Get the earliest time at which a frame sent by a device of the
+   * given system can arrive at a device of another system
+   *
+   * Unlike the Delay, the bound depends on the coalescing state of the
+   * sending device: a port in low power cannot deliver a frame before it
+   * wakes up and the frame crosses the channel.
+   *
+   * \param systemId system id of the sending node
+   * \returns the earliest arrival time, or Time::Max () if the channel
+   * does not connect that system to another one
+   */
+  Time GetEarliestRemoteArrival (uint32_t systemId) const;
+
+  /**
+   * \brief Get the earliest time at which a frame sent by the given system
+   * can arrive at any other system
+   *
+   * Takes the minimum of GetEarliestRemoteArrival over all channels, so a
+   * synchronization layer may let the other systems advance to that time
+   * instead of the current time plus the smallest Delay.
+   *
+   * \param systemId system id of the sending nodes
+   * \returns the earliest arrival time, or Time::Max () if no channel
+   * connects that system to another one
+   */
+  static Time GetEarliestArrival (uint32_t systemId);
+
 protected:
   /**
    * \brief Get the delay associated with this channel
@@ -118,18 +168,18 @@ protected:
   /**
    * \brief Get the net-device source 
    * \param i the link requested
-   * \returns Ptr to PointToPointCoalescingNetDevice source for the 
+   * \returns Ptr to PointToPointCoalescingNetDeviceBase source for the 
    * specified link
    */
-  Ptr<PointToPointCoalescingNetDevice> GetSource (uint32_t i) const;
+  Ptr<PointToPointCoalescingNetDeviceBase> GetSource (uint32_t i) const;
 
   /**
    * \brief Get the net-device destination
    * \param i the link requested
-   * \returns Ptr to PointToPointCoalescingNetDevice destination for 
+   * \returns Ptr to PointToPointCoalescingNetDeviceBase destination for 
    * the specified link
    */
-  Ptr<PointToPointCoalescingNetDevice> GetDestination (uint32_t i) const;
+  Ptr<PointToPointCoalescingNetDeviceBase> GetDestination (uint32_t i) const;
 
   /**
    * TracedCallback signature for packet transmission animation events.
@@ -199,8 +249,8 @@ public:
     Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
 
     WireState                  m_state; //!< State of the link
-    Ptr<PointToPointCoalescingNetDevice> m_src;   //!< First NetDevice
-    Ptr<PointToPointCoalescingNetDevice> m_dst;   //!< Second NetDevice
+    Ptr<PointToPointCoalescingNetDeviceBase> m_src;   //!< First NetDevice
+    Ptr<PointToPointCoalescingNetDeviceBase> m_dst;   //!< Second NetDevice
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
@@ -20,58 +20,79 @@
 
 
 #include "ns3/log.h"
-#include "ns3/queue.h"
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
 #include "ns3/llc-snap-header.h"
 #include "ns3/error-model.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
+#include "ns3/enum.h"
+#include "ns3/mpi-interface.h"
 #include "point-to-point-coalescing-net-device.h"
 #include "point-to-point-coalescing-channel.h"
 #include "ppp-header-coalescing.h"
+#include "coalescing-measurement-sink.h"
+#include "coalescing-arrival-trace-sink.h"
+#include "coalescing-burst-header.h"
+#include "coalescing-partition-interface.h"
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
+#include <sstream>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointCoalescingNetDevice");
 
+NS_OBJECT_ENSURE_REGISTERED (PointToPointCoalescingNetDeviceBase);
 NS_OBJECT_ENSURE_REGISTERED (PointToPointCoalescingNetDevice);
+NS_OBJECT_ENSURE_REGISTERED (PointToPointCoalescingLeanNetDevice);
 
 TypeId 
-PointToPointCoalescingNetDevice::GetTypeId (void)
+PointToPointCoalescingNetDeviceBase::GetTypeId (void)
 {
-  static TypeId tid = TypeId ("ns3::PointToPointCoalescingNetDevice")
+  static TypeId tid = TypeId ("ns3::PointToPointCoalescingNetDeviceBase")
     .SetParent<NetDevice> ()
     .SetGroupName ("PointToPointCoalescing")
-    .AddConstructor<PointToPointCoalescingNetDevice> ()
     .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit",
                    UintegerValue (DEFAULT_MTU),
-                   MakeUintegerAccessor (&PointToPointCoalescingNetDevice::SetMtu,
-                                         &PointToPointCoalescingNetDevice::GetMtu),
+                   MakeUintegerAccessor (&PointToPointCoalescingNetDeviceBase::SetMtu,
+                                         &PointToPointCoalescingNetDeviceBase::GetMtu),
                    MakeUintegerChecker<uint16_t> ())
     .AddAttribute ("Address", 
                    "The MAC address of this device.",
                    Mac48AddressValue (Mac48Address ("ff:ff:ff:ff:ff:ff")),
-                   MakeMac48AddressAccessor (&PointToPointCoalescingNetDevice::m_address),
+                   MakeMac48AddressAccessor (&PointToPointCoalescingNetDeviceBase::m_address),
                    MakeMac48AddressChecker ())
     .AddAttribute ("DataRate", 
                    "The default data rate for point to point links",
                    DataRateValue (DataRate ("32768b/s")),
-                   MakeDataRateAccessor (&PointToPointCoalescingNetDevice::m_bps),
+                   MakeDataRateAccessor (&PointToPointCoalescingNetDeviceBase::m_bps),
                    MakeDataRateChecker ())
     .AddAttribute ("ReceiveErrorModel", 
                    "The receiver error model used to simulate packet loss",
                    PointerValue (),
-                   MakePointerAccessor (&PointToPointCoalescingNetDevice::m_receiveErrorModel),
+                   MakePointerAccessor (&PointToPointCoalescingNetDeviceBase::m_receiveErrorModel),
                    MakePointerChecker<ErrorModel> ())
     .AddAttribute ("InterframeGap", 
                    "The time to wait between packet (frame) transmissions",
                    TimeValue (Seconds (0.0)),
-                   MakeTimeAccessor (&PointToPointCoalescingNetDevice::m_tInterframeGap),
+                   MakeTimeAccessor (&PointToPointCoalescingNetDeviceBase::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("BurstTransmit",
+                   "If true, all packets waiting in the queue are transmitted "
+                   "as one back-to-back burst handed to the channel at once, "
+                   "with a single transmit complete event per burst, and "
+                   "PhyTxBurst reports the transmission times of each packet.  "
+                   "While a sink is connected to Sniffer, PromiscSniffer, "
+                   "PhyTxBegin or PhyTxEnd, these fire at the same times as "
+                   "without bursts, from one event per packet.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointCoalescingNetDeviceBase::m_burstTransmit),
+                   MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -80,151 +101,167 @@ PointToPointCoalescingNetDevice::GetTypeId (void)
     .AddAttribute ("TxQueue", 
                    "A queue to use as the transmit queue in the device.",
                    PointerValue (),
-                   MakePointerAccessor (&PointToPointCoalescingNetDevice::m_queue),
-                   MakePointerChecker<Queue<Packet> > ())
+                   MakePointerAccessor (&PointToPointCoalescingNetDeviceBase::m_queue),
+                   MakePointerChecker<CoalescingQueue> ())
 
     //
     // Energy Efficient Ethernet attributes
     //   
 	.AddAttribute ("EeeCoalescingTimeout", "EEE coalescing timeout in microseconds",
 					   DoubleValue (800),
- 					   MakeDoubleAccessor (&PointToPointCoalescingNetDevice::m_eeeTimeout),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeeTimeout),
 					   MakeDoubleChecker<double> ())
 	.AddAttribute ("EeeByteLimit", "EEE coalescing byte limit",
 					   DoubleValue (24000),
- 					   MakeDoubleAccessor (&PointToPointCoalescingNetDevice::m_eeeByteLimit),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::SetEeeByteLimit,
+ 					                       &PointToPointCoalescingNetDeviceBase::GetEeeByteLimit),
 					   MakeDoubleChecker<double> ())
+	.AddAttribute ("EeePacketLimit", "EEE coalescing packet limit of the PacketCount and Hybrid policies",
+					   UintegerValue (16),
+ 					   MakeUintegerAccessor (&PointToPointCoalescingNetDeviceBase::SetEeePacketLimit,
+ 					                        &PointToPointCoalescingNetDeviceBase::GetEeePacketLimit),
+					   MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("EeeLowByteLimit", "Bytes in the queue at or below which the Hysteresis policy goes to sleep",
+					   DoubleValue (0),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::SetEeeLowByteLimit,
+ 					                       &PointToPointCoalescingNetDeviceBase::GetEeeLowByteLimit),
+					   MakeDoubleChecker<double> (0))
+	.AddAttribute ("CoalescingPolicy", "Policy which decides when the link wakes up and goes to sleep",
+					   EnumValue (CoalescingPolicy::BYTE_LIMIT),
+ 					   MakeEnumAccessor (&PointToPointCoalescingNetDeviceBase::m_coalescingPolicy),
+					   MakeEnumChecker (CoalescingPolicy::BYTE_LIMIT, "ByteLimit",
+					                    CoalescingPolicy::TIMER_ONLY, "TimerOnly",
+					                    CoalescingPolicy::PACKET_COUNT, "PacketCount",
+					                    CoalescingPolicy::HYBRID, "Hybrid",
+					                    CoalescingPolicy::HYSTERESIS, "Hysteresis"))
 	.AddAttribute ("EeeSleepTime", "Duration of transition to low-power state in microseconds",
 					   DoubleValue (2.88),
- 					   MakeDoubleAccessor (&PointToPointCoalescingNetDevice::m_eeeSleepTime),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeeSleepTime),
 					   MakeDoubleChecker<double> ())
 	.AddAttribute ("EeeWakeUpTime", "Duration of transition to active state in microseconds",
 					   DoubleValue (4.48),
- 					   MakeDoubleAccessor (&PointToPointCoalescingNetDevice::m_eeeWakeupTime),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeeWakeupTime),
 					   MakeDoubleChecker<double> ())
 
     //
-    // Trace sources at the "top" of the net device, where packets transition
-    // to/from higher layers.
-    //
-    .AddTraceSource ("MacTx", 
-                     "Trace source indicating a packet has arrived "
-                     "for transmission by this device",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macTxTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("MacTxDrop", 
-                     "Trace source indicating a packet has been dropped "
-                     "by the device before transmission",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macTxDropTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("MacPromiscRx", 
-                     "A packet has been received by this device, "
-                     "has been passed up from the physical layer "
-                     "and is being forwarded up the local protocol stack.  "
-                     "This is a promiscuous trace,",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macPromiscRxTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("MacRx", 
-                     "A packet has been received by this device, "
-                     "has been passed up from the physical layer "
-                     "and is being forwarded up the local protocol stack.  "
-                     "This is a non-promiscuous trace,",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macRxTrace),
-                     "ns3::Packet::TracedCallback")
-#if 0
-    // Not currently implemented for this device
-    .AddTraceSource ("MacRxDrop", 
-                     "Trace source indicating a packet was dropped "
-                     "before being forwarded up the stack",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macRxDropTrace),
-                     "ns3::Packet::TracedCallback")
-#endif
-    //
-    // Trace sources at the "bottom" of the net device, where packets transition
-    // to/from the channel.
+    // Power profile of the port, in watts or relative to the power drawn
+    // while transmitting.  The transitions are at full power as in 802.3az.
     //
-    .AddTraceSource ("PhyTxBegin", 
-                     "Trace source indicating a packet has begun "
-                     "transmitting over the channel",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxBeginTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("PhyTxEnd", 
-                     "Trace source indicating a packet has been "
-                     "completely transmitted over the channel",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxEndTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("PhyTxDrop", 
-                     "Trace source indicating a packet has been "
-                     "dropped by the device during transmission",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxDropTrace),
-                     "ns3::Packet::TracedCallback")
-#if 0
-    // Not currently implemented for this device
-    .AddTraceSource ("PhyRxBegin", 
-                     "Trace source indicating a packet has begun "
-                     "being received by the device",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyRxBeginTrace),
-                     "ns3::Packet::TracedCallback")
-#endif
-    .AddTraceSource ("PhyRxEnd", 
-                     "Trace source indicating a packet has been "
-                     "completely received by the device",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyRxEndTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("PhyRxDrop", 
-                     "Trace source indicating a packet has been "
-                     "dropped by the device during reception",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyRxDropTrace),
-                     "ns3::Packet::TracedCallback")
+	.AddAttribute ("EeePowerTransmit", "Power drawn while transmitting",
+					   DoubleValue (1.0),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeePowerTransmit),
+					   MakeDoubleChecker<double> (0))
+	.AddAttribute ("EeePowerIdle", "Power drawn while active with nothing to transmit",
+					   DoubleValue (1.0),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeePowerIdle),
+					   MakeDoubleChecker<double> (0))
+	.AddAttribute ("EeePowerSleep", "Power drawn during transition to low-power state",
+					   DoubleValue (1.0),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeePowerSleep),
+					   MakeDoubleChecker<double> (0))
+	.AddAttribute ("EeePowerLowPower", "Power drawn in low-power state",
+					   DoubleValue (0.1),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeePowerLowPower),
+					   MakeDoubleChecker<double> (0))
+	.AddAttribute ("EeePowerWakeUp", "Power drawn during transition to active state",
+					   DoubleValue (1.0),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::m_eeePowerWakeUp),
+					   MakeDoubleChecker<double> (0))
 
     //
-    // Trace sources designed to simulate a packet sniffer facility (tcpdump).
-    // Note that there is really no difference between promiscuous and 
-    // non-promiscuous traces in a point-to-point link.
+    // Energy accounting results, read-only and up to date at any time.
     //
-    .AddTraceSource ("Sniffer", 
-                    "Trace source simulating a non-promiscuous packet sniffer "
-                     "attached to the device",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_snifferTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource ("PromiscSniffer", 
-                     "Trace source simulating a promiscuous packet sniffer "
-                     "attached to the device",
-                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_promiscSnifferTrace),
-                     "ns3::Packet::TracedCallback")
+	.AddAttribute ("ResidencyTransmit", "Time spent transmitting",
+					   TypeId::ATTR_GET,
+					   TimeValue (Seconds (0)),
+ 					   MakeTimeAccessor (&PointToPointCoalescingNetDeviceBase::GetResidencyTransmit),
+					   MakeTimeChecker ())
+	.AddAttribute ("ResidencyIdle", "Time spent active with nothing to transmit",
+					   TypeId::ATTR_GET,
+					   TimeValue (Seconds (0)),
+ 					   MakeTimeAccessor (&PointToPointCoalescingNetDeviceBase::GetResidencyIdle),
+					   MakeTimeChecker ())
+	.AddAttribute ("ResidencySleep", "Time spent in transition to low-power state",
+					   TypeId::ATTR_GET,
+					   TimeValue (Seconds (0)),
+ 					   MakeTimeAccessor (&PointToPointCoalescingNetDeviceBase::GetResidencySleep),
+					   MakeTimeChecker ())
+	.AddAttribute ("ResidencyLowPower", "Time spent in low-power state",
+					   TypeId::ATTR_GET,
+					   TimeValue (Seconds (0)),
+ 					   MakeTimeAccessor (&PointToPointCoalescingNetDeviceBase::GetResidencyLowPower),
+					   MakeTimeChecker ())
+	.AddAttribute ("ResidencyWakeUp", "Time spent in transition to active state",
+					   TypeId::ATTR_GET,
+					   TimeValue (Seconds (0)),
+ 					   MakeTimeAccessor (&PointToPointCoalescingNetDeviceBase::GetResidencyWakeUp),
+					   MakeTimeChecker ())
+	.AddAttribute ("EstimatorBatchSize", "Number of low-power intervals of a batch of the batch-means estimators",
+					   UintegerValue (32),
+ 					   MakeUintegerAccessor (&PointToPointCoalescingNetDeviceBase::SetEstimatorBatchSize,
+ 					                         &PointToPointCoalescingNetDeviceBase::GetEstimatorBatchSize),
+					   MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("RecordArrivals", "Record the time and size of every packet enqueued, "
+	               "to be written with WriteArrivalTrace and replayed without ns-3",
+					   BooleanValue (false),
+ 					   MakeBooleanAccessor (&PointToPointCoalescingNetDeviceBase::SetRecordArrivals,
+ 					                         &PointToPointCoalescingNetDeviceBase::GetRecordArrivals),
+					   MakeBooleanChecker ())
+	.AddAttribute ("TimerWheel", "Timer wheel which holds the coalescing timeout, sleep and wake-up "
+	               "events of the device instead of the scheduler of the simulator, shared by "
+	               "the devices of a node, or none",
+					   PointerValue (),
+ 					   MakePointerAccessor (&PointToPointCoalescingNetDeviceBase::m_timerWheel),
+					   MakePointerChecker<CoalescingTimerWheel> ())
+	.AddAttribute ("Energy", "Energy consumed according to the power profile",
+					   TypeId::ATTR_GET,
+					   DoubleValue (0),
+ 					   MakeDoubleAccessor (&PointToPointCoalescingNetDeviceBase::GetEnergy),
+					   MakeDoubleChecker<double> ())
+
   ;
   return tid;
 }
 
 
-PointToPointCoalescingNetDevice::PointToPointCoalescingNetDevice () 
+PointToPointCoalescingNetDeviceBase::PointToPointCoalescingNetDeviceBase () 
   :
     m_txMachineState (READY),
     m_channel (0),
     m_linkUp (false),
     m_currentPkt (0),
-    m_coalescingTimerCycle (0),
+    m_burstTransmit (false),
+    m_burstTraceIndex (0),
     m_coalescingState (COALESCING_LOWPOWER),
-    m_coalescingTimerState (false), 
+    m_coalescingWheelTimer (0),
     m_lpTimeNs(0),
     m_lpIntervals(0),
     m_packetCount(0),
     m_sumInterarrivalNs (0),
     m_lastPacketArrivalNs(0),
-    m_packetBytes(0)
+    m_packetBytes(0),
+    m_energy (CoalescingEnergyAccount::LOWPOWER, Simulator::Now ()),
+    m_estimatorBatchSize (32),
+    m_estimators (0),
+    m_arrivals (0)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC (Simulator::Now() << ": m_coalescingState = COALESCING_LOWPOWER initialize 1"); 
+  m_coalescingTimerCounters.scheduled = 0;
+  m_coalescingTimerCounters.cancelled = 0;
+  m_coalescingTimerCounters.fired = 0;
   m_lowPowerStart = Simulator::Now();
 }
 
-PointToPointCoalescingNetDevice::~PointToPointCoalescingNetDevice ()
+PointToPointCoalescingNetDeviceBase::~PointToPointCoalescingNetDeviceBase ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_estimators;
+  delete m_arrivals;
 }
 
 void
-PointToPointCoalescingNetDevice::AddHeader (Ptr<Packet> p, uint16_t protocolNumber)
+PointToPointCoalescingNetDeviceBase::AddHeader (Ptr<Packet> p, uint16_t protocolNumber)
 {
   NS_LOG_FUNCTION (this << p << protocolNumber);
   PppHeaderCoalescing ppp;
@@ -233,7 +270,7 @@ PointToPointCoalescingNetDevice::AddHeader (Ptr<Packet> p, uint16_t protocolNumb
 }
 
 bool
-PointToPointCoalescingNetDevice::ProcessHeader (Ptr<Packet> p, uint16_t& param)
+PointToPointCoalescingNetDeviceBase::ProcessHeader (Ptr<Packet> p, uint16_t& param)
 {
   NS_LOG_FUNCTION (this << p << param);
   PppHeaderCoalescing ppp;
@@ -243,104 +280,61 @@ PointToPointCoalescingNetDevice::ProcessHeader (Ptr<Packet> p, uint16_t& param)
 }
 
 void
-PointToPointCoalescingNetDevice::DoDispose ()
+PointToPointCoalescingNetDeviceBase::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
+  m_coalescingTimer.Cancel ();
+  if (m_timerWheel != 0)
+    {
+      m_timerWheel->Cancel (m_coalescingWheelTimer);
+    }
+  m_timerWheel = 0;
+  m_timeOutEvent = 0;
+  m_sleepEvent = 0;
+  m_wakeUpEvent = 0;
   m_node = 0;
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_burstPackets.clear ();
+  m_burstTxEnd.clear ();
   m_queue = 0;
   NetDevice::DoDispose ();
 }
 
 void
-PointToPointCoalescingNetDevice::SetDataRate (DataRate bps)
+PointToPointCoalescingNetDeviceBase::DoInitialize ()
 {
   NS_LOG_FUNCTION (this);
-  m_bps = bps;
-}
-
-void
-PointToPointCoalescingNetDevice::SetInterframeGap (Time t)
-{
-  NS_LOG_FUNCTION (this << t.GetSeconds ());
-  m_tInterframeGap = t;
-}
-
-bool
-PointToPointCoalescingNetDevice::TransmitStart (Ptr<Packet> p)
-{
-  NS_LOG_FUNCTION (this << p);
-  NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
 
   //
-  // This function is called to start the process of transmitting a packet.
-  // We need to tell the channel that we've started wiggling the wire and
-  // schedule an event that will be executed when the transmission is complete.
+  // While the link is in low power the queue fills up to the byte limit, so
+  // make room for that many minimum-size frames up front.
   //
-  NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
-  m_txMachineState = BUSY;
-  m_currentPkt = p;
-  m_phyTxBeginTrace (m_currentPkt);
-
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
-  Time txCompleteTime = txTime + m_tInterframeGap;
-
-  NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetNanoSeconds () << "ns");
-  Simulator::Schedule (txCompleteTime, &PointToPointCoalescingNetDevice::TransmitComplete, this);
-
-  bool result = m_channel->TransmitStart (p, this, txTime);
-  if (result == false)
+  const uint32_t minFrameSize = 64;
+  if (m_queue != 0)
     {
-      m_phyTxDropTrace (p);
+      m_queue->Reserve (static_cast<uint32_t> (m_policyParameters.byteLimit / minFrameSize) + 1);
     }
-
-  m_packetCount++;
-  m_packetBytes+=p->GetSize();
-
-  return result;
+  NetDevice::DoInitialize ();
 }
 
 void
-PointToPointCoalescingNetDevice::TransmitComplete (void)
+PointToPointCoalescingNetDeviceBase::SetDataRate (DataRate bps)
 {
   NS_LOG_FUNCTION (this);
+  m_bps = bps;
+}
 
-  NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": TransmitComplete");
-
-  //
-  // This function is called to when we're all done transmitting a packet.
-  // We try and pull another packet off of the transmit queue.  If the queue
-  // is empty, we are done, otherwise we need to start transmitting the
-  // next packet.
-  //
-  NS_ASSERT_MSG (m_txMachineState == BUSY, "Must be BUSY if transmitting");
-  m_txMachineState = READY;
-
-  NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointCoalescingNetDevice::TransmitComplete(): m_currentPkt zero");
-
-  m_phyTxEndTrace (m_currentPkt);
-  m_currentPkt = 0;
-
-  Ptr<Packet> p = m_queue->Dequeue ();
-  if (p == 0)
-    {
-      CoalescingQueueEmptied();
-      NS_LOG_LOGIC ("No pending packets in device queue after tx complete");
-      return;
-    }
-
-  //
-  // Got another packet off of the queue, so start the transmit process again.
-  //
-  m_snifferTrace (p);
-  m_promiscSnifferTrace (p);
-  TransmitStart (p);
+void
+PointToPointCoalescingNetDeviceBase::SetInterframeGap (Time t)
+{
+  NS_LOG_FUNCTION (this << t.GetSeconds ());
+  m_tInterframeGap = t;
 }
 
 bool
-PointToPointCoalescingNetDevice::Attach (Ptr<PointToPointCoalescingChannel> ch)
+PointToPointCoalescingNetDeviceBase::Attach (Ptr<PointToPointCoalescingChannel> ch)
 {
   NS_LOG_FUNCTION (this << &ch);
 
@@ -358,78 +352,54 @@ PointToPointCoalescingNetDevice::Attach (Ptr<PointToPointCoalescingChannel> ch)
 }
 
 void
-PointToPointCoalescingNetDevice::SetQueue (Ptr<Queue<Packet> > q)
+PointToPointCoalescingNetDeviceBase::SetQueue (Ptr<CoalescingQueue> q)
 {
   NS_LOG_FUNCTION (this << q);
   m_queue = q;
 }
 
 void
-PointToPointCoalescingNetDevice::SetReceiveErrorModel (Ptr<ErrorModel> em)
+PointToPointCoalescingNetDeviceBase::SetReceiveErrorModel (Ptr<ErrorModel> em)
 {
   NS_LOG_FUNCTION (this << em);
   m_receiveErrorModel = em;
 }
 
-void
-PointToPointCoalescingNetDevice::Receive (Ptr<Packet> packet)
+int64_t
+PointToPointCoalescingNetDeviceBase::AssignStreams (int64_t stream)
 {
-  NS_LOG_FUNCTION (this << packet);
-  uint16_t protocol = 0;
-
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) ) 
+  NS_LOG_FUNCTION (this << stream);
+  Ptr<RateErrorModel> rateErrorModel = DynamicCast<RateErrorModel> (m_receiveErrorModel);
+  if (rateErrorModel != 0)
     {
-      // 
-      // If we have an error model and it indicates that it is time to lose a
-      // corrupted packet, don't forward this packet up, let it go.
-      //
-      m_phyRxDropTrace (packet);
+      return rateErrorModel->AssignStreams (stream);
     }
-  else 
+  Ptr<BurstErrorModel> burstErrorModel = DynamicCast<BurstErrorModel> (m_receiveErrorModel);
+  if (burstErrorModel != 0)
     {
-      // 
-      // Hit the trace hooks.  All of these hooks are in the same place in this 
-      // device because it is so simple, but this is not usually the case in
-      // more complicated devices.
-      //
-      m_snifferTrace (packet);
-      m_promiscSnifferTrace (packet);
-      m_phyRxEndTrace (packet);
-
-      //
-      // Trace sinks will expect complete packets, not packets without some of the
-      // headers.
-      //
-      Ptr<Packet> originalPacket = packet->Copy ();
-
-      //
-      // Strip off the point-to-point protocol header and forward this packet
-      // up the protocol stack.  Since this is a simple point-to-point link,
-      // there is no difference in what the promisc callback sees and what the
-      // normal receive callback sees.
-      //
-      ProcessHeader (packet, protocol);
-
-      if (!m_promiscCallback.IsNull ())
-        {
-          m_macPromiscRxTrace (originalPacket);
-          m_promiscCallback (this, packet, protocol, GetRemote (), GetAddress (), NetDevice::PACKET_HOST);
-        }
-
-      m_macRxTrace (originalPacket);
-      m_rxCallback (this, packet, protocol, GetRemote ());
+      return burstErrorModel->AssignStreams (stream);
     }
+  return 0;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::ReceiveBurst (Ptr<PointToPointCoalescingRxBurst> burst)
+{
+  NS_LOG_FUNCTION (this << burst->GetNPackets ());
+  NS_ASSERT (burst->GetNPackets () > 0);
+  Simulator::ScheduleWithContext (GetNode ()->GetId (), burst->GetNextRxTime () - Simulator::Now (),
+                                  GetPointer (burst));
 }
 
-Ptr<Queue<Packet> >
-PointToPointCoalescingNetDevice::GetQueue (void) const
+Ptr<CoalescingQueue>
+PointToPointCoalescingNetDeviceBase::GetQueue (void) const
 { 
   NS_LOG_FUNCTION (this);
   return m_queue;
 }
 
 void
-PointToPointCoalescingNetDevice::NotifyLinkUp (void)
+PointToPointCoalescingNetDeviceBase::NotifyLinkUp (void)
 {
   NS_LOG_FUNCTION (this);
   m_linkUp = true;
@@ -437,20 +407,20 @@ PointToPointCoalescingNetDevice::NotifyLinkUp (void)
 }
 
 void
-PointToPointCoalescingNetDevice::SetIfIndex (const uint32_t index)
+PointToPointCoalescingNetDeviceBase::SetIfIndex (const uint32_t index)
 {
   NS_LOG_FUNCTION (this);
   m_ifIndex = index;
 }
 
 uint32_t
-PointToPointCoalescingNetDevice::GetIfIndex (void) const
+PointToPointCoalescingNetDeviceBase::GetIfIndex (void) const
 {
   return m_ifIndex;
 }
 
 Ptr<Channel>
-PointToPointCoalescingNetDevice::GetChannel (void) const
+PointToPointCoalescingNetDeviceBase::GetChannel (void) const
 {
   return m_channel;
 }
@@ -462,27 +432,27 @@ PointToPointCoalescingNetDevice::GetChannel (void) const
 // clients get and set the address, but simply ignore them.
 
 void
-PointToPointCoalescingNetDevice::SetAddress (Address address)
+PointToPointCoalescingNetDeviceBase::SetAddress (Address address)
 {
   NS_LOG_FUNCTION (this << address);
   m_address = Mac48Address::ConvertFrom (address);
 }
 
 Address
-PointToPointCoalescingNetDevice::GetAddress (void) const
+PointToPointCoalescingNetDeviceBase::GetAddress (void) const
 {
   return m_address;
 }
 
 bool
-PointToPointCoalescingNetDevice::IsLinkUp (void) const
+PointToPointCoalescingNetDeviceBase::IsLinkUp (void) const
 {
   NS_LOG_FUNCTION (this);
   return m_linkUp;
 }
 
 void
-PointToPointCoalescingNetDevice::AddLinkChangeCallback (Callback<void> callback)
+PointToPointCoalescingNetDeviceBase::AddLinkChangeCallback (Callback<void> callback)
 {
   NS_LOG_FUNCTION (this);
   m_linkChangeCallbacks.ConnectWithoutContext (callback);
@@ -493,7 +463,7 @@ PointToPointCoalescingNetDevice::AddLinkChangeCallback (Callback<void> callback)
 // all of the devices on the network.
 //
 bool
-PointToPointCoalescingNetDevice::IsBroadcast (void) const
+PointToPointCoalescingNetDeviceBase::IsBroadcast (void) const
 {
   NS_LOG_FUNCTION (this);
   return true;
@@ -505,113 +475,49 @@ PointToPointCoalescingNetDevice::IsBroadcast (void) const
 // broadcast address, so we make up something reasonable.
 //
 Address
-PointToPointCoalescingNetDevice::GetBroadcast (void) const
+PointToPointCoalescingNetDeviceBase::GetBroadcast (void) const
 {
   NS_LOG_FUNCTION (this);
   return Mac48Address ("ff:ff:ff:ff:ff:ff");
 }
 
 bool
-PointToPointCoalescingNetDevice::IsMulticast (void) const
+PointToPointCoalescingNetDeviceBase::IsMulticast (void) const
 {
   NS_LOG_FUNCTION (this);
   return true;
 }
 
 Address
-PointToPointCoalescingNetDevice::GetMulticast (Ipv4Address multicastGroup) const
+PointToPointCoalescingNetDeviceBase::GetMulticast (Ipv4Address multicastGroup) const
 {
   NS_LOG_FUNCTION (this);
   return Mac48Address ("01:00:5e:00:00:00");
 }
 
 Address
-PointToPointCoalescingNetDevice::GetMulticast (Ipv6Address addr) const
+PointToPointCoalescingNetDeviceBase::GetMulticast (Ipv6Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
   return Mac48Address ("33:33:00:00:00:00");
 }
 
 bool
-PointToPointCoalescingNetDevice::IsPointToPoint (void) const
+PointToPointCoalescingNetDeviceBase::IsPointToPoint (void) const
 {
   NS_LOG_FUNCTION (this);
   return true;
 }
 
 bool
-PointToPointCoalescingNetDevice::IsBridge (void) const
+PointToPointCoalescingNetDeviceBase::IsBridge (void) const
 {
   NS_LOG_FUNCTION (this);
   return false;
 }
 
 bool
-PointToPointCoalescingNetDevice::Send (
-  Ptr<Packet> packet, 
-  const Address &dest, 
-  uint16_t protocolNumber)
-{
-  NS_LOG_FUNCTION (this << packet << dest << protocolNumber);
-  NS_LOG_LOGIC ("p=" << packet << ", dest=" << &dest);
-  NS_LOG_LOGIC ("UID is " << packet->GetUid ());
-
-  //
-  // If IsLinkUp() is false it means there is no channel to send any packet 
-  // over so we just hit the drop trace on the packet and return an error.
-  //
-  if (IsLinkUp () == false)
-    {
-      m_macTxDropTrace (packet);
-      return false;
-    }
-
-  //
-  // Stick a point to point protocol header on the packet in preparation for
-  // shoving it out the door.
-  //
-  AddHeader (packet, protocolNumber);
-
-   
-
-  m_macTxTrace (packet);
-
-  //
-  // We should enqueue and dequeue the packet to hit the tracing hooks.
-  //
-  CoalescingCheckTimer(); 
-  if (m_queue->Enqueue (packet))
-    {
-      //
-      // If the channel is ready for transition we send the packet right now
-      //
-      double timeNs = Simulator::Now().GetNanoSeconds();
-      if (m_lastPacketArrivalNs > 0) 
-         m_sumInterarrivalNs += timeNs - m_lastPacketArrivalNs;
-
-      m_lastPacketArrivalNs = timeNs;
-      
-      CoalescingQueueLimit();
-      if (m_coalescingState == COALESCING_SEND)
-      if (m_txMachineState == READY)
-        {
-          packet = m_queue->Dequeue ();
-          m_snifferTrace (packet);
-          m_promiscSnifferTrace (packet);
-          bool ret = TransmitStart (packet);
-          return ret;
-        }
-      return true;
-    }
-
-  // Enqueue may fail (overflow)
-
-  m_macTxDropTrace (packet);
-  return false;
-}
-
-bool
-PointToPointCoalescingNetDevice::SendFrom (Ptr<Packet> packet, 
+PointToPointCoalescingNetDeviceBase::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
                                  const Address &dest, 
                                  uint16_t protocolNumber)
@@ -621,62 +527,91 @@ PointToPointCoalescingNetDevice::SendFrom (Ptr<Packet> packet,
 }
 
 Ptr<Node>
-PointToPointCoalescingNetDevice::GetNode (void) const
+PointToPointCoalescingNetDeviceBase::GetNode (void) const
 {
   return m_node;
 }
 
 void
-PointToPointCoalescingNetDevice::SetNode (Ptr<Node> node)
+PointToPointCoalescingNetDeviceBase::SetNode (Ptr<Node> node)
 {
   NS_LOG_FUNCTION (this);
   m_node = node;
 }
 
 bool
-PointToPointCoalescingNetDevice::NeedsArp (void) const
+PointToPointCoalescingNetDeviceBase::NeedsArp (void) const
 {
   NS_LOG_FUNCTION (this);
   return false;
 }
 
 void
-PointToPointCoalescingNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
+PointToPointCoalescingNetDeviceBase::SetReceiveCallback (NetDevice::ReceiveCallback cb)
 {
   m_rxCallback = cb;
 }
 
 void
-PointToPointCoalescingNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
+PointToPointCoalescingNetDeviceBase::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
 {
   m_promiscCallback = cb;
 }
 
 bool
-PointToPointCoalescingNetDevice::SupportsSendFrom (void) const
+PointToPointCoalescingNetDeviceBase::SupportsSendFrom (void) const
 {
   NS_LOG_FUNCTION (this);
   return false;
 }
 
 void
-PointToPointCoalescingNetDevice::DoMpiReceive (Ptr<Packet> p)
+PointToPointCoalescingNetDeviceBase::DoMpiReceive (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
   Receive (p);
 }
 
+void
+PointToPointCoalescingNetDeviceBase::DoMpiReceiveBurst (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  CoalescingBurstHeader header;
+  p->RemoveHeader (header);
+  NS_ASSERT (header.GetNFrames () > 0);
+
+  // the frames were serialized one by one, so they get back their uid and tags
+  std::vector<uint8_t> frames (p->GetSize ());
+  p->CopyData (&frames[0], frames.size ());
+
+  Time now = Simulator::Now ();
+  Ptr<PointToPointCoalescingRxBurst> burst = Create<PointToPointCoalescingRxBurst> (this, header.GetNFrames ());
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < header.GetNFrames (); ++i)
+    {
+      NS_ASSERT (offset + header.GetFrameSize (i) <= frames.size ());
+      burst->Add (Create<Packet> (&frames[offset], header.GetFrameSize (i), true), now + header.GetRxOffset (i));
+      offset += header.GetFrameSize (i);
+    }
+  ReceiveBurst (burst);
+}
+
 Address 
-PointToPointCoalescingNetDevice::GetRemote (void) const
+PointToPointCoalescingNetDeviceBase::GetRemote (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (!m_remote.IsInvalid ())
+    {
+      return m_remote;
+    }
   NS_ASSERT (m_channel->GetNDevices () == 2);
   for (std::size_t i = 0; i < m_channel->GetNDevices (); ++i)
     {
       Ptr<NetDevice> tmp = m_channel->GetDevice (i);
       if (tmp != this)
         {
-          return tmp->GetAddress ();
+          m_remote = tmp->GetAddress ();
+          return m_remote;
         }
     }
   NS_ASSERT (false);
@@ -685,7 +620,7 @@ PointToPointCoalescingNetDevice::GetRemote (void) const
 }
 
 bool
-PointToPointCoalescingNetDevice::SetMtu (uint16_t mtu)
+PointToPointCoalescingNetDeviceBase::SetMtu (uint16_t mtu)
 {
   NS_LOG_FUNCTION (this << mtu);
   m_mtu = mtu;
@@ -693,14 +628,14 @@ PointToPointCoalescingNetDevice::SetMtu (uint16_t mtu)
 }
 
 uint16_t
-PointToPointCoalescingNetDevice::GetMtu (void) const
+PointToPointCoalescingNetDeviceBase::GetMtu (void) const
 {
   NS_LOG_FUNCTION (this);
   return m_mtu;
 }
 
 uint16_t
-PointToPointCoalescingNetDevice::PppToEther (uint16_t proto)
+PointToPointCoalescingNetDeviceBase::PppToEther (uint16_t proto)
 {
   NS_LOG_FUNCTION_NOARGS();
   switch(proto)
@@ -713,7 +648,7 @@ PointToPointCoalescingNetDevice::PppToEther (uint16_t proto)
 }
 
 uint16_t
-PointToPointCoalescingNetDevice::EtherToPpp (uint16_t proto)
+PointToPointCoalescingNetDeviceBase::EtherToPpp (uint16_t proto)
 {
   NS_LOG_FUNCTION_NOARGS();
   switch(proto)
@@ -726,58 +661,827 @@ PointToPointCoalescingNetDevice::EtherToPpp (uint16_t proto)
 }
 
 
-void
-PointToPointCoalescingNetDevice::CoalescingTimeOut(uint64_t coalescingTimerCycle) {
-
+PointToPointCoalescingNetDeviceBase::CoalescingTimerCounters
+PointToPointCoalescingNetDeviceBase::GetCoalescingTimerCounters (void) const
+{
+  return m_coalescingTimerCounters;
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetStateResidency (CoalescingEnergyAccount::State state) const
+{
+  return m_energy.GetResidency (state, Simulator::Now ());
+}
+
+uint64_t
+PointToPointCoalescingNetDeviceBase::GetStateEntries (CoalescingEnergyAccount::State state) const
+{
+  return m_energy.GetEntries (state);
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetEarliestTransmitTime (void) const
+{
+  Time now = Simulator::Now ();
+  Time wakeUp = MicroSeconds (m_eeeWakeupTime);
+  switch (m_coalescingState)
+    {
+    case COALESCING_WAKEUP:
+      return std::max (now, m_coalescingTransitionEnd);
+    case COALESCING_SLEEP:
+      return std::max (now, m_coalescingTransitionEnd) + wakeUp;
+    case COALESCING_LOWPOWER:
+      // a policy which no queue wakes up leaves it to the timeout
+      if (!CoalescingWakeUpDue (std::numeric_limits<uint32_t>::max (), std::numeric_limits<uint32_t>::max ()))
+        {
+          Time timeOut = CoalescingTimerRunning () ? m_coalescingTimerEnd : now + MicroSeconds (m_eeeTimeout);
+          return std::max (now, timeOut) + wakeUp;
+        }
+      return now + wakeUp;
+    case COALESCING_SEND:
+    default:
+      return now;
+    }
+}
+
+double
+PointToPointCoalescingNetDeviceBase::GetEnergy (void) const
+{
+  double power[CoalescingEnergyAccount::N_STATES];
+  power[CoalescingEnergyAccount::TRANSMIT] = m_eeePowerTransmit;
+  power[CoalescingEnergyAccount::IDLE] = m_eeePowerIdle;
+  power[CoalescingEnergyAccount::SLEEP] = m_eeePowerSleep;
+  power[CoalescingEnergyAccount::LOWPOWER] = m_eeePowerLowPower;
+  power[CoalescingEnergyAccount::WAKEUP] = m_eeePowerWakeUp;
+  return m_energy.GetEnergy (power, Simulator::Now ());
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetResidencyTransmit (void) const
+{
+  return GetStateResidency (CoalescingEnergyAccount::TRANSMIT);
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetResidencyIdle (void) const
+{
+  return GetStateResidency (CoalescingEnergyAccount::IDLE);
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetResidencySleep (void) const
+{
+  return GetStateResidency (CoalescingEnergyAccount::SLEEP);
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetResidencyLowPower (void) const
+{
+  return GetStateResidency (CoalescingEnergyAccount::LOWPOWER);
+}
+
+Time
+PointToPointCoalescingNetDeviceBase::GetResidencyWakeUp (void) const
+{
+  return GetStateResidency (CoalescingEnergyAccount::WAKEUP);
+}
+
+void
+PointToPointCoalescingNetDeviceBase::EnableEstimators (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_estimators != 0)
+    {
+      return;
+    }
+  m_estimators = new CoalescingEstimators;
+  m_estimators->lowPower.SetBatchSize (m_estimatorBatchSize);
+  m_estimators->energyRatio.SetBatchSize (m_estimatorBatchSize);
+  m_estimators->started = false;
+  m_estimators->cycleEnergy = 0;
+}
+
+const CoalescingBatchMeans &
+PointToPointCoalescingNetDeviceBase::GetLowPowerEstimate (void) const
+{
+  static const CoalescingBatchMeans none;
+  return m_estimators != 0 ? m_estimators->lowPower : none;
+}
+
+const CoalescingBatchMeans &
+PointToPointCoalescingNetDeviceBase::GetEnergyRatioEstimate (void) const
+{
+  static const CoalescingBatchMeans none;
+  return m_estimators != 0 ? m_estimators->energyRatio : none;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::SetEstimatorBatchSize (uint32_t n)
+{
+  m_estimatorBatchSize = n;
+  if (m_estimators != 0)
+    {
+      m_estimators->lowPower.SetBatchSize (n);
+      m_estimators->energyRatio.SetBatchSize (n);
+    }
+}
+
+uint32_t
+PointToPointCoalescingNetDeviceBase::GetEstimatorBatchSize (void) const
+{
+  return m_estimatorBatchSize;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingCycleEnded(Time lowPower) {
+
+   if (m_estimators == 0) {
+      return;
+   }
+
+   Time now = Simulator::Now ();
+   double energy = GetEnergy ();
+   Time transmit = GetStateResidency (CoalescingEnergyAccount::TRANSMIT);
+
+   // the first cycle starts with the device and is not counted, as in
+   // m_lpTimeNs, nor is the one running when the estimators were enabled
+   if (m_lpIntervals > 0 && m_estimators->started) {
+      m_estimators->lowPower.Add (lowPower.GetSeconds ());
+
+      double tx = (transmit - m_estimators->cycleTransmit).GetSeconds ();
+      double idle = (now - m_estimators->cycleStart).GetSeconds () - tx;
+      double withoutEee = m_eeePowerTransmit * tx + m_eeePowerIdle * idle;
+      m_estimators->energyRatio.Add (energy - m_estimators->cycleEnergy, withoutEee);
+   }
+
+   m_estimators->started = true;
+   m_estimators->cycleStart = now;
+   m_estimators->cycleEnergy = energy;
+   m_estimators->cycleTransmit = transmit;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::SetRecordArrivals (bool record)
+{
+  if (m_arrivals == 0)
+    {
+      if (!record)
+        {
+          return;
+        }
+      m_arrivals = new CoalescingArrivals;
+    }
+  m_arrivals->record = record;
+}
+
+bool
+PointToPointCoalescingNetDeviceBase::GetRecordArrivals (void) const
+{
+  return m_arrivals != 0 && m_arrivals->record;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingArrival (uint32_t size) {
+
+   uint64_t now = Simulator::Now ().GetNanoSeconds ();
+   if (m_arrivals->record)
+      m_arrivals->encoder.Add (now, size);
+   for (std::size_t i = 0; i < m_arrivals->shadows.size (); ++i)
+      m_arrivals->shadows[i].Arrival (now, size);
+}
+
+void
+PointToPointCoalescingNetDeviceBase::UpdateEnergyState() {
+
+   CoalescingEnergyAccount::State state = CoalescingEnergyAccount::LOWPOWER;
+   switch (m_coalescingState) {
+      case COALESCING_SEND:
+         state = m_txMachineState == BUSY ? CoalescingEnergyAccount::TRANSMIT : CoalescingEnergyAccount::IDLE;
+         break;
+      case COALESCING_SLEEP:
+         state = CoalescingEnergyAccount::SLEEP;
+         break;
+      case COALESCING_LOWPOWER:
+         state = CoalescingEnergyAccount::LOWPOWER;
+         break;
+      case COALESCING_WAKEUP:
+         state = CoalescingEnergyAccount::WAKEUP;
+         break;
+   }
+   m_energy.SetState (state, Simulator::Now ());
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingTimeOut() {
+
    //NS_LOG_LOGIC ("CoalescingTimeOut");
+
+   m_coalescingTimerCounters.fired++;
    
-   if (coalescingTimerCycle == m_coalescingTimerCycle && m_coalescingState == COALESCING_LOWPOWER) {
-      m_coalescingTimerState = false;
+   if (m_coalescingState == COALESCING_LOWPOWER) {
       m_coalescingState = COALESCING_WAKEUP;
-      Simulator::Schedule (MicroSeconds (m_eeeWakeupTime), &PointToPointCoalescingNetDevice::CoalescingWakeUp, this);
+      UpdateEnergyState();
+      CoalescingSchedule (m_eeeWakeupTime, m_wakeUpEvent, &PointToPointCoalescingNetDeviceBase::CoalescingWakeUp);
       NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCINGWAKEUP on timeout");
    }
 }
 
-void
-PointToPointCoalescingNetDevice::CoalescingSleep() {
+void
+PointToPointCoalescingNetDeviceBase::CoalescingSleep() {
+
+   //NS_LOG_LOGIC ("CoalescingTimeOut");
+   
+   if (m_coalescingState == COALESCING_SLEEP) {
+      m_coalescingState = COALESCING_LOWPOWER;
+      UpdateEnergyState();
+      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_LOWPOWER");
+      m_lowPowerStart = Simulator::Now();
+   }
+}
+
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingCancelTimer() {
+
+   if (CoalescingTimerRunning ()) {
+      // remove the event from the scheduler instead of leaving it to expire
+      if (m_timerWheel != 0) {
+         m_timerWheel->Cancel (m_coalescingWheelTimer);
+         m_timeOutEvent->Disarm ();
+      }
+      else
+         Simulator::Remove (m_coalescingTimer);
+      m_coalescingTimerCounters.cancelled++;
+      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": coalescing timer cancelled");
+   }
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingQueueEmptied() {
+
+   // a new coalescing cycle starts, so a timer of the previous one must not fire
+   CoalescingCancelTimer();
+   m_coalescingState = COALESCING_SLEEP;
+   UpdateEnergyState();
+   CoalescingSchedule (m_eeeSleepTime, m_sleepEvent, &PointToPointCoalescingNetDeviceBase::CoalescingSleep);
+   NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_SLEEP");
+
+   // packets left by the policy are the first of the next cycle
+   if (!m_queue->IsEmpty ()) {
+      CoalescingStartTimer();
+      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": coalescing timer started for " << m_queue->GetNPackets () << " queued packets");
+   }
+   
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingQueueLimit(uint32_t queueBytes, uint32_t queuePackets) {
+
+   if (m_coalescingState == COALESCING_LOWPOWER && CoalescingWakeUpDue(queueBytes, queuePackets)) {
+      m_coalescingState = COALESCING_WAKEUP;
+      UpdateEnergyState();
+      CoalescingCancelTimer();
+      CoalescingSchedule (m_eeeWakeupTime, m_wakeUpEvent, &PointToPointCoalescingNetDeviceBase::CoalescingWakeUp);
+      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_WAKEUP on queue limit");
+   }
+
+}
+
+const CoalescingPolicy::Parameters &
+PointToPointCoalescingNetDeviceBase::GetPolicyParameters (void) const
+{
+  return m_policyParameters;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::SetEeeByteLimit (double byteLimit)
+{
+  m_policyParameters.byteLimit = byteLimit;
+}
+
+double
+PointToPointCoalescingNetDeviceBase::GetEeeByteLimit (void) const
+{
+  return m_policyParameters.byteLimit;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::SetEeePacketLimit (uint32_t packetLimit)
+{
+  m_policyParameters.packetLimit = packetLimit;
+}
+
+uint32_t
+PointToPointCoalescingNetDeviceBase::GetEeePacketLimit (void) const
+{
+  return m_policyParameters.packetLimit;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::SetEeeLowByteLimit (double lowByteLimit)
+{
+  m_policyParameters.lowByteLimit = lowByteLimit;
+}
+
+double
+PointToPointCoalescingNetDeviceBase::GetEeeLowByteLimit (void) const
+{
+  return m_policyParameters.lowByteLimit;
+}
+
+//
+// The policy classes only have static inline functions and the parameters
+// are kept up to date by the attribute setters, so the switch below is the
+// whole cost of choosing a policy per device.
+//
+bool
+PointToPointCoalescingNetDeviceBase::CoalescingWakeUpDue(uint32_t queueBytes, uint32_t queuePackets) const {
+
+   const CoalescingPolicy::Parameters &p = m_policyParameters;
+   switch (m_coalescingPolicy) {
+      case CoalescingPolicy::TIMER_ONLY:
+         return CoalescingTimerOnlyPolicy::WakeUp (p, queueBytes, queuePackets);
+      case CoalescingPolicy::PACKET_COUNT:
+         return CoalescingPacketCountPolicy::WakeUp (p, queueBytes, queuePackets);
+      case CoalescingPolicy::HYBRID:
+         return CoalescingHybridPolicy::WakeUp (p, queueBytes, queuePackets);
+      case CoalescingPolicy::HYSTERESIS:
+         return CoalescingHysteresisPolicy::WakeUp (p, queueBytes, queuePackets);
+      case CoalescingPolicy::BYTE_LIMIT:
+      default:
+         return CoalescingByteLimitPolicy::WakeUp (p, queueBytes, queuePackets);
+   }
+}
+
+bool
+PointToPointCoalescingNetDeviceBase::CoalescingSleepDue(uint32_t queueBytes, uint32_t queuePackets) const {
+
+   const CoalescingPolicy::Parameters &p = m_policyParameters;
+   switch (m_coalescingPolicy) {
+      case CoalescingPolicy::TIMER_ONLY:
+         return CoalescingTimerOnlyPolicy::Sleep (p, queueBytes, queuePackets);
+      case CoalescingPolicy::PACKET_COUNT:
+         return CoalescingPacketCountPolicy::Sleep (p, queueBytes, queuePackets);
+      case CoalescingPolicy::HYBRID:
+         return CoalescingHybridPolicy::Sleep (p, queueBytes, queuePackets);
+      case CoalescingPolicy::HYSTERESIS:
+         return CoalescingHysteresisPolicy::Sleep (p, queueBytes, queuePackets);
+      case CoalescingPolicy::BYTE_LIMIT:
+      default:
+         return CoalescingByteLimitPolicy::Sleep (p, queueBytes, queuePackets);
+   }
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingStartTimer() {
+
+   if (m_timerWheel != 0)
+      m_coalescingWheelTimer = CoalescingEvent::Schedule (m_timeOutEvent, MicroSeconds (m_eeeTimeout), this,
+                                                          &PointToPointCoalescingNetDeviceBase::CoalescingTimeOut, m_timerWheel);
+   else
+      m_coalescingTimer = CoalescingEvent::Schedule (m_timeOutEvent, MicroSeconds (m_eeeTimeout), this,
+                                                     &PointToPointCoalescingNetDeviceBase::CoalescingTimeOut);
+   m_coalescingTimerEnd = Simulator::Now () + MicroSeconds (m_eeeTimeout);
+   m_coalescingTimerCounters.scheduled++;
+}
+
+bool
+PointToPointCoalescingNetDeviceBase::CoalescingTimerRunning() const {
+
+   if (m_timerWheel != 0)
+      return m_timerWheel->IsRunning (m_coalescingWheelTimer);
+   return m_coalescingTimer.IsRunning ();
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingSchedule(double us, Ptr<CoalescingEvent> &event,
+                                                        void (PointToPointCoalescingNetDeviceBase::*handler) ()) {
+
+   m_coalescingTransitionEnd = Simulator::Now () + MicroSeconds (us);
+
+   if (m_timerWheel != 0)
+      CoalescingEvent::Schedule (event, MicroSeconds (us), this, handler, m_timerWheel);
+   else
+      CoalescingEvent::Schedule (event, MicroSeconds (us), this, handler);
+}
+
+void
+PointToPointCoalescingNetDeviceBase::CoalescingCheckTimer(uint32_t queueBytes) {
+
+   NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": queueBytes: " << queueBytes);
+
+   // The timer is started by the first packet of a low-power cycle.  Packets
+   // arriving while the link is awake are sent in the current cycle, so no
+   // timer is needed for them.
+   if (queueBytes == 0 && !CoalescingTimerRunning ()
+       && (m_coalescingState == COALESCING_SLEEP || m_coalescingState == COALESCING_LOWPOWER)) {
+      
+      CoalescingStartTimer();
+      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": coalescing timer started");
+   }
+}
+
+template <class Traces>
+bool
+PointToPointCoalescingNetDeviceImpl<Traces>::TransmitStart (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
+
+  //
+  // This function is called to start the process of transmitting a packet.
+  // We need to tell the channel that we've started wiggling the wire and
+  // schedule an event that will be executed when the transmission is complete.
+  //
+  NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
+  m_txMachineState = BUSY;
+  UpdateEnergyState ();
+  m_currentPkt = p;
+  this->TracePhyTxBegin (m_currentPkt);
+
+  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  Time txCompleteTime = txTime + m_tInterframeGap;
+
+  NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetNanoSeconds () << "ns");
+  PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceImpl>::Schedule (m_txCompleteEvent, txCompleteTime, this,
+                                                                                    &PointToPointCoalescingNetDeviceImpl<Traces>::TransmitComplete);
+
+  //
+  // The channel hands the packet to the receiver without a copy.  Without an
+  // interframe gap TransmitComplete, scheduled above, is done with the packet
+  // before it is received, otherwise the receiver gets its own copy.
+  //
+  Ptr<Packet> txPacket = m_tInterframeGap.IsZero () ? p : p->Copy ();
+  bool result = m_channel->TransmitStart (txPacket, this, txTime);
+  if (result == false)
+    {
+      this->TracePhyTxDrop (p);
+    }
+
+  m_packetCount++;
+  m_packetBytes+=p->GetSize();
+
+  return result;
+}
+
+template <class Traces>
+void
+PointToPointCoalescingNetDeviceImpl<Traces>::TransmitComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": TransmitComplete");
+
+  //
+  // This function is called to when we're all done transmitting a packet.
+  // We try and pull another packet off of the transmit queue.  If the queue
+  // is empty, we are done, otherwise we need to start transmitting the
+  // next packet.
+  //
+  NS_ASSERT_MSG (m_txMachineState == BUSY, "Must be BUSY if transmitting");
+  m_txMachineState = READY;
+  UpdateEnergyState ();
+
+  NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointCoalescingNetDeviceBase::TransmitComplete(): m_currentPkt zero");
+
+  this->TracePhyTxEnd (m_currentPkt);
+  m_currentPkt = 0;
+
+  if (CoalescingSleepDue (m_queue->GetNBytes (), m_queue->GetNPackets ()))
+    {
+      CoalescingQueueEmptied();
+      NS_LOG_LOGIC ("Link goes to sleep after tx complete with " << m_queue->GetNPackets () << " pending packets");
+      return;
+    }
+
+  //
+  // Got another packet off of the queue, so start the transmit process again.
+  //
+  Ptr<Packet> p = m_queue->Dequeue ();
+  this->TraceSniffer (p);
+  TransmitStart (p);
+}
+
+template <class Traces>
+bool
+PointToPointCoalescingNetDeviceImpl<Traces>::TransmitBurst (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  //
+  // This function is called to start the transmission of all packets that
+  // are waiting in the queue.  Packets are sent back to back, so the timing
+  // of the whole burst is known in advance.  We hand the burst to the channel
+  // at once.  A single event is scheduled for the time at which the last
+  // bit of the burst has been transmitted.  While a sink is connected to
+  // the per-packet trace sources, the same event is re-armed at every
+  // packet boundary instead, so that the sniffer and PHY traces fire at
+  // the times they would have fired for packets transmitted one by one.
+  //
+  NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
+  NS_ASSERT_MSG (m_burstPackets.empty (), "Previous burst not completed");
+  m_txMachineState = BUSY;
+  UpdateEnergyState ();
+
+  m_burstStart = Simulator::Now ();
+  Time txStart = Seconds (0);
+  m_queue->DequeueAll (m_burstPackets);
+  for (std::size_t i = 0; i < m_burstPackets.size (); ++i)
+    {
+      Ptr<Packet> p = m_burstPackets[i];
+
+      Time txEnd = txStart + m_bps.CalculateBytesTxTime (p->GetSize ());
+      this->TracePhyTxBurst (p, m_burstStart + txStart, m_burstStart + txEnd);
+
+      m_burstTxEnd.push_back (txEnd);
+
+      m_packetCount++;
+      m_packetBytes+=p->GetSize();
+
+      txStart = txEnd + m_tInterframeGap;
+    }
+
+  NS_ASSERT_MSG (!m_burstPackets.empty (), "Burst started on empty queue");
+
+  if (!this->HasPacketTxSinks ())
+    {
+      NS_LOG_LOGIC ("Schedule TransmitBurstComplete for " << m_burstPackets.size () << " packets in " << txStart.GetNanoSeconds () << "ns");
+      PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceImpl>::Schedule (m_txBurstCompleteEvent, txStart, this,
+                                                                                        &PointToPointCoalescingNetDeviceImpl<Traces>::TransmitBurstComplete);
+      bool result = m_channel->TransmitBurst (m_burstPackets, m_burstTxEnd, this);
+      for (std::size_t i = 0; i < m_burstPackets.size () && !result; ++i)
+        {
+          this->TracePhyTxDrop (m_burstPackets[i]);
+        }
+      m_burstPackets.clear ();
+      m_burstTxEnd.clear ();
+      return result;
+    }
+
+  //
+  // The first packet starts now.  The following packets start at the
+  // boundary events, after the end of the previous packet is traced.
+  //
+  this->TraceSniffer (m_burstPackets[0]);
+  this->TracePhyTxBegin (m_burstPackets[0]);
+
+  m_burstTraceIndex = 0;
+  NS_LOG_LOGIC ("Schedule TransmitBurstPacketComplete in " << (m_burstTxEnd[0] + m_tInterframeGap).GetNanoSeconds () << "ns");
+  PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceImpl>::Schedule (m_txBurstCompleteEvent, m_burstTxEnd[0] + m_tInterframeGap, this,
+                                                                                    &PointToPointCoalescingNetDeviceImpl<Traces>::TransmitBurstPacketComplete);
+
+  //
+  // The receiver may modify the packets it is handed before PhyTxEnd of
+  // a packet fires at the end of its interframe gap, so as in
+  // TransmitStart() the channel gets copies when the gap is not zero.
+  //
+  bool result;
+  if (m_tInterframeGap.IsZero ())
+    {
+      result = m_channel->TransmitBurst (m_burstPackets, m_burstTxEnd, this);
+    }
+  else
+    {
+      std::vector<Ptr<Packet> > txPackets;
+      txPackets.reserve (m_burstPackets.size ());
+      for (std::size_t i = 0; i < m_burstPackets.size (); ++i)
+        {
+          txPackets.push_back (m_burstPackets[i]->Copy ());
+        }
+      result = m_channel->TransmitBurst (txPackets, m_burstTxEnd, this);
+    }
+
+  if (result == false)
+    {
+      for (std::size_t i = 0; i < m_burstPackets.size (); ++i)
+        {
+          this->TracePhyTxDrop (m_burstPackets[i]);
+        }
+    }
+
+  return result;
+}
+
+template <class Traces>
+void
+PointToPointCoalescingNetDeviceImpl<Traces>::TransmitBurstPacketComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  //
+  // One packet of the burst and its interframe gap are done.  This is the
+  // time at which TransmitComplete() would have fired for it, and at which
+  // the next packet would have been started.
+  //
+  NS_ASSERT_MSG (m_burstTraceIndex < m_burstPackets.size (), "No packet of the burst in transmission");
+  this->TracePhyTxEnd (m_burstPackets[m_burstTraceIndex]);
+  m_burstTraceIndex++;
+
+  if (m_burstTraceIndex == m_burstPackets.size ())
+    {
+      m_burstPackets.clear ();
+      m_burstTxEnd.clear ();
+      TransmitBurstComplete ();
+      return;
+    }
+
+  Ptr<Packet> p = m_burstPackets[m_burstTraceIndex];
+  this->TraceSniffer (p);
+  this->TracePhyTxBegin (p);
+
+  Time next = m_burstStart + m_burstTxEnd[m_burstTraceIndex] + m_tInterframeGap - Simulator::Now ();
+  PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceImpl>::Schedule (m_txBurstCompleteEvent, next, this,
+                                                                                    &PointToPointCoalescingNetDeviceImpl<Traces>::TransmitBurstPacketComplete);
+}
+
+template <class Traces>
+void
+PointToPointCoalescingNetDeviceImpl<Traces>::TransmitBurstComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": TransmitBurstComplete");
+
+  NS_ASSERT_MSG (m_txMachineState == BUSY, "Must be BUSY if transmitting");
+  m_txMachineState = READY;
+  UpdateEnergyState ();
+
+  //
+  // Packets that arrived while the burst was on the wire form the next
+  // burst, unless the policy lets the link sleep.
+  //
+  if (CoalescingSleepDue (m_queue->GetNBytes (), m_queue->GetNPackets ()))
+    {
+      CoalescingQueueEmptied();
+      NS_LOG_LOGIC ("Link goes to sleep after burst complete with " << m_queue->GetNPackets () << " pending packets");
+      return;
+    }
+
+  TransmitBurst ();
+}
+
+template <class Traces>
+void
+PointToPointCoalescingNetDeviceImpl<Traces>::Receive (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  uint16_t protocol = 0;
+
+  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) ) 
+    {
+      // 
+      // If we have an error model and it indicates that it is time to lose a
+      // corrupted packet, don't forward this packet up, let it go.
+      //
+      this->TracePhyRxDrop (packet);
+    }
+  else 
+    {
+      // 
+      // Hit the trace hooks.  All of these hooks are in the same place in this 
+      // device because it is so simple, but this is not usually the case in
+      // more complicated devices.
+      //
+      this->TraceSniffer (packet);
+      this->TracePhyRxEnd (packet);
+
+      if (m_promiscCallback.IsNull ())
+        {
+          //
+          // Fast path: trace sinks expect complete packets, so the MacRx
+          // trace fires before the point-to-point protocol header is
+          // stripped off in place.  The packet is then forwarded up the
+          // protocol stack without a copy.
+          //
+          this->TraceMacRx (packet);
+          ProcessHeader (packet, protocol);
+          m_rxCallback (this, packet, protocol, GetRemote ());
+          return;
+        }
+
+      //
+      // The promiscuous consumer gets the stripped packet before the MAC
+      // traces are done with it, so the traces need a complete copy.
+      //
+      Ptr<Packet> originalPacket = Traces::IsEnabled ? packet->Copy () : packet;
+
+      //
+      // Strip off the point-to-point protocol header and forward this packet
+      // up the protocol stack.  Since this is a simple point-to-point link,
+      // there is no difference in what the promisc callback sees and what the
+      // normal receive callback sees.
+      //
+      ProcessHeader (packet, protocol);
+
+      this->TraceMacPromiscRx (originalPacket);
+      m_promiscCallback (this, packet, protocol, GetRemote (), GetAddress (), NetDevice::PACKET_HOST);
+
+      this->TraceMacRx (originalPacket);
+      m_rxCallback (this, packet, protocol, GetRemote ());
+    }
+}
+
+template <class Traces>
+bool
+PointToPointCoalescingNetDeviceImpl<Traces>::Send (
+  Ptr<Packet> packet, 
+  const Address &dest, 
+  uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << dest << protocolNumber);
+  NS_LOG_LOGIC ("p=" << packet << ", dest=" << &dest);
+  NS_LOG_LOGIC ("UID is " << packet->GetUid ());
+
+  //
+  // If IsLinkUp() is false it means there is no channel to send any packet 
+  // over so we just hit the drop trace on the packet and return an error.
+  //
+  if (IsLinkUp () == false)
+    {
+      this->TraceMacTxDrop (packet);
+      return false;
+    }
+
+  //
+  // Stick a point to point protocol header on the packet in preparation for
+  // shoving it out the door.
+  //
+  AddHeader (packet, protocolNumber);
 
-   //NS_LOG_LOGIC ("CoalescingTimeOut");
    
-   if (m_coalescingState == COALESCING_SLEEP) {
-      m_coalescingState = COALESCING_LOWPOWER;
-      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_LOWPOWER");
-      m_lowPowerStart = Simulator::Now();
-   }
-}
 
+  this->TraceMacTx (packet);
 
-void
-PointToPointCoalescingNetDevice::CoalescingQueueEmptied() {
+  //
+  // We should enqueue and dequeue the packet to hit the tracing hooks.
+  //
+  uint32_t queueBytes = m_queue->GetNBytes ();
+  CoalescingCheckTimer(queueBytes); 
+  if (m_queue->Enqueue (packet))
+    {
+      //
+      // If the channel is ready for transition we send the packet right now
+      //
+      double timeNs = Simulator::Now().GetNanoSeconds();
+      if (m_lastPacketArrivalNs > 0) 
+         m_sumInterarrivalNs += timeNs - m_lastPacketArrivalNs;
 
-   m_coalescingTimerCycle++;
-   m_coalescingState = COALESCING_SLEEP;
-   Simulator::Schedule (MicroSeconds (m_eeeWakeupTime), &PointToPointCoalescingNetDevice::CoalescingSleep, this);
-   NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_SLEEP");
-   
+      m_lastPacketArrivalNs = timeNs;
+      if (m_arrivals != 0)
+         CoalescingArrival (packet->GetSize ());
+      
+      CoalescingQueueLimit(queueBytes + packet->GetSize (), m_queue->GetNPackets ());
+      if (m_coalescingState == COALESCING_SEND)
+      if (m_txMachineState == READY)
+        {
+          if (m_burstTransmit)
+            {
+              return TransmitBurst ();
+            }
+          packet = m_queue->Dequeue ();
+          this->TraceSniffer (packet);
+          bool ret = TransmitStart (packet);
+          return ret;
+        }
+      return true;
+    }
+
+  // Enqueue may fail (overflow)
+
+  this->TraceMacTxDrop (packet);
+  return false;
 }
 
+template <class Traces>
 void
-PointToPointCoalescingNetDevice::CoalescingWakeUp() {
+PointToPointCoalescingNetDeviceImpl<Traces>::CoalescingWakeUp() {
 
    //NS_LOG_LOGIC ("CoalescingTimeOut");
    
    if (m_coalescingState == COALESCING_WAKEUP) {
       m_coalescingState = COALESCING_SEND;
+      UpdateEnergyState();
       NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_SEND " << m_lpIntervals);
 
       // update counters
+      Time t = Simulator::Now() - m_lowPowerStart;
       if (m_lpIntervals > 0) {
-         Time t = Simulator::Now() - m_lowPowerStart;
          m_lpTimeNs+=t.GetNanoSeconds () ;
       }
+      CoalescingCycleEnded(t);
 
       m_lpIntervals++;
+
+      // send all queued packets at once in burst mode
+      if (m_burstTransmit) {
+         if (m_queue->IsEmpty ()) {
+            CoalescingQueueEmptied();
+            NS_LOG_LOGIC ("Error:No pending packets in device queue after wakeup");
+            return;
+         }
+         TransmitBurst ();
+         return;
+      }
    
       // start sending it there are packets
       Ptr<Packet> p = m_queue->Dequeue ();
@@ -791,62 +1495,335 @@ PointToPointCoalescingNetDevice::CoalescingWakeUp() {
   //
   // Got another packet off of the queue, so start the transmit process again.
   //
-  m_snifferTrace (p);
-  m_promiscSnifferTrace (p);
+  this->TraceSniffer (p);
   TransmitStart (p);
 
    }
 }
 
-void
-PointToPointCoalescingNetDevice::CoalescingQueueLimit() {
+//
+// The datapath is compiled once with and once without trace sources.
+//
+template class PointToPointCoalescingNetDeviceImpl<PointToPointCoalescingDeviceTraces>;
+template class PointToPointCoalescingNetDeviceImpl<PointToPointCoalescingNoTraces>;
+
+TypeId 
+PointToPointCoalescingNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PointToPointCoalescingNetDevice")
+    .SetParent<PointToPointCoalescingNetDeviceBase> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<PointToPointCoalescingNetDevice> ()
+    //
+    // Trace sources at the "top" of the net device, where packets transition
+    // to/from higher layers.
+    //
+    .AddTraceSource ("MacTx", 
+                     "Trace source indicating a packet has arrived "
+                     "for transmission by this device",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macTxTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("MacTxDrop", 
+                     "Trace source indicating a packet has been dropped "
+                     "by the device before transmission",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macTxDropTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("MacPromiscRx", 
+                     "A packet has been received by this device, "
+                     "has been passed up from the physical layer "
+                     "and is being forwarded up the local protocol stack.  "
+                     "This is a promiscuous trace,",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macPromiscRxTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("MacRx", 
+                     "A packet has been received by this device, "
+                     "has been passed up from the physical layer "
+                     "and is being forwarded up the local protocol stack.  "
+                     "This is a non-promiscuous trace,",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macRxTrace),
+                     "ns3::Packet::TracedCallback")
+#if 0
+    // Not currently implemented for this device
+    .AddTraceSource ("MacRxDrop", 
+                     "Trace source indicating a packet was dropped "
+                     "before being forwarded up the stack",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_macRxDropTrace),
+                     "ns3::Packet::TracedCallback")
+#endif
+    //
+    // Trace sources at the "bottom" of the net device, where packets transition
+    // to/from the channel.
+    //
+    .AddTraceSource ("PhyTxBegin", 
+                     "Trace source indicating a packet has begun "
+                     "transmitting over the channel",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxBeginTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("PhyTxEnd", 
+                     "Trace source indicating a packet has been "
+                     "completely transmitted over the channel",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxEndTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("PhyTxBurst", 
+                     "Trace source indicating a packet has been handed "
+                     "to the channel as part of a burst, with the times "
+                     "of its first and last transmitted bit",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxBurstTrace),
+                     "ns3::PointToPointCoalescingNetDevice::BurstTxTracedCallback")
+    .AddTraceSource ("PhyTxDrop", 
+                     "Trace source indicating a packet has been "
+                     "dropped by the device during transmission",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyTxDropTrace),
+                     "ns3::Packet::TracedCallback")
+#if 0
+    // Not currently implemented for this device
+    .AddTraceSource ("PhyRxBegin", 
+                     "Trace source indicating a packet has begun "
+                     "being received by the device",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyRxBeginTrace),
+                     "ns3::Packet::TracedCallback")
+#endif
+    .AddTraceSource ("PhyRxEnd", 
+                     "Trace source indicating a packet has been "
+                     "completely received by the device",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyRxEndTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("PhyRxDrop", 
+                     "Trace source indicating a packet has been "
+                     "dropped by the device during reception",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_phyRxDropTrace),
+                     "ns3::Packet::TracedCallback")
 
-   uint32_t queueBytes = m_queue->GetNBytes();
+    //
+    // Trace sources designed to simulate a packet sniffer facility (tcpdump).
+    // Note that there is really no difference between promiscuous and 
+    // non-promiscuous traces in a point-to-point link.
+    //
+    .AddTraceSource ("Sniffer", 
+                    "Trace source simulating a non-promiscuous packet sniffer "
+                     "attached to the device",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_snifferTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("PromiscSniffer", 
+                     "Trace source simulating a promiscuous packet sniffer "
+                     "attached to the device",
+                     MakeTraceSourceAccessor (&PointToPointCoalescingNetDevice::m_promiscSnifferTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
 
-   if (m_coalescingState == COALESCING_LOWPOWER && queueBytes >= m_eeeByteLimit) {
-      m_coalescingState = COALESCING_WAKEUP;
-      m_coalescingTimerState = false;
-      Simulator::Schedule (MicroSeconds (m_eeeWakeupTime), &PointToPointCoalescingNetDevice::CoalescingWakeUp, this);
-      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingState = COALESCING_WAKEUP on byte limit");
-   }
+PointToPointCoalescingNetDevice::PointToPointCoalescingNetDevice ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PointToPointCoalescingNetDevice::~PointToPointCoalescingNetDevice ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId 
+PointToPointCoalescingLeanNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PointToPointCoalescingLeanNetDevice")
+    .SetParent<PointToPointCoalescingNetDeviceBase> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<PointToPointCoalescingLeanNetDevice> ()
+  ;
+  return tid;
+}
 
+PointToPointCoalescingLeanNetDevice::PointToPointCoalescingLeanNetDevice ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PointToPointCoalescingLeanNetDevice::~PointToPointCoalescingLeanNetDevice ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PointToPointCoalescingRxBurst::PointToPointCoalescingRxBurst (Ptr<PointToPointCoalescingNetDeviceBase> device, std::size_t n)
+  : m_device (device),
+    m_next (0)
+{
+  m_packets.reserve (n);
+  m_rxTime.reserve (n);
 }
 
 void
-PointToPointCoalescingNetDevice::CoalescingCheckTimer() {
+PointToPointCoalescingRxBurst::Add (Ptr<Packet> p, Time rxTime)
+{
+  NS_ASSERT (m_rxTime.empty () || m_rxTime.back () <= rxTime);
+  m_packets.push_back (p);
+  m_rxTime.push_back (rxTime);
+}
 
-   uint32_t queueBytes = m_queue->GetNBytes();
-   
-   NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": queueBytes: " << queueBytes);
+Time
+PointToPointCoalescingRxBurst::GetNextRxTime (void) const
+{
+  return m_rxTime[m_next];
+}
 
-   // Checks m_coalescingTimerState = false in order not to repeat 
-   if (queueBytes == 0 && m_coalescingTimerState == false) {
-      
-      Simulator::Schedule (MicroSeconds (m_eeeTimeout), &PointToPointCoalescingNetDevice::CoalescingTimeOut, this, m_coalescingTimerCycle);
-      m_coalescingTimerState = true;
-      NS_LOG_LOGIC (Simulator::Now() << " switch: " << GetNode()->GetId() << " " << GetIfIndex() << ": m_coalescingTimerState = true");
-   }
+std::size_t
+PointToPointCoalescingRxBurst::GetNPackets (void) const
+{
+  return m_packets.size ();
+}
+
+void
+PointToPointCoalescingRxBurst::Notify (void)
+{
+  Ptr<Packet> p = m_packets[m_next];
+  m_packets[m_next] = 0;
+  m_next++;
+
+  //
+  // Re-arm before delivering, so that the next packet is ordered before
+  // events that the receive path schedules for the same time.
+  //
+  if (m_next < m_packets.size ())
+    {
+      Simulator::Schedule (m_rxTime[m_next] - Simulator::Now (), Ptr<EventImpl> (this));
+    }
+
+  m_device->Receive (p);
+}
+
+CoalescingMeasurementRecord
+PointToPointCoalescingNetDeviceBase::GetMeasurementRecord (void) const
+{
+  CoalescingMeasurementRecord r;
+  r.nodeId = GetNode ()->GetId ();
+  r.ifIndex = GetIfIndex ();
+  r.lpTimeNs = m_lpTimeNs;
+  // first interval is not added to m_lpTimeNs because flows may start later in the simulation
+  r.lpIntervals = m_lpIntervals > 0 ? m_lpIntervals - 1 : 0;
+  r.packetCount = m_packetCount;
+  r.packetBytes = m_packetBytes;
+  r.meanInterarrival = m_packetCount > 1 ? m_sumInterarrivalNs / 1e9 / (m_packetCount - 1) : 0;
+  r.dataRate = m_bps.GetBitRate ();
+  return r;
 }
 
 void 
-PointToPointCoalescingNetDevice::WriteMeasurementsData (std::string s) {
+PointToPointCoalescingNetDeviceBase::WriteMeasurementsData (Ptr<CoalescingMeasurementSink> sink) const
+{
+  if (!IsLocal ())
+    {
+      return;
+    }
+  sink->Write (GetMeasurementRecord ());
+}
 
-  std::ofstream outfile;
-  outfile.open("data.txt", std::ios_base::app); // append instead of overwrite
-  uint64_t linkspeed = 0;
-  if (s.compare("10Gbps") == 0) 
-      linkspeed = 10000000000;
-  if (s.compare("1Gbps") == 0) 
-      linkspeed = 1000000000;
-  if (s.compare("5Gbps") == 0) 
-      linkspeed = 5000000000;
-  if (m_lpIntervals > 0)
-      m_lpIntervals--; // first interval is not added to m_lpTimeNs because flows may start later in the simulation
-  outfile << GetNode()->GetId() << " " << GetIfIndex() << " " << m_lpTimeNs << " " << m_lpIntervals << " " << m_packetCount << " " << m_packetBytes << " " << m_sumInterarrivalNs / 1e9 / (m_packetCount-1) << " " << linkspeed << std::endl; 
+bool
+PointToPointCoalescingNetDeviceBase::IsLocal (void) const
+{
+  //
+  // Every system creates all nodes, but only simulates its own, so the
+  // devices of the other nodes have nothing to report.
+  //
+  if (CoalescingPartitionInterface::IsEnabled ())
+    {
+      return GetNode ()->GetSystemId () == CoalescingPartitionInterface::GetPartition ();
+    }
+  if (MpiInterface::IsEnabled ())
+    {
+      return GetNode ()->GetSystemId () == MpiInterface::GetSystemId ();
+    }
+  return true;
+}
+
+void
+PointToPointCoalescingNetDeviceBase::WriteArrivalTrace (Ptr<CoalescingArrivalTraceSink> sink) const
+{
+  if (!IsLocal ())
+    {
+      return;
+    }
+  static const CoalescingArrivalEncoder none;
+  sink->Add (GetNode ()->GetId (), GetIfIndex (), m_bps.GetBitRate (), m_arrivals != 0 ? m_arrivals->encoder : none);
+}
+
+CoalescingModel::Parameters
+PointToPointCoalescingNetDeviceBase::GetShadowParameters (void) const
+{
+  CoalescingModel::Parameters p;
+  p.policy = m_coalescingPolicy;
+  p.limits = GetPolicyParameters ();
+  p.timeout = m_eeeTimeout;
+  p.sleepTime = m_eeeSleepTime;
+  p.wakeUpTime = m_eeeWakeupTime;
+  p.dataRate = m_bps.GetBitRate ();
+  p.interframeGapNs = m_tInterframeGap.GetNanoSeconds ();
+  p.burstTransmit = m_burstTransmit;
+  p.power[CoalescingModel::TRANSMIT] = m_eeePowerTransmit;
+  p.power[CoalescingModel::IDLE] = m_eeePowerIdle;
+  p.power[CoalescingModel::SLEEP] = m_eeePowerSleep;
+  p.power[CoalescingModel::LOWPOWER] = m_eeePowerLowPower;
+  p.power[CoalescingModel::WAKEUP] = m_eeePowerWakeUp;
+  return p;
+}
+
+uint32_t
+PointToPointCoalescingNetDeviceBase::AddShadow (const CoalescingModel::Parameters &p)
+{
+  if (m_arrivals == 0)
+    {
+      m_arrivals = new CoalescingArrivals;
+      m_arrivals->record = false;
+    }
+  m_arrivals->shadows.push_back (CoalescingModel (p));
+  return m_arrivals->shadows.size () - 1;
+}
+
+uint32_t
+PointToPointCoalescingNetDeviceBase::GetNShadows (void) const
+{
+  return m_arrivals != 0 ? m_arrivals->shadows.size () : 0;
+}
+
+CoalescingModel
+PointToPointCoalescingNetDeviceBase::GetShadow (uint32_t i) const
+{
+  NS_ASSERT (i < GetNShadows ());
+  CoalescingModel shadow = m_arrivals->shadows[i];
+  shadow.Finish (Simulator::Now ().GetNanoSeconds ());
+  return shadow;
+}
 
+void
+PointToPointCoalescingNetDeviceBase::WriteShadowData (std::ostream &os) const
+{
+  if (!IsLocal ())
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < GetNShadows (); ++i)
+    {
+      CoalescingModel shadow = GetShadow (i);
+      const CoalescingModel::Parameters &p = shadow.GetParameters ();
+      CoalescingMeasurementRecord r = shadow.GetMeasurementRecord (GetNode ()->GetId (), GetIfIndex ());
+      double withoutEee = shadow.GetEnergyWithoutEee ();
+      os << r.nodeId << " " << r.ifIndex << " " << i << " " << CoalescingPolicy::GetName (p.policy) << " "
+         << p.timeout << " " << p.limits.byteLimit << " " << p.limits.packetLimit << " "
+         << r.lpTimeNs << " " << r.lpIntervals << " " << (r.lpIntervals > 0 ? 1e-9 * r.lpTimeNs / r.lpIntervals : 0) << " "
+         << (withoutEee > 0 ? shadow.GetEnergy () / withoutEee : 0) << " " << shadow.GetMeanDelay () << std::endl;
+    }
+}
 
+void 
+PointToPointCoalescingNetDeviceBase::WriteMeasurementsData (std::string s) {
 
+  if (!IsLocal ())
+    return;
 
+  CoalescingMeasurementRecord r = GetMeasurementRecord ();
+  std::string path = CoalescingMeasurementSink::GetSystemPath ("data.txt");
+  std::ofstream outfile;
+  outfile.open(path.c_str (), std::ios_base::app); // append instead of overwrite
+  outfile << r.nodeId << " " << r.ifIndex << " " << r.lpTimeNs << " " << r.lpIntervals << " " << r.packetCount << " " << r.packetBytes << " " << r.meanInterarrival << " " << r.dataRate << std::endl; 
 }
 
 } // namespace ns3
@@ -22,6 +22,8 @@
 #define POINT_TO_POINT_COALESCING_NET_DEVICE_H
 
 #include <cstring>
+#include <iosfwd>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -32,6 +34,17 @@
 #include "ns3/data-rate.h"
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
+#include "ns3/event-impl.h"
+#include "ns3/event-id.h"
+#include "ns3/simulator.h"
+#include "coalescing-queue.h"
+#include "coalescing-measurement-format.h"
+#include "coalescing-energy-account.h"
+#include "coalescing-policy.h"
+#include "coalescing-batch-means.h"
+#include "coalescing-arrival-trace.h"
+#include "coalescing-model.h"
+#include "coalescing-timer-wheel.h"
 
 
 // identifiers of coalescing states
@@ -52,9 +65,194 @@
 
 namespace ns3 {
 
-template <typename Item> class Queue;
 class PointToPointCoalescingChannel;
+class PointToPointCoalescingNetDeviceBase;
 class ErrorModel;
+class CoalescingMeasurementSink;
+class CoalescingArrivalTraceSink;
+
+/**
+ * \ingroup point-to-point
+ * \brief Packets of a burst travelling to a PointToPointCoalescingNetDeviceBase.
+ *
+ * The burst is delivered by one event which is re-armed for the arrival
+ * time of each of its packets, so a burst occupies a single slot in the
+ * scheduler regardless of the number of packets it carries.
+ */
+class PointToPointCoalescingRxBurst : public EventImpl
+{
+public:
+  /**
+   * Create an empty burst.
+   *
+   * \param device the device receiving the burst
+   * \param n the expected number of packets
+   */
+  PointToPointCoalescingRxBurst (Ptr<PointToPointCoalescingNetDeviceBase> device, std::size_t n);
+
+  /**
+   * Append a packet to the burst.
+   *
+   * \param p the packet
+   * \param rxTime the absolute time at which the last bit of the packet
+   * arrives at the device
+   */
+  void Add (Ptr<Packet> p, Time rxTime);
+
+  /**
+   * \returns the arrival time of the first packet not yet delivered
+   */
+  Time GetNextRxTime (void) const;
+
+  /**
+   * \returns the number of packets in the burst
+   */
+  std::size_t GetNPackets (void) const;
+
+protected:
+  /**
+   * Deliver the next packet and re-arm the event for the following one.
+   */
+  virtual void Notify (void);
+
+private:
+  Ptr<PointToPointCoalescingNetDeviceBase> m_device; //!< Receiving device
+  std::vector<Ptr<Packet> > m_packets;           //!< Packets in arrival order
+  std::vector<Time> m_rxTime;                    //!< Absolute arrival time of each packet
+  std::size_t m_next;                            //!< Index of the next packet to deliver
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Re-armable event which invokes a method of a device.
+ *
+ * A device keeps one such event for each of its recurring events, the end
+ * of a transmission and the transitions of the coalescing state machine,
+ * and schedules the same event again once it has run, so that these
+ * events do not allocate.  The event is replaced by a new one only if it
+ * is still pending, or if it was removed from the simulator, which leaves
+ * it cancelled for good.
+ *
+ * The event holds a plain pointer to the device, as the events made by
+ * Simulator::Schedule for a method of the device.
+ */
+template <class DEVICE>
+class PointToPointCoalescingDeviceEvent : public EventImpl
+{
+public:
+  /// Method of the device invoked by the event
+  typedef void (DEVICE::*Handler) (void);
+
+  /**
+   * \param device the device
+   * \param handler the method invoked
+   */
+  PointToPointCoalescingDeviceEvent (DEVICE *device, Handler handler);
+
+  /**
+   * Schedule an event in the simulator.
+   *
+   * \param event the event, created or replaced if it cannot be reused
+   * \param delay the delay after which the method is invoked
+   * \param device the device
+   * \param handler the method invoked
+   * \returns the id of the event in the simulator
+   */
+  static EventId Schedule (Ptr<PointToPointCoalescingDeviceEvent> &event, const Time &delay,
+                           DEVICE *device, Handler handler);
+
+  /**
+   * Schedule an event in a timer wheel.
+   *
+   * \param event the event, created or replaced if it cannot be reused
+   * \param delay the delay after which the method is invoked
+   * \param device the device
+   * \param handler the method invoked
+   * \param wheel the timer wheel
+   * \returns the handle of the timer
+   */
+  static CoalescingTimerWheel::Timer Schedule (Ptr<PointToPointCoalescingDeviceEvent> &event, const Time &delay,
+                                               DEVICE *device, Handler handler, Ptr<CoalescingTimerWheel> wheel);
+
+  /**
+   * Mark the event as no longer pending after its timer was cancelled in a
+   * timer wheel, which drops the event without cancelling it.
+   */
+  void Disarm (void);
+
+protected:
+  /**
+   * Invoke the method of the device.
+   */
+  virtual void Notify (void);
+
+private:
+  /**
+   * Make an event ready to be scheduled, reusing it if it can be.
+   *
+   * \param event the event, created or replaced if it cannot be reused
+   * \param device the device
+   * \param handler the method invoked
+   */
+  static void Arm (Ptr<PointToPointCoalescingDeviceEvent> &event, DEVICE *device, Handler handler);
+
+  DEVICE *m_device;    //!< Device
+  Handler m_handler;   //!< Method invoked
+  bool m_armed;        //!< The event is pending
+};
+
+template <class DEVICE>
+PointToPointCoalescingDeviceEvent<DEVICE>::PointToPointCoalescingDeviceEvent (DEVICE *device, Handler handler)
+  : m_device (device),
+    m_handler (handler),
+    m_armed (false)
+{
+}
+
+template <class DEVICE>
+void
+PointToPointCoalescingDeviceEvent<DEVICE>::Arm (Ptr<PointToPointCoalescingDeviceEvent> &event, DEVICE *device, Handler handler)
+{
+  if (event == 0 || event->m_armed || event->IsCancelled ())
+    {
+      event = Create<PointToPointCoalescingDeviceEvent> (device, handler);
+    }
+  event->m_armed = true;
+}
+
+template <class DEVICE>
+EventId
+PointToPointCoalescingDeviceEvent<DEVICE>::Schedule (Ptr<PointToPointCoalescingDeviceEvent> &event, const Time &delay,
+                                                     DEVICE *device, Handler handler)
+{
+  Arm (event, device, handler);
+  return Simulator::Schedule (delay, Ptr<EventImpl> (event));
+}
+
+template <class DEVICE>
+CoalescingTimerWheel::Timer
+PointToPointCoalescingDeviceEvent<DEVICE>::Schedule (Ptr<PointToPointCoalescingDeviceEvent> &event, const Time &delay,
+                                                     DEVICE *device, Handler handler, Ptr<CoalescingTimerWheel> wheel)
+{
+  Arm (event, device, handler);
+  return wheel->Schedule (delay, Ptr<EventImpl> (event));
+}
+
+template <class DEVICE>
+void
+PointToPointCoalescingDeviceEvent<DEVICE>::Disarm (void)
+{
+  m_armed = false;
+}
+
+template <class DEVICE>
+void
+PointToPointCoalescingDeviceEvent<DEVICE>::Notify (void)
+{
+  // disarmed first, so that the method can schedule the event again
+  m_armed = false;
+  ((*m_device).*m_handler) ();
+}
 
 /**
  * \defgroup point-to-point Point-To-Point Network Device
@@ -67,18 +265,24 @@ class ErrorModel;
 
 /**
  * \ingroup point-to-point
- * \class PointToPointCoalescingNetDevice
+ * \class PointToPointCoalescingNetDeviceBase
  * \brief A Device for a Point to Point Network Link.
  *
- * This PointToPointCoalescingNetDevice class specializes the NetDevice abstract
+ * This PointToPointCoalescingNetDeviceBase class specializes the NetDevice abstract
  * base class.  Together with a PointToPointCoalescingChannel (and a peer 
- * PointToPointCoalescingNetDevice), the class models, with some level of 
+ * PointToPointCoalescingNetDeviceBase), the class models, with some level of 
  * abstraction, a generic point-to-point or serial link.
  * Key parameters or objects that can be specified for this device 
  * include a queue, data rate, and interframe transmission gap (the 
  * propagation delay is set in the PointToPointCoalescingChannel).
+ *
+ * The class holds the configuration, the coalescing state machine and
+ * the measurement counters shared by all variants of the device.  The
+ * packet datapath is implemented by PointToPointCoalescingNetDeviceImpl,
+ * which is instantiated with and without trace sources as
+ * PointToPointCoalescingNetDevice and PointToPointCoalescingLeanNetDevice.
  */
-class PointToPointCoalescingNetDevice : public NetDevice
+class PointToPointCoalescingNetDeviceBase : public NetDevice
 {
 public:
   /**
@@ -89,20 +293,20 @@ public:
   static TypeId GetTypeId (void);
 
   /**
-   * Construct a PointToPointCoalescingNetDevice
+   * Construct a PointToPointCoalescingNetDeviceBase
    *
-   * This is the constructor for the PointToPointCoalescingNetDevice.  It takes as a
+   * This is the constructor for the PointToPointCoalescingNetDeviceBase.  It takes as a
    * parameter a pointer to the Node to which this device is connected, 
    * as well as an optional DataRate object.
    */
-  PointToPointCoalescingNetDevice ();
+  PointToPointCoalescingNetDeviceBase ();
 
   /**
-   * Destroy a PointToPointCoalescingNetDevice
+   * Destroy a PointToPointCoalescingNetDeviceBase
    *
-   * This is the destructor for the PointToPointCoalescingNetDevice.
+   * This is the destructor for the PointToPointCoalescingNetDeviceBase.
    */
-  virtual ~PointToPointCoalescingNetDevice ();
+  virtual ~PointToPointCoalescingNetDeviceBase ();
 
   /**
    * Set the Data Rate used for transmission of packets.  The data rate is
@@ -132,19 +336,19 @@ public:
   /**
    * Attach a queue to the PointToPointCoalescingNetDevice.
    *
-   * The PointToPointCoalescingNetDevice "owns" a queue that implements a queueing 
-   * method such as DropTailQueue or RedQueue
+   * The PointToPointCoalescingNetDevice "owns" a CoalescingQueue which
+   * holds the packets while the link is in low power.
    *
    * \param queue Ptr to the new queue.
    */
-  void SetQueue (Ptr<Queue<Packet> > queue);
+  void SetQueue (Ptr<CoalescingQueue> queue);
 
   /**
    * Get a copy of the attached Queue.
    *
    * \returns Ptr to the queue.
    */
-  Ptr<Queue<Packet> > GetQueue (void) const;
+  Ptr<CoalescingQueue> GetQueue (void) const;
 
   /**
    * Attach a receive ErrorModel to the PointToPointCoalescingNetDevice.
@@ -156,6 +360,19 @@ public:
    */
   void SetReceiveErrorModel (Ptr<ErrorModel> em);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this device.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * The random variables of the device are those of its receive error
+   * model, if it is a RateErrorModel or a BurstErrorModel.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this device
+   */
+  int64_t AssignStreams (int64_t stream);
+
   /**
    * Receive a packet from a connected PointToPointCoalescingChannel.
    *
@@ -166,7 +383,29 @@ public:
    *
    * \param p Ptr to the received packet.
    */
-  void Receive (Ptr<Packet> p);
+  virtual void Receive (Ptr<Packet> p) = 0;
+
+  /**
+   * Receive a burst of packets from a connected PointToPointCoalescingChannel.
+   *
+   * This is the method used by the channel when a burst is handed to it.
+   * A single event, scheduled in the context of this device's node, passes
+   * each packet of the burst to Receive() at its own arrival time.
+   *
+   * \param burst the burst
+   */
+  void ReceiveBurst (Ptr<PointToPointCoalescingRxBurst> burst);
+
+  /**
+   * Receive a burst of frames sent by a PointToPointCoalescingRemoteChannel
+   * in one message, when the BatchBursts attribute of the channel is set.
+   *
+   * The first frame arrives now, and the others at the times given by the
+   * CoalescingBurstHeader of the message.
+   *
+   * \param p Ptr to the message
+   */
+  void DoMpiReceiveBurst (Ptr<Packet> p);
 
   // The remaining methods are documented in ns3::NetDevice*
 
@@ -194,7 +433,6 @@ public:
   virtual bool IsPointToPoint (void) const;
   virtual bool IsBridge (void) const;
 
-  virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
 
   virtual Ptr<Node> GetNode (void) const;
@@ -212,10 +450,163 @@ public:
   /**
    * Writes measurement data to file.   
    *
-   *\param s link speed.
+   * Appends one text line to data.txt.  Kept for existing scripts, use
+   * the overload taking a CoalescingMeasurementSink instead.  In a
+   * distributed or partitioned run only devices of the nodes of the local
+   * system write, to data.txt.<rank or partition>, so that systems do not
+   * write to the same file.
+   *
+   *\param s link speed, ignored since the data rate of the device is used.
    */
   void WriteMeasurementsData (std::string s);
 
+  /**
+   * Writes measurement data to a sink.
+   *
+   * In a distributed or partitioned run, devices of the nodes of other
+   * systems write nothing, since their measurements are gathered from the
+   * system which simulates them.
+   *
+   *\param sink sink shared by all devices of the run.
+   */
+  void WriteMeasurementsData (Ptr<CoalescingMeasurementSink> sink) const;
+
+  /**
+   * \returns the measurements of this device
+   *
+   * The first low power interval is not included in the time spent in low
+   * power, because flows may start later in the simulation, so it is not
+   * counted in the number of intervals either.
+   */
+  CoalescingMeasurementRecord GetMeasurementRecord (void) const;
+
+  /**
+   * Adds the arrivals recorded by this device to a sink.
+   *
+   * Arrivals are recorded only if the RecordArrivals attribute is true.
+   * The device must live until the sink is closed.  In a distributed or
+   * partitioned run only devices of the nodes of the local system add
+   * their arrivals.
+   *
+   *\param sink sink shared by all devices of the run.
+   */
+  void WriteArrivalTrace (Ptr<CoalescingArrivalTraceSink> sink) const;
+
+  /**
+   * \returns the coalescing parameters of this device, as a starting
+   * point for the parameters of its shadows
+   */
+  CoalescingModel::Parameters GetShadowParameters (void) const;
+
+  /**
+   * Adds a shadow of the coalescing state machine of this device.
+   *
+   * The shadow applies its own policy and parameters to the packets the
+   * device enqueues at Send, and measures what they would have given,
+   * without changing what the device transmits.  The arrivals are thus
+   * those of the running configuration: the shadow is exact for this port
+   * alone, not for the ports downstream.  Shadows should be added before
+   * the simulation starts; a shadow with the parameters returned by
+   * GetShadowParameters reproduces the measurements of the device.
+   *
+   *\param p parameters of the shadow.
+   *\returns the index of the shadow
+   */
+  uint32_t AddShadow (const CoalescingModel::Parameters &p);
+
+  /**
+   * \returns the number of shadows of this device
+   */
+  uint32_t GetNShadows (void) const;
+
+  /**
+   * \param i index of the shadow
+   * \returns a copy of the shadow, with its events due up to now processed
+   */
+  CoalescingModel GetShadow (uint32_t i) const;
+
+  /**
+   * Writes the measurements of the shadows, one text line per shadow:
+   * node id, interface index, index of the shadow, policy, coalescing
+   * timeout, byte limit, packet limit, time in low power in nanoseconds,
+   * number of low-power intervals, E[Toff] in seconds, energy ratio and
+   * mean queueing delay in seconds.  In a distributed or partitioned run
+   * only devices of the nodes of the local system write, and each system
+   * should write to its own stream, see
+   * CoalescingMeasurementSink::GetSystemPath.
+   *
+   *\param os stream shared by all devices of the system.
+   */
+  void WriteShadowData (std::ostream &os) const;
+
+  /**
+   * \brief Counters of coalescing timer events
+   */
+  struct CoalescingTimerCounters
+  {
+    uint64_t scheduled; //!< Number of timer events scheduled
+    uint64_t cancelled; //!< Number of timer events cancelled before expiry
+    uint64_t fired;     //!< Number of timer events that expired
+  };
+
+  /**
+   * \returns the counters of coalescing timer events of this device
+   */
+  CoalescingTimerCounters GetCoalescingTimerCounters (void) const;
+
+  /**
+   * \param state power state of the port
+   * \returns the time spent in the state up to now
+   */
+  Time GetStateResidency (CoalescingEnergyAccount::State state) const;
+
+  /**
+   * \returns the number of times the port entered the state
+   *
+   * \param state power state of the port
+   */
+  uint64_t GetStateEntries (CoalescingEnergyAccount::State state) const;
+
+  /**
+   * \returns the earliest time at which the port can start a transmission
+   *
+   * The bound follows from the coalescing state: a port in low power
+   * must first wake up, and a port going to sleep must also finish the
+   * sleep transition.  A port whose policy wakes it up only on the timeout
+   * cannot transmit before the timeout expires, or before a timeout
+   * started by the next packet would expire.
+   */
+  Time GetEarliestTransmitTime (void) const;
+
+  /**
+   * \returns the energy consumed up to now, the time spent in each power
+   * state weighted by the power drawn in it
+   */
+  double GetEnergy (void) const;
+
+  /**
+   * Starts the batch-means estimators of this device.
+   *
+   * The estimators are allocated only by this call, so devices which are
+   * not monitored do not pay for them at every coalescing cycle.  The cycle
+   * running at the call is not counted.  Calling it again has no effect.
+   */
+  void EnableEstimators (void);
+
+  /**
+   * \returns the batch-means estimate of the mean duration of the
+   * low-power state E[Toff], in seconds, over the intervals since
+   * EnableEstimators, or an empty estimate if it was not called
+   */
+  const CoalescingBatchMeans &GetLowPowerEstimate (void) const;
+
+  /**
+   * \returns the batch-means estimate of the ratio of the energy consumed
+   * to the energy the port would consume without EEE, over the coalescing
+   * cycles since EnableEstimators, or an empty estimate if it was not called
+   */
+  const CoalescingBatchMeans &GetEnergyRatioEstimate (void) const;
+
 protected:
   /**
    * \brief Handler for MPI receive event
@@ -234,7 +625,7 @@ private:
    * \param o Other NetDevice
    * \return New instance of the NetDevice
    */
-  PointToPointCoalescingNetDevice& operator = (const PointToPointCoalescingNetDevice &o);
+  PointToPointCoalescingNetDeviceBase& operator = (const PointToPointCoalescingNetDeviceBase &o);
 
   /**
    * \brief Copy constructor
@@ -243,14 +634,26 @@ private:
 
    * \param o Other NetDevice
    */
-  PointToPointCoalescingNetDevice (const PointToPointCoalescingNetDevice &o);
+  PointToPointCoalescingNetDeviceBase (const PointToPointCoalescingNetDeviceBase &o);
 
   /**
    * \brief Dispose of the object
    */
   virtual void DoDispose (void);
 
-private:
+  /**
+   * \brief Preallocate the transmit queue for a full coalescing cycle
+   */
+  virtual void DoInitialize (void);
+
+  /**
+   * \return true if the node of the device is simulated by this system
+   */
+  bool IsLocal (void) const;
+
+protected:
+  /// Reusable event of the coalescing state machine
+  typedef PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceBase> CoalescingEvent;
 
   /**
    * \returns the address of the remote device connected to this device
@@ -276,31 +679,6 @@ private:
    */
   bool ProcessHeader (Ptr<Packet> p, uint16_t& param);
 
-  /**
-   * Start Sending a Packet Down the Wire.
-   *
-   * The TransmitStart method is the method that is used internally in the
-   * PointToPointCoalescingNetDevice to begin the process of sending a packet out on
-   * the channel.  The corresponding method is called on the channel to let
-   * it know that the physical device this class represents has virtually
-   * started sending signals.  An event is scheduled for the time at which
-   * the bits have been completely transmitted.
-   *
-   * \see PointToPointCoalescingChannel::TransmitStart ()
-   * \see TransmitComplete()
-   * \param p a reference to the packet to send
-   * \returns true if success, false on failure
-   */
-  bool TransmitStart (Ptr<Packet> p);
-
-  /**
-   * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
-   *
-   * The TransmitComplete method is used internally to finish the process
-   * of sending a packet out on the channel.
-   */
-  void TransmitComplete (void);
-
   /**
    * \brief Make the link up and running
    *
@@ -343,189 +721,183 @@ private:
    * The Queue which this PointToPointCoalescingNetDevice uses as a packet source.
    * Management of this Queue has been delegated to the PointToPointCoalescingNetDevice
    * and it has the responsibility for deletion.
-   * \see class DropTailQueue
+   * \see class CoalescingQueue
    */
-  Ptr<Queue<Packet> > m_queue;
+  Ptr<CoalescingQueue> m_queue;
 
   /**
    * Error model for receive packet events
    */
   Ptr<ErrorModel> m_receiveErrorModel;
 
-  /**
-   * The trace source fired when packets come into the "top" of the device
-   * at the L3/L2 transition, before being queued for transmission.
-   */
-  TracedCallback<Ptr<const Packet> > m_macTxTrace;
+  Ptr<Node> m_node;         //!< Node owning this NetDevice
+  Mac48Address m_address;   //!< Mac48Address of this NetDevice
+  mutable Address m_remote; //!< Address of the remote device, found on first use
+  NetDevice::ReceiveCallback m_rxCallback;   //!< Receive callback
+  NetDevice::PromiscReceiveCallback m_promiscCallback;  //!< Receive callback
+                                                        //   (promisc data)
+  uint32_t m_ifIndex; //!< Index of the interface
+  bool m_linkUp;      //!< Identify if the link is up or not
+  TracedCallback<> m_linkChangeCallbacks;  //!< Callback for the link change event
+
+  static const uint16_t DEFAULT_MTU = 1500; //!< Default MTU
 
   /**
-   * The trace source fired when packets coming into the "top" of the device
-   * at the L3/L2 transition are dropped before being queued for transmission.
+   * \brief The Maximum Transmission Unit
+   *
+   * This corresponds to the maximum 
+   * number of bytes that can be transmitted as seen from higher layers.
+   * This corresponds to the 1500 byte MTU size often seen on IP over 
+   * Ethernet.
    */
-  TracedCallback<Ptr<const Packet> > m_macTxDropTrace;
+  uint32_t m_mtu;
+
+  Ptr<Packet> m_currentPkt; //!< Current packet processed
 
   /**
-   * The trace source fired for packets successfully received by the device
-   * immediately before being forwarded up to higher layers (at the L2/L3 
-   * transition).  This is a promiscuous trace (which doesn't mean a lot here
-   * in the point-to-point device).
+   * \brief Enables burst transmission
+   *
+   * Value true makes the device transmit all queued packets as a single
+   * burst with one transmit complete event.
    */
-  TracedCallback<Ptr<const Packet> > m_macPromiscRxTrace;
+  bool m_burstTransmit;
+
+  std::vector<Ptr<Packet> > m_burstPackets; //!< Packets of the current burst
+  std::vector<Time> m_burstTxEnd;           //!< Last bit time of each packet, relative to the burst start
+  Time m_burstStart;                        //!< Time at which the current burst started
+  std::size_t m_burstTraceIndex;            //!< Packet of the current burst whose PHY traces are pending
 
   /**
-   * The trace source fired for packets successfully received by the device
-   * immediately before being forwarded up to higher layers (at the L2/L3 
-   * transition).  This is a non-promiscuous trace (which doesn't mean a lot 
-   * here in the point-to-point device).
+   * \brief PPP to Ethernet protocol number mapping
+   * \param protocol A PPP protocol number
+   * \return The corresponding Ethernet protocol number
    */
-  TracedCallback<Ptr<const Packet> > m_macRxTrace;
+  static uint16_t PppToEther (uint16_t protocol);
 
   /**
-   * The trace source fired for packets successfully received by the device
-   * but are dropped before being forwarded up to higher layers (at the L2/L3 
-   * transition).
+   * \brief Ethernet to PPP protocol number mapping
+   * \param protocol An Ethernet protocol number
+   * \return The corresponding PPP protocol number
    */
-  TracedCallback<Ptr<const Packet> > m_macRxDropTrace;
+  static uint16_t EtherToPpp (uint16_t protocol);
 
   /**
-   * The trace source fired when a packet begins the transmission process on
-   * the medium.
+   * \brief Go to inactive state when the policy lets the link sleep.
+   *
+   * Transitions to inactive state.  Packets still in the queue start the
+   * timer of the next coalescing cycle.
    */
-  TracedCallback<Ptr<const Packet> > m_phyTxBeginTrace;
+  void CoalescingQueueEmptied();
 
   /**
-   * The trace source fired when a packet ends the transmission process on
-   * the medium.
+   * \brief Action when coalescing time-out occurs.
+   *
+   * Initiates transition to active state.
    */
-  TracedCallback<Ptr<const Packet> > m_phyTxEndTrace;
+  void CoalescingTimeOut();
 
   /**
-   * The trace source fired when the phy layer drops a packet before it tries
-   * to transmit it.
+   * \brief Cancels the coalescing timer.
+   *
+   * Removes a pending time-out event from the scheduler.
    */
-  TracedCallback<Ptr<const Packet> > m_phyTxDropTrace;
+  void CoalescingCancelTimer();
 
   /**
-   * The trace source fired when a packet begins the reception process from
-   * the medium -- when the simulated first bit(s) arrive.
+   * \brief Checks if queue limit is reached.
+   *
+   * Checks current queue occupancy 
+   * and changes coalescing state if the policy asks to wake up.
+   *
+   * \param queueBytes Number of bytes in the queue
+   * \param queuePackets Number of packets in the queue
    */
-  TracedCallback<Ptr<const Packet> > m_phyRxBeginTrace;
+  void CoalescingQueueLimit(uint32_t queueBytes, uint32_t queuePackets);
 
   /**
-   * The trace source fired when a packet ends the reception process from
-   * the medium.
+   * \brief Asks the coalescing policy whether to wake up.
+   *
+   * \param queueBytes Number of bytes in the queue
+   * \param queuePackets Number of packets in the queue
+   * \return true if the link has to leave low power
    */
-  TracedCallback<Ptr<const Packet> > m_phyRxEndTrace;
+  bool CoalescingWakeUpDue(uint32_t queueBytes, uint32_t queuePackets) const;
 
   /**
-   * The trace source fired when the phy layer drops a packet it has received.
-   * This happens if the receiver is not enabled or the error model is active
-   * and indicates that the packet is corrupt.
+   * \brief Asks the coalescing policy whether to go to sleep.
+   *
+   * \param queueBytes Number of bytes in the queue
+   * \param queuePackets Number of packets in the queue
+   * \return true if the link has to go to low power after a transmission
    */
-  TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+  bool CoalescingSleepDue(uint32_t queueBytes, uint32_t queuePackets) const;
 
   /**
-   * A trace source that emulates a non-promiscuous protocol sniffer connected 
-   * to the device.  Unlike your average everyday sniffer, this trace source 
-   * will not fire on PACKET_OTHERHOST events.
-   *
-   * On the transmit size, this trace hook will fire after a packet is dequeued
-   * from the device queue for transmission.  In Linux, for example, this would
-   * correspond to the point just before a device \c hard_start_xmit where 
-   * \c dev_queue_xmit_nit is called to dispatch the packet to the PF_PACKET 
-   * ETH_P_ALL handlers.
-   *
-   * On the receive side, this trace hook will fire when a packet is received,
-   * just before the receive callback is executed.  In Linux, for example, 
-   * this would correspond to the point at which the packet is dispatched to 
-   * packet sniffers in \c netif_receive_skb.
+   * \return The parameters of the coalescing policy
    */
-  TracedCallback<Ptr<const Packet> > m_snifferTrace;
+  const CoalescingPolicy::Parameters &GetPolicyParameters (void) const;
 
   /**
-   * A trace source that emulates a promiscuous mode protocol sniffer connected
-   * to the device.  This trace source fire on packets destined for any host
-   * just like your average everyday packet sniffer.
-   *
-   * On the transmit size, this trace hook will fire after a packet is dequeued
-   * from the device queue for transmission.  In Linux, for example, this would
-   * correspond to the point just before a device \c hard_start_xmit where 
-   * \c dev_queue_xmit_nit is called to dispatch the packet to the PF_PACKET 
-   * ETH_P_ALL handlers.
-   *
-   * On the receive side, this trace hook will fire when a packet is received,
-   * just before the receive callback is executed.  In Linux, for example, 
-   * this would correspond to the point at which the packet is dispatched to 
-   * packet sniffers in \c netif_receive_skb.
+   * \param byteLimit EEE coalescing byte limit
    */
-  TracedCallback<Ptr<const Packet> > m_promiscSnifferTrace;
+  void SetEeeByteLimit (double byteLimit);
 
-  Ptr<Node> m_node;         //!< Node owning this NetDevice
-  Mac48Address m_address;   //!< Mac48Address of this NetDevice
-  NetDevice::ReceiveCallback m_rxCallback;   //!< Receive callback
-  NetDevice::PromiscReceiveCallback m_promiscCallback;  //!< Receive callback
-                                                        //   (promisc data)
-  uint32_t m_ifIndex; //!< Index of the interface
-  bool m_linkUp;      //!< Identify if the link is up or not
-  TracedCallback<> m_linkChangeCallbacks;  //!< Callback for the link change event
-
-  static const uint16_t DEFAULT_MTU = 1500; //!< Default MTU
+  /**
+   * \return EEE coalescing byte limit
+   */
+  double GetEeeByteLimit (void) const;
 
   /**
-   * \brief The Maximum Transmission Unit
-   *
-   * This corresponds to the maximum 
-   * number of bytes that can be transmitted as seen from higher layers.
-   * This corresponds to the 1500 byte MTU size often seen on IP over 
-   * Ethernet.
+   * \param packetLimit EEE coalescing packet limit
    */
-  uint32_t m_mtu;
+  void SetEeePacketLimit (uint32_t packetLimit);
 
-  Ptr<Packet> m_currentPkt; //!< Current packet processed
+  /**
+   * \return EEE coalescing packet limit
+   */
+  uint32_t GetEeePacketLimit (void) const;
 
   /**
-   * \brief PPP to Ethernet protocol number mapping
-   * \param protocol A PPP protocol number
-   * \return The corresponding Ethernet protocol number
+   * \param lowByteLimit Bytes at or below which the hysteresis policy sleeps
    */
-  static uint16_t PppToEther (uint16_t protocol);
+  void SetEeeLowByteLimit (double lowByteLimit);
 
   /**
-   * \brief Ethernet to PPP protocol number mapping
-   * \param protocol An Ethernet protocol number
-   * \return The corresponding PPP protocol number
+   * \return Bytes at or below which the hysteresis policy sleeps
    */
-  static uint16_t EtherToPpp (uint16_t protocol);
+  double GetEeeLowByteLimit (void) const;
 
   /**
-   * \brief Go to inactive state if queue is emptied.
+   * \brief Starts the coalescing timer.
    *
-   * Checks queue occupancy and transitions to inactive state.
+   * The timer is kept in the timer wheel of the device if it has one, and
+   * in the scheduler of the simulator otherwise.
    */
-  void CoalescingQueueEmptied();
+  void CoalescingStartTimer();
 
   /**
-   * \brief Action when coalescing time-out occurs.
-   *
-   * Initiates transition to active state.
+   * \return true if the coalescing timer is running
    */
-  void CoalescingTimeOut(uint64_t coalescingTimerCycle);
+  bool CoalescingTimerRunning() const;
 
   /**
-   * \brief Checks if queue limit is reached.
+   * \brief Schedules a transition of the coalescing state machine.
    *
-   * Checks current queue occupancy 
-   * and changes coalescing state if byte limit is reached.
+   * \param us delay in microseconds
+   * \param event reusable event of the transition
+   * \param handler method invoked after the delay
    */
-  void CoalescingQueueLimit();
+  void CoalescingSchedule(double us, Ptr<CoalescingEvent> &event, void (PointToPointCoalescingNetDeviceBase::*handler) ());
 
   /**
    * \brief Starts timer on the first packet.
    *
    * Makes sure that timer is started when first packet arrives
    * into emoty
+   *
+   * \param queueBytes Number of bytes in the queue before the packet is enqueued
    */
-  void CoalescingCheckTimer(); 
+  void CoalescingCheckTimer(uint32_t queueBytes); 
 
    /**
    * \brief Transition to sleep state.
@@ -535,30 +907,102 @@ private:
   void CoalescingSleep();
 
    /**
-   * \brief Starts timer on the first packet.
+   * \brief Transition to active state.
    *
-   * Starts timer on the first packet.
+   * Starts sending the packets queued while the link was in low power.
    */
-  void CoalescingWakeUp();
+  virtual void CoalescingWakeUp() = 0;
 
   /**
-   * \brief ID of the current coalescing cycle;
+   * \brief Current coalescing state
+   */
+  uint32_t m_coalescingState;
+
+  /**
+   * \brief Tells the energy account about a change of state.
    *
-   * This ID is incemented each time coalescing queue is emptied.
+   * Maps the coalescing state and the transmitter state to the power
+   * state of the port.  Must be called after either of them changes.
    */
-  uint64_t m_coalescingTimerCycle;
+  void UpdateEnergyState();
 
   /**
-   * \brief Current coalescing state
+   * \brief Feeds the estimators at the end of a coalescing cycle.
+   *
+   * A cycle ends when the link wakes up.  Its energy is compared with the
+   * energy of a port without EEE, which is idle instead of in low power
+   * or in transition.
+   *
+   * \param lowPower duration of the low-power state of the cycle
    */
-  uint32_t m_coalescingState;
+  void CoalescingCycleEnded(Time lowPower);
+
+  /// \param n observations of a batch of the estimators
+  void SetEstimatorBatchSize (uint32_t n);
+  /// \returns the observations of a batch of the estimators
+  uint32_t GetEstimatorBatchSize (void) const;
+  /// \param record true to record the arrivals of the device
+  void SetRecordArrivals (bool record);
+  /// \returns true if the arrivals of the device are recorded
+  bool GetRecordArrivals (void) const;
+
+  /**
+   * \brief Hands a packet enqueued by Send to the arrival recorder and the
+   * shadows.
+   *
+   * \param size size of the packet
+   */
+  void CoalescingArrival (uint32_t size);
+
+  /// \returns the time spent transmitting, for the read-only attribute
+  Time GetResidencyTransmit (void) const;
+  /// \returns the time spent active and idle, for the read-only attribute
+  Time GetResidencyIdle (void) const;
+  /// \returns the time spent going to low power, for the read-only attribute
+  Time GetResidencySleep (void) const;
+  /// \returns the time spent in low power, for the read-only attribute
+  Time GetResidencyLowPower (void) const;
+  /// \returns the time spent waking up, for the read-only attribute
+  Time GetResidencyWakeUp (void) const;
 
   /**
-   * \brief Timer state
+   * \brief Pending coalescing time-out event
    *
-   * Value true indicates that timer is active
+   * The timer is running while the event is pending.
+   */
+  EventId m_coalescingTimer;
+
+  /**
+   * \brief Timer wheel shared with the other devices of the node, if any
+   */
+  Ptr<CoalescingTimerWheel> m_timerWheel;
+
+  /**
+   * \brief Pending coalescing time-out in the timer wheel
+   */
+  CoalescingTimerWheel::Timer m_coalescingWheelTimer;
+
+  /**
+   * \brief Expiry of the pending coalescing time-out
+   */
+  Time m_coalescingTimerEnd;
+
+  /**
+   * \brief End of the pending sleep or wake-up transition
    */
-  bool m_coalescingTimerState;
+  Time m_coalescingTransitionEnd;
+
+  /**
+   * \brief Reusable events of the coalescing state machine
+   */
+  Ptr<CoalescingEvent> m_timeOutEvent;
+  Ptr<CoalescingEvent> m_sleepEvent;  //!< Sleep transition
+  Ptr<CoalescingEvent> m_wakeUpEvent; //!< Wake-up transition
+
+  /**
+   * \brief Counters of coalescing timer events.
+   */
+  CoalescingTimerCounters m_coalescingTimerCounters;
 
   /**
    * \brief Total time spent in low power mode.
@@ -617,11 +1061,19 @@ private:
   double m_eeeTimeout;
 
    /**
-   * \brief EEE coalescing byte limit.
+   * \brief Parameters of the coalescing policy.
    *
-   * Value EEE coalescing byte limit.
+   * Value EEE coalescing byte limit, packet limit of the packet count and
+   * hybrid policies, and bytes at or below which the hysteresis policy
+   * goes to sleep.  Kept in the form the policies take, so the decisions
+   * on the packet path do not rebuild it.
+   */
+  CoalescingPolicy::Parameters m_policyParameters;
+
+   /**
+   * \brief Coalescing policy of the device.
    */
-  double m_eeeByteLimit;
+  CoalescingPolicy::Type m_coalescingPolicy;
 
    /**
    * \brief Duration of transition to low-power state in microseconds.
@@ -637,6 +1089,515 @@ private:
    */
   double m_eeeWakeupTime;
 
+   /**
+   * \brief Power drawn while transmitting.
+   */
+  double m_eeePowerTransmit;
+
+   /**
+   * \brief Power drawn while active with nothing to transmit.
+   */
+  double m_eeePowerIdle;
+
+   /**
+   * \brief Power drawn during transition to low-power state.
+   */
+  double m_eeePowerSleep;
+
+   /**
+   * \brief Power drawn in low-power state.
+   */
+  double m_eeePowerLowPower;
+
+   /**
+   * \brief Power drawn during transition to active state.
+   */
+  double m_eeePowerWakeUp;
+
+  /**
+   * \brief Time spent in each power state.
+   */
+  CoalescingEnergyAccount m_energy;
+
+  /**
+   * \brief Batch-means estimators and the start of the current cycle.
+   */
+  struct CoalescingEstimators
+  {
+    CoalescingBatchMeans lowPower;    //!< Estimator of the duration of the low-power state
+    CoalescingBatchMeans energyRatio; //!< Estimator of the energy ratio of the cycles
+    bool started;                     //!< True once a cycle started after the estimators
+    Time cycleStart;                  //!< Start time of the current cycle
+    double cycleEnergy;               //!< Energy at the start of the current cycle
+    Time cycleTransmit;               //!< Transmit residency at the start of the current cycle
+  };
+
+  /**
+   * \brief Consumers of the packets enqueued by Send.
+   */
+  struct CoalescingArrivals
+  {
+    bool record;                           //!< Record the time and size of every packet
+    CoalescingArrivalEncoder encoder;      //!< Recorded arrivals, for replays of the state machine
+    std::vector<CoalescingModel> shadows;  //!< Shadow state machines fed with the arrivals
+  };
+
+  /**
+   * \brief Observations of a batch of the estimators.
+   */
+  uint32_t m_estimatorBatchSize;
+
+  /**
+   * \brief Estimators, allocated by EnableEstimators, or null.
+   */
+  CoalescingEstimators *m_estimators;
+
+  /**
+   * \brief Arrival recorder and shadows, allocated when arrivals are
+   * recorded or the first shadow is added, or null.
+   */
+  CoalescingArrivals *m_arrivals;
+
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Packet trace source which knows whether a sink is connected
+ *
+ * Burst transmission only schedules an event at the wire time of every
+ * packet of a burst while a sink is connected to one of the trace sources
+ * fired there.  A sink disconnected without having been connected is not
+ * counted.
+ */
+class PointToPointCoalescingPacketTrace : public TracedCallback<Ptr<const Packet> >
+{
+public:
+  PointToPointCoalescingPacketTrace () : m_nSinks (0) {}
+
+  /**
+   * \brief Append a sink
+   * \param cb the sink
+   */
+  void ConnectWithoutContext (const CallbackBase &cb)
+  {
+    TracedCallback<Ptr<const Packet> >::ConnectWithoutContext (cb);
+    m_nSinks++;
+  }
+
+  /**
+   * \brief Append a sink with a context
+   * \param cb the sink
+   * \param path the context
+   */
+  void Connect (const CallbackBase &cb, std::string path)
+  {
+    TracedCallback<Ptr<const Packet> >::Connect (cb, path);
+    m_nSinks++;
+  }
+
+  /**
+   * \brief Remove a sink
+   * \param cb the sink
+   */
+  void DisconnectWithoutContext (const CallbackBase &cb)
+  {
+    TracedCallback<Ptr<const Packet> >::DisconnectWithoutContext (cb);
+    m_nSinks -= m_nSinks > 0 ? 1 : 0;
+  }
+
+  /**
+   * \brief Remove a sink with a context
+   * \param cb the sink
+   * \param path the context
+   */
+  void Disconnect (const CallbackBase &cb, std::string path)
+  {
+    TracedCallback<Ptr<const Packet> >::Disconnect (cb, path);
+    m_nSinks -= m_nSinks > 0 ? 1 : 0;
+  }
+
+  /**
+   * \return true if a sink is connected
+   */
+  bool HasSinks (void) const { return m_nSinks > 0; }
+
+private:
+  uint32_t m_nSinks; //!< Number of sinks connected
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Tracing policy which fires the trace sources of the device
+ *
+ * The trace sources are members of this class, so they only take up
+ * memory in devices instantiated with it.
+ */
+class PointToPointCoalescingDeviceTraces
+{
+public:
+  /// Trace sources are fired
+  static const bool IsEnabled = true;
+
+  /**
+   * \param p Packet passed to the trace sinks
+   */
+  void TraceMacTx (Ptr<const Packet> p) { m_macTxTrace (p); }
+  /// \copydoc TraceMacTx
+  void TraceMacTxDrop (Ptr<const Packet> p) { m_macTxDropTrace (p); }
+  /// \copydoc TraceMacTx
+  void TraceMacPromiscRx (Ptr<const Packet> p) { m_macPromiscRxTrace (p); }
+  /// \copydoc TraceMacTx
+  void TraceMacRx (Ptr<const Packet> p) { m_macRxTrace (p); }
+  /// \copydoc TraceMacTx
+  void TracePhyTxBegin (Ptr<const Packet> p) { m_phyTxBeginTrace (p); }
+  /// \copydoc TraceMacTx
+  void TracePhyTxEnd (Ptr<const Packet> p) { m_phyTxEndTrace (p); }
+  /// \copydoc TraceMacTx
+  void TracePhyTxDrop (Ptr<const Packet> p) { m_phyTxDropTrace (p); }
+  /// \copydoc TraceMacTx
+  void TracePhyRxEnd (Ptr<const Packet> p) { m_phyRxEndTrace (p); }
+  /// \copydoc TraceMacTx
+  void TracePhyRxDrop (Ptr<const Packet> p) { m_phyRxDropTrace (p); }
+
+  /**
+   * \param p Packet passed to the trace sinks
+   * \param txStart Time at which the first bit is put on the wire
+   * \param txEnd Time at which the last bit is put on the wire
+   */
+  void TracePhyTxBurst (Ptr<const Packet> p, Time txStart, Time txEnd) { m_phyTxBurstTrace (p, txStart, txEnd); }
+
+  /**
+   * \brief Fire both the non-promiscuous and the promiscuous sniffer
+   * \param p Packet passed to the trace sinks
+   */
+  void TraceSniffer (Ptr<const Packet> p)
+  {
+    m_snifferTrace (p);
+    m_promiscSnifferTrace (p);
+  }
+
+  /**
+   * \return true if a sink is connected to a trace source fired at the
+   * wire time of each transmitted packet: Sniffer, PromiscSniffer,
+   * PhyTxBegin or PhyTxEnd
+   */
+  bool HasPacketTxSinks (void) const
+  {
+    return m_snifferTrace.HasSinks () || m_promiscSnifferTrace.HasSinks ()
+           || m_phyTxBeginTrace.HasSinks () || m_phyTxEndTrace.HasSinks ();
+  }
+
+protected:
+  /**
+   * The trace source fired when packets come into the "top" of the device
+   * at the L3/L2 transition, before being queued for transmission.
+   */
+  TracedCallback<Ptr<const Packet> > m_macTxTrace;
+
+  /**
+   * The trace source fired when packets coming into the "top" of the device
+   * at the L3/L2 transition are dropped before being queued for transmission.
+   */
+  TracedCallback<Ptr<const Packet> > m_macTxDropTrace;
+
+  /**
+   * The trace source fired for packets successfully received by the device
+   * immediately before being forwarded up to higher layers (at the L2/L3 
+   * transition).  This is a promiscuous trace (which doesn't mean a lot here
+   * in the point-to-point device).
+   */
+  TracedCallback<Ptr<const Packet> > m_macPromiscRxTrace;
+
+  /**
+   * The trace source fired for packets successfully received by the device
+   * immediately before being forwarded up to higher layers (at the L2/L3 
+   * transition).  This is a non-promiscuous trace (which doesn't mean a lot 
+   * here in the point-to-point device).
+   */
+  TracedCallback<Ptr<const Packet> > m_macRxTrace;
+
+  /**
+   * The trace source fired for packets successfully received by the device
+   * but are dropped before being forwarded up to higher layers (at the L2/L3 
+   * transition).
+   */
+  TracedCallback<Ptr<const Packet> > m_macRxDropTrace;
+
+  /**
+   * The trace source fired when a packet begins the transmission process on
+   * the medium.
+   */
+  PointToPointCoalescingPacketTrace m_phyTxBeginTrace;
+
+  /**
+   * The trace source fired when a packet ends the transmission process on
+   * the medium.
+   */
+  PointToPointCoalescingPacketTrace m_phyTxEndTrace;
+
+  /**
+   * The trace source fired for each packet of a burst when the burst is
+   * handed to the channel, carrying the exact first and last bit
+   * transmission times of the packet.
+   */
+  TracedCallback<Ptr<const Packet>, Time, Time> m_phyTxBurstTrace;
+
+  /**
+   * The trace source fired when the phy layer drops a packet before it tries
+   * to transmit it.
+   */
+  TracedCallback<Ptr<const Packet> > m_phyTxDropTrace;
+
+  /**
+   * The trace source fired when a packet begins the reception process from
+   * the medium -- when the simulated first bit(s) arrive.
+   */
+  TracedCallback<Ptr<const Packet> > m_phyRxBeginTrace;
+
+  /**
+   * The trace source fired when a packet ends the reception process from
+   * the medium.
+   */
+  TracedCallback<Ptr<const Packet> > m_phyRxEndTrace;
+
+  /**
+   * The trace source fired when the phy layer drops a packet it has received.
+   * This happens if the receiver is not enabled or the error model is active
+   * and indicates that the packet is corrupt.
+   */
+  TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+
+  /**
+   * A trace source that emulates a non-promiscuous protocol sniffer connected 
+   * to the device.  Unlike your average everyday sniffer, this trace source 
+   * will not fire on PACKET_OTHERHOST events.
+   *
+   * On the transmit size, this trace hook will fire after a packet is dequeued
+   * from the device queue for transmission.  In Linux, for example, this would
+   * correspond to the point just before a device \c hard_start_xmit where 
+   * \c dev_queue_xmit_nit is called to dispatch the packet to the PF_PACKET 
+   * ETH_P_ALL handlers.
+   *
+   * On the receive side, this trace hook will fire when a packet is received,
+   * just before the receive callback is executed.  In Linux, for example, 
+   * this would correspond to the point at which the packet is dispatched to 
+   * packet sniffers in \c netif_receive_skb.
+   */
+  PointToPointCoalescingPacketTrace m_snifferTrace;
+
+  /**
+   * A trace source that emulates a promiscuous mode protocol sniffer connected
+   * to the device.  This trace source fire on packets destined for any host
+   * just like your average everyday packet sniffer.
+   *
+   * On the transmit size, this trace hook will fire after a packet is dequeued
+   * from the device queue for transmission.  In Linux, for example, this would
+   * correspond to the point just before a device \c hard_start_xmit where 
+   * \c dev_queue_xmit_nit is called to dispatch the packet to the PF_PACKET 
+   * ETH_P_ALL handlers.
+   *
+   * On the receive side, this trace hook will fire when a packet is received,
+   * just before the receive callback is executed.  In Linux, for example, 
+   * this would correspond to the point at which the packet is dispatched to 
+   * packet sniffers in \c netif_receive_skb.
+   */
+  PointToPointCoalescingPacketTrace m_promiscSnifferTrace;
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Tracing policy without trace sources
+ *
+ * All methods are empty and inline, so the datapath instantiated with
+ * this policy has no trace dispatch and no trace source members.
+ */
+class PointToPointCoalescingNoTraces
+{
+public:
+  /// Trace sources are not fired
+  static const bool IsEnabled = false;
+
+  void TraceMacTx (const Ptr<Packet> &) {}                                   //!< No-op
+  void TraceMacTxDrop (const Ptr<Packet> &) {}                               //!< No-op
+  void TraceMacPromiscRx (const Ptr<Packet> &) {}                            //!< No-op
+  void TraceMacRx (const Ptr<Packet> &) {}                                   //!< No-op
+  void TracePhyTxBegin (const Ptr<Packet> &) {}                              //!< No-op
+  void TracePhyTxEnd (const Ptr<Packet> &) {}                                //!< No-op
+  void TracePhyTxDrop (const Ptr<Packet> &) {}                               //!< No-op
+  void TracePhyRxEnd (const Ptr<Packet> &) {}                                //!< No-op
+  void TracePhyRxDrop (const Ptr<Packet> &) {}                               //!< No-op
+  void TracePhyTxBurst (const Ptr<Packet> &, const Time &, const Time &) {}  //!< No-op
+  void TraceSniffer (const Ptr<Packet> &) {}                                 //!< No-op
+  bool HasPacketTxSinks (void) const { return false; }                       //!< No sinks
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Packet datapath of a point to point coalescing device
+ *
+ * Implements transmission and reception on top of
+ * PointToPointCoalescingNetDeviceBase.  The trace sources are provided by
+ * the Traces policy, chosen at compile time, so a device built without
+ * them pays nothing for tracing on the per-packet path.
+ *
+ * The datapath is explicitly instantiated for
+ * PointToPointCoalescingDeviceTraces and PointToPointCoalescingNoTraces.
+ */
+template <class Traces>
+class PointToPointCoalescingNetDeviceImpl : public PointToPointCoalescingNetDeviceBase,
+                                            public Traces
+{
+public:
+  virtual void Receive (Ptr<Packet> p);
+  virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
+
+protected:
+  virtual void CoalescingWakeUp ();
+
+private:
+  /**
+   * Start Sending a Packet Down the Wire.
+   *
+   * The TransmitStart method is the method that is used internally in the
+   * PointToPointCoalescingNetDevice to begin the process of sending a packet out on
+   * the channel.  The corresponding method is called on the channel to let
+   * it know that the physical device this class represents has virtually
+   * started sending signals.  An event is scheduled for the time at which
+   * the bits have been completely transmitted.
+   *
+   * \see PointToPointCoalescingChannel::TransmitStart ()
+   * \see TransmitComplete()
+   * \param p a reference to the packet to send
+   * \returns true if success, false on failure
+   */
+  bool TransmitStart (Ptr<Packet> p);
+
+  /**
+   * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
+   *
+   * The TransmitComplete method is used internally to finish the process
+   * of sending a packet out on the channel.
+   */
+  void TransmitComplete (void);
+
+  /**
+   * Start Sending a Burst of Packets Down the Wire.
+   *
+   * Used instead of TransmitStart() when burst transmission is enabled.  All
+   * packets waiting in the queue are dequeued, their transmission times
+   * are computed back to back and the whole burst is handed to the channel
+   * at once.  A single event is scheduled for the time at which the last
+   * bit of the burst has been transmitted.  While a sink is connected to a
+   * per-packet trace source the event fires at every packet boundary
+   * instead, see TransmitBurstPacketComplete().
+   *
+   * \see PointToPointCoalescingChannel::TransmitBurst ()
+   * \see TransmitBurstComplete()
+   * \returns true if success, false on failure
+   */
+  bool TransmitBurst (void);
+
+  /**
+   * Finish the transmission of one packet of a burst.
+   *
+   * Only used while a sink is connected to Sniffer, PromiscSniffer,
+   * PhyTxBegin or PhyTxEnd.  Fires PhyTxEnd for the packet whose
+   * interframe gap has just ended, and Sniffer and PhyTxBegin for the next
+   * one, at the times TransmitComplete() and TransmitStart() would have
+   * fired them.  After the last packet it calls TransmitBurstComplete().
+   */
+  void TransmitBurstPacketComplete (void);
+
+  /**
+   * Finish the transmission of a burst.
+   *
+   * Starts the next burst if packets arrived in the meantime, otherwise
+   * lets the coalescing state machine go to sleep.
+   */
+  void TransmitBurstComplete (void);
+
+  /**
+   * Reusable event of the end of a transmission.
+   */
+  Ptr<PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceImpl> > m_txCompleteEvent;
+
+  /**
+   * Reusable event of the end of a burst.
+   */
+  Ptr<PointToPointCoalescingDeviceEvent<PointToPointCoalescingNetDeviceImpl> > m_txBurstCompleteEvent;
+};
+
+/**
+ * \ingroup point-to-point
+ * \class PointToPointCoalescingNetDevice
+ * \brief A Device for a Point to Point Network Link with trace sources.
+ *
+ * This is the device installed by PointToPointCoalescingHelper by default.
+ * It provides the MAC, PHY and sniffer trace sources used by the pcap and
+ * ascii tracing helpers.
+ */
+class PointToPointCoalescingNetDevice
+  : public PointToPointCoalescingNetDeviceImpl<PointToPointCoalescingDeviceTraces>
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Construct a PointToPointCoalescingNetDevice
+   */
+  PointToPointCoalescingNetDevice ();
+
+  /**
+   * Destroy a PointToPointCoalescingNetDevice
+   */
+  virtual ~PointToPointCoalescingNetDevice ();
+
+  /**
+   * TracedCallback signature for packets transmitted as part of a burst.
+   *
+   * \param [in] packet The packet being transmitted.
+   * \param [in] txStart Time at which the first bit is put on the wire.
+   * \param [in] txEnd Time at which the last bit is put on the wire.
+   */
+  typedef void (* BurstTxTracedCallback)
+    (Ptr<const Packet> packet, Time txStart, Time txEnd);
+};
+
+/**
+ * \ingroup point-to-point
+ * \class PointToPointCoalescingLeanNetDevice
+ * \brief A Device for a Point to Point Network Link without trace sources.
+ *
+ * Behaves as PointToPointCoalescingNetDevice and has the same attributes
+ * and measurement counters, but is built without the trace sources.  It
+ * is meant for large fabrics in which no trace sink is connected to the
+ * devices.  Pcap and ascii tracing are not available on it.
+ */
+class PointToPointCoalescingLeanNetDevice
+  : public PointToPointCoalescingNetDeviceImpl<PointToPointCoalescingNoTraces>
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Construct a PointToPointCoalescingLeanNetDevice
+   */
+  PointToPointCoalescingLeanNetDevice ();
+
+  /**
+   * Destroy a PointToPointCoalescingLeanNetDevice
+   */
+  virtual ~PointToPointCoalescingLeanNetDevice ();
 };
 
 } // namespace ns3
@@ -0,0 +1,94 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Extended from implementation of point to point net device included in ns-3.30.1 available at
+ * https://www.nsnam.org/releases/ns-3-30/
+ * 
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#include "point-to-point-coalescing-partition-channel.h"
+#include "point-to-point-coalescing-net-device.h"
+#include "coalescing-partition-interface.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointCoalescingPartitionChannel");
+
+NS_OBJECT_ENSURE_REGISTERED (PointToPointCoalescingPartitionChannel);
+
+TypeId
+PointToPointCoalescingPartitionChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PointToPointCoalescingPartitionChannel")
+    .SetParent<PointToPointCoalescingChannel> ()
+    .SetGroupName ("PointToPointCoalescing")
+    .AddConstructor<PointToPointCoalescingPartitionChannel> ()
+  ;
+  return tid;
+}
+
+PointToPointCoalescingPartitionChannel::PointToPointCoalescingPartitionChannel ()
+  : PointToPointCoalescingChannel ()
+{
+}
+
+PointToPointCoalescingPartitionChannel::~PointToPointCoalescingPartitionChannel ()
+{
+}
+
+bool
+PointToPointCoalescingPartitionChannel::TransmitStart (
+  Ptr<const Packet> p,
+  Ptr<PointToPointCoalescingNetDeviceBase> src,
+  Time txTime)
+{
+  NS_LOG_FUNCTION (this << p << src);
+  NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
+
+  IsInitialized ();
+
+  uint32_t wire = src == GetSource (0) ? 0 : 1;
+  Ptr<PointToPointCoalescingNetDeviceBase> dst = GetDestination (wire);
+  Ptr<Node> node = dst->GetNode ();
+
+  // The packet is serialized into the ring, so it does not need a copy
+  Time rxTime = Simulator::Now () + txTime + GetDelay ();
+  CoalescingPartitionInterface::Send (ConstCast<Packet> (p), rxTime, node->GetSystemId (), node->GetId (), dst->GetIfIndex ());
+  return true;
+}
+
+bool
+PointToPointCoalescingPartitionChannel::TransmitBurst (
+  const std::vector<Ptr<Packet> > &packets,
+  const std::vector<Time> &txEnd,
+  Ptr<PointToPointCoalescingNetDeviceBase> src)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+  NS_ASSERT (packets.size () == txEnd.size ());
+
+  bool result = true;
+  for (std::size_t i = 0; i < packets.size (); ++i)
+    {
+      result &= TransmitStart (packets[i], src, txEnd[i]);
+    }
+  return result;
+}
+
+} // namespace ns3
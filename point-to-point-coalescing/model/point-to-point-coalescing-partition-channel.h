@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Extended from implementation of point to point net device included in ns-3.30.1 available at
+ * https://www.nsnam.org/releases/ns-3-30/
+ * 
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+
+#ifndef POINT_TO_POINT_COALESCING_PARTITION_CHANNEL_H
+#define POINT_TO_POINT_COALESCING_PARTITION_CHANNEL_H
+
+#include "point-to-point-coalescing-channel.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ *
+ * \brief A Point-To-Point Channel between two partitions of one machine
+ *
+ * This object connects two point-to-point net devices whose nodes belong
+ * to different partitions of a partitioned execution, see
+ * CoalescingPartitionInterface.  It overrides the transmit methods and
+ * writes the frames to the shared memory ring of the partition of the
+ * receiving node instead.
+ */
+class PointToPointCoalescingPartitionChannel : public PointToPointCoalescingChannel
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Constructor
+   */
+  PointToPointCoalescingPartitionChannel ();
+
+  /**
+   * \brief Destructor
+   */
+  ~PointToPointCoalescingPartitionChannel ();
+
+  /**
+   * \brief Transmit the packet
+   *
+   * \param p Packet to transmit
+   * \param src Source PointToPointCoalescingNetDeviceBase
+   * \param txTime Transmit time to apply
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointCoalescingNetDeviceBase> src,
+                              Time txTime);
+
+  /**
+   * \brief Transmit a burst of packets
+   *
+   * Each packet of the burst is written to the ring separately, which
+   * only copies it.
+   *
+   * \param packets Packets to transmit, in transmission order
+   * \param txEnd Time at which the last bit of each packet is transmitted,
+   * relative to the start of the burst
+   * \param src Source PointToPointCoalescingNetDeviceBase
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitBurst (const std::vector<Ptr<Packet> > &packets,
+                              const std::vector<Time> &txEnd,
+                              Ptr<PointToPointCoalescingNetDeviceBase> src);
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_COALESCING_PARTITION_CHANNEL_H */
@@ -19,12 +19,17 @@
 */
 
 #include <iostream>
+#include <vector>
 
 #include "point-to-point-coalescing-remote-channel.h"
 #include "point-to-point-coalescing-net-device.h"
+#include "coalescing-burst-header.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/node.h"
 #include "ns3/mpi-interface.h"
 
 namespace ns3 {
@@ -40,12 +45,19 @@ PointToPointCoalescingRemoteChannel::GetTypeId (void)
     .SetParent<PointToPointCoalescingChannel> ()
     .SetGroupName ("PointToPointCoalescing")
     .AddConstructor<PointToPointCoalescingRemoteChannel> ()
+    .AddAttribute ("BatchBursts",
+                   "Send the frames of a burst to the remote system in one message, "
+                   "which must be set the same on all systems",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointCoalescingRemoteChannel::m_batchBursts),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 PointToPointCoalescingRemoteChannel::PointToPointCoalescingRemoteChannel ()
-  : PointToPointCoalescingChannel ()
+  : PointToPointCoalescingChannel (),
+    m_batchBursts (false)
 {
 }
 
@@ -56,25 +68,105 @@ PointToPointCoalescingRemoteChannel::~PointToPointCoalescingRemoteChannel ()
 bool
 PointToPointCoalescingRemoteChannel::TransmitStart (
   Ptr<const Packet> p,
-  Ptr<PointToPointCoalescingNetDevice> src,
+  Ptr<PointToPointCoalescingNetDeviceBase> src,
   Time txTime)
 {
   NS_LOG_FUNCTION (this << p << src);
   NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
 
+  if (m_batchBursts)
+    {
+      // the receiving device unpacks every frame, so a single one is sent as a burst too
+      SendBatch (std::vector<Ptr<Packet> > (1, ConstCast<Packet> (p)), std::vector<Time> (1, txTime), src);
+      return true;
+    }
+
   IsInitialized ();
 
   uint32_t wire = src == GetSource (0) ? 0 : 1;
-  Ptr<PointToPointCoalescingNetDevice> dst = GetDestination (wire);
+  Ptr<PointToPointCoalescingNetDeviceBase> dst = GetDestination (wire);
 
 #ifdef NS3_MPI
   // Calculate the rxTime (absolute)
   Time rxTime = Simulator::Now () + txTime + GetDelay ();
-  MpiInterface::SendPacket (p->Copy (), rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
+  // The packet is serialized by the send, so it does not need a copy
+  MpiInterface::SendPacket (ConstCast<Packet> (p), rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
   return true;
 }
 
+bool
+PointToPointCoalescingRemoteChannel::TransmitBurst (
+  const std::vector<Ptr<Packet> > &packets,
+  const std::vector<Time> &txEnd,
+  Ptr<PointToPointCoalescingNetDeviceBase> src)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+  NS_ASSERT (packets.size () == txEnd.size ());
+
+  if (m_batchBursts)
+    {
+      SendBatch (packets, txEnd, src);
+      return true;
+    }
+
+  bool result = true;
+  for (std::size_t i = 0; i < packets.size (); ++i)
+    {
+      result &= TransmitStart (packets[i], src, txEnd[i]);
+    }
+  return result;
+}
+
+bool
+PointToPointCoalescingRemoteChannel::GetBatchBursts (void) const
+{
+  return m_batchBursts;
+}
+
+void
+PointToPointCoalescingRemoteChannel::SendBatch (
+  const std::vector<Ptr<Packet> > &packets,
+  const std::vector<Time> &txEnd,
+  Ptr<PointToPointCoalescingNetDeviceBase> src)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+  NS_ASSERT (!packets.empty ());
+
+  IsInitialized ();
+
+  uint32_t wire = src == GetSource (0) ? 0 : 1;
+  Ptr<PointToPointCoalescingNetDeviceBase> dst = GetDestination (wire);
+
+#ifdef NS3_MPI
+  //
+  // The message is delivered when the first frame arrives, and the header
+  // keeps the arrival of the others relative to it.  Each frame is
+  // serialized with its uid, tags and metadata, as MpiInterface::SendPacket
+  // does for a single frame, and the frames follow the header as payload.
+  //
+  CoalescingBurstHeader header;
+  std::vector<uint8_t> frames;
+  for (std::size_t i = 0; i < packets.size (); ++i)
+    {
+      NS_LOG_LOGIC ("UID is " << packets[i]->GetUid () << ")");
+      uint32_t size = packets[i]->GetSerializedSize ();
+      std::size_t offset = frames.size ();
+      frames.resize (offset + size);
+      // serialized sizes are multiples of 4, so every frame stays aligned
+      NS_ABORT_MSG_IF (packets[i]->Serialize (&frames[offset], size) == 0,
+                       "Cannot serialize packet " << packets[i]->GetUid ());
+      header.AddFrame (size, txEnd[i] - txEnd[0]);
+    }
+  Ptr<Packet> batch = Create<Packet> (&frames[0], frames.size ());
+  batch->AddHeader (header);
+  Time rxTime = Simulator::Now () + txEnd[0] + GetDelay ();
+  MpiInterface::SendPacket (batch, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
 } // namespace ns3
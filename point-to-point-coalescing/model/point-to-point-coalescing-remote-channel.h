@@ -37,6 +37,11 @@ namespace ns3 {
  * This object connects two point-to-point net devices where at least one
  * is not local to this simulator object. It simply override the transmit
  * method and uses an MPI Send operation instead.
+ *
+ * The distributed simulator of ns-3 takes its lookahead from the Delay of
+ * the channel and has no hook for a larger one, so the state-dependent
+ * bound of PointToPointCoalescingChannel::GetEarliestArrival is only used
+ * by the windows of CoalescingPartitionInterface.
  */
 class PointToPointCoalescingRemoteChannel : public PointToPointCoalescingChannel
 {
@@ -58,16 +63,54 @@ public:
    */
   ~PointToPointCoalescingRemoteChannel ();
 
+  /**
+   * \returns true if frames are sent to the remote system in bursts, which
+   * the receiving device must unpack with DoMpiReceiveBurst
+   */
+  bool GetBatchBursts (void) const;
+
   /**
    * \brief Transmit the packet
    *
    * \param p Packet to transmit
-   * \param src Source PointToPointCoalescingNetDevice
+   * \param src Source PointToPointCoalescingNetDeviceBase
    * \param txTime Transmit time to apply
    * \returns true if successful (currently always true)
    */
-  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointCoalescingNetDevice> src,
+  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointCoalescingNetDeviceBase> src,
                               Time txTime);
+
+  /**
+   * \brief Transmit a burst of packets
+   *
+   * Each packet of the burst is sent to the remote system separately,
+   * unless BatchBursts is true, in which case the whole burst is sent in
+   * one message.
+   *
+   * \param packets Packets to transmit, in transmission order
+   * \param txEnd Time at which the last bit of each packet is transmitted,
+   * relative to the start of the burst
+   * \param src Source PointToPointCoalescingNetDeviceBase
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitBurst (const std::vector<Ptr<Packet> > &packets,
+                              const std::vector<Time> &txEnd,
+                              Ptr<PointToPointCoalescingNetDeviceBase> src);
+
+private:
+  /**
+   * \brief Send frames to the remote system in one message
+   *
+   * \param packets Packets to transmit, in transmission order
+   * \param txEnd Time at which the last bit of each packet is transmitted,
+   * relative to now
+   * \param src Source PointToPointCoalescingNetDeviceBase
+   */
+  void SendBatch (const std::vector<Ptr<Packet> > &packets,
+                  const std::vector<Time> &txEnd,
+                  Ptr<PointToPointCoalescingNetDeviceBase> src);
+
+  bool m_batchBursts; //!< Send a burst in one message
 };
 
 } // namespace ns3
@@ -0,0 +1,221 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <string>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/coalescing-partition-helper.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Partitioning of a leaf-spine topology
+ *
+ * Every leaf is linked to every spine at 10 Gb/s and to its servers at
+ * 5 Gb/s, all with a delay of 30 us, as in the example.  The parts must
+ * stay within the allowed load, and a server must be in the part of its
+ * leaf, since cutting its link never helps.
+ */
+class CoalescingPartitionLeafSpineTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param nLeaves number of leaves
+   * \param nSpines number of spines
+   * \param nServers number of servers of each leaf
+   * \param nParts number of partitions
+   */
+  CoalescingPartitionLeafSpineTestCase (uint32_t nLeaves, uint32_t nSpines, uint32_t nServers, uint32_t nParts);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nLeaves;   //!< Number of leaves
+  uint32_t m_nSpines;   //!< Number of spines
+  uint32_t m_nServers;  //!< Number of servers of each leaf
+  uint32_t m_nParts;    //!< Number of partitions
+};
+
+CoalescingPartitionLeafSpineTestCase::CoalescingPartitionLeafSpineTestCase (uint32_t nLeaves, uint32_t nSpines,
+                                                                            uint32_t nServers, uint32_t nParts)
+  : TestCase ("Leaf-spine topology of " + std::to_string (nLeaves) + " leaves, " + std::to_string (nSpines)
+              + " spines and " + std::to_string (nServers) + " servers per leaf in "
+              + std::to_string (nParts) + " partitions"),
+    m_nLeaves (nLeaves),
+    m_nSpines (nSpines),
+    m_nServers (nServers),
+    m_nParts (nParts)
+{
+}
+
+void
+CoalescingPartitionLeafSpineTestCase::DoRun (void)
+{
+  const double imbalance = 0.05;
+
+  // leaves first, then spines, then the servers of each leaf
+  CoalescingPartitionHelper partitioner;
+  partitioner.SetImbalance (imbalance);
+  for (uint32_t l = 0; l < m_nLeaves; ++l)
+    {
+      for (uint32_t s = 0; s < m_nSpines; ++s)
+        {
+          partitioner.AddLink (l, m_nLeaves + s, 10e9, MicroSeconds (30));
+        }
+    }
+  uint32_t firstServer = m_nLeaves + m_nSpines;
+  for (uint32_t l = 0; l < m_nLeaves; ++l)
+    {
+      for (uint32_t h = 0; h < m_nServers; ++h)
+        {
+          partitioner.AddLink (l, firstServer + l * m_nServers + h, 5e9, MicroSeconds (30));
+        }
+    }
+
+  std::vector<uint32_t> part = partitioner.Partition (m_nParts);
+  NS_TEST_ASSERT_MSG_EQ (part.size (), firstServer + m_nLeaves * m_nServers, "Wrong number of nodes partitioned");
+
+  std::vector<double> loads = partitioner.GetPartLoads ();
+  NS_TEST_ASSERT_MSG_EQ (loads.size (), m_nParts, "Wrong number of parts");
+  double total = 0;
+  for (uint32_t p = 0; p < m_nParts; ++p)
+    {
+      total += loads[p];
+    }
+  for (uint32_t p = 0; p < m_nParts; ++p)
+    {
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (loads[p], (1 + imbalance) * total / m_nParts, "Part " << p << " is overloaded");
+    }
+
+  for (uint32_t l = 0; l < m_nLeaves; ++l)
+    {
+      for (uint32_t h = 0; h < m_nServers; ++h)
+        {
+          uint32_t server = firstServer + l * m_nServers + h;
+          NS_TEST_EXPECT_MSG_EQ (part[server], part[l], "Link of server " << server << " to leaf " << l << " is cut");
+        }
+    }
+}
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Partitioning of clusters joined by weak links
+ *
+ * Each cluster is a ring or a clique of nodes linked with traffic 10,
+ * and cluster k is linked to cluster k + 1, the last one to the first,
+ * with the given weak traffic, or not at all when it is 0.  With one
+ * part per cluster, every cluster must be a part of its own, so only the
+ * weak links are cut.
+ */
+class CoalescingPartitionClustersTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param nClusters number of clusters, and of partitions
+   * \param size number of nodes of each cluster
+   * \param clique true for cliques, false for rings
+   * \param weak traffic of the links between clusters, 0 for none
+   */
+  CoalescingPartitionClustersTestCase (uint32_t nClusters, uint32_t size, bool clique, double weak);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nClusters; //!< Number of clusters
+  uint32_t m_size;      //!< Number of nodes of each cluster
+  bool m_clique;        //!< Cliques instead of rings
+  double m_weak;        //!< Traffic of the links between clusters
+};
+
+CoalescingPartitionClustersTestCase::CoalescingPartitionClustersTestCase (uint32_t nClusters, uint32_t size,
+                                                                          bool clique, double weak)
+  : TestCase (std::to_string (nClusters) + (clique ? " cliques" : " rings") + " of " + std::to_string (size)
+              + " nodes" + (weak > 0 ? " joined by weak links" : "") + " in as many partitions"),
+    m_nClusters (nClusters),
+    m_size (size),
+    m_clique (clique),
+    m_weak (weak)
+{
+}
+
+void
+CoalescingPartitionClustersTestCase::DoRun (void)
+{
+  CoalescingPartitionHelper partitioner;
+  for (uint32_t c = 0; c < m_nClusters; ++c)
+    {
+      uint32_t first = c * m_size;
+      for (uint32_t i = 0; i < m_size; ++i)
+        {
+          for (uint32_t j = i + 1; j < m_size; ++j)
+            {
+              if (m_clique || j == i + 1 || (i == 0 && j == m_size - 1))
+                {
+                  partitioner.AddLink (first + i, first + j, 10, MicroSeconds (30));
+                }
+            }
+        }
+      if (m_weak > 0)
+        {
+          partitioner.AddLink (first, (c + 1) % m_nClusters * m_size + 1, m_weak, MicroSeconds (30));
+        }
+    }
+
+  std::vector<uint32_t> part = partitioner.Partition (m_nClusters);
+  NS_TEST_ASSERT_MSG_EQ (part.size (), m_nClusters * m_size, "Wrong number of nodes partitioned");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetCutTraffic (), m_nClusters * m_weak, "Wrong traffic cut");
+  for (uint32_t c = 0; c < m_nClusters; ++c)
+    {
+      for (uint32_t i = 1; i < m_size; ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ (part[c * m_size + i], part[c * m_size], "Cluster " << c << " is split");
+        }
+      for (uint32_t d = 0; d < c; ++d)
+        {
+          NS_TEST_EXPECT_MSG_NE (part[c * m_size], part[d * m_size], "Clusters " << d << " and " << c << " share a part");
+        }
+    }
+}
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Test suite of the coalescing partition helper
+ */
+class CoalescingPartitionHelperTestSuite : public TestSuite
+{
+public:
+  CoalescingPartitionHelperTestSuite ();
+};
+
+CoalescingPartitionHelperTestSuite::CoalescingPartitionHelperTestSuite ()
+  : TestSuite ("coalescing-partition-helper", UNIT)
+{
+  AddTestCase (new CoalescingPartitionLeafSpineTestCase (16, 8, 16, 4), TestCase::QUICK);
+  AddTestCase (new CoalescingPartitionLeafSpineTestCase (16, 8, 16, 3), TestCase::QUICK);
+  AddTestCase (new CoalescingPartitionLeafSpineTestCase (16, 8, 16, 8), TestCase::QUICK);
+  AddTestCase (new CoalescingPartitionLeafSpineTestCase (32, 16, 16, 8), TestCase::QUICK);
+  AddTestCase (new CoalescingPartitionClustersTestCase (4, 5, false, 0), TestCase::QUICK);
+  AddTestCase (new CoalescingPartitionClustersTestCase (4, 6, true, 1), TestCase::QUICK);
+}
+
+static CoalescingPartitionHelperTestSuite g_coalescingPartitionHelperTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,258 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <unistd.h>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/string.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/coalescing-measurement-format.h"
+#include "ns3/coalescing-measurement-sink.h"
+#include "ns3/coalescing-partition-interface.h"
+#include "ns3/point-to-point-coalescing-net-device.h"
+#include "ns3/point-to-point-coalescing-helper.h"
+
+using namespace ns3;
+
+namespace {
+
+typedef std::map<std::pair<uint32_t, uint32_t>, CoalescingMeasurementRecord> Records;
+
+// size of the frames the nodes send, and of the replies to them
+const uint32_t REQUEST_SIZE = 1000;
+const uint32_t REPLY_SIZE = 200;
+
+} // namespace
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Two partitions give the measurements of a sequential run
+ *
+ * Four nodes form a square, nodes 0 and 1 in one partition and nodes 2 and
+ * 3 in the other, so two of the links cross partitions.  Every node sends
+ * bursts of frames on each of its links, with gaps long enough for the
+ * ports to go to low power, and replies to every frame it receives, so
+ * the traffic in one partition depends on the frames of the other one.
+ * The measurements of every port, gathered into one file by partition 0,
+ * must equal those of the same topology run in one process.
+ */
+class CoalescingPartitionInterfaceTestCase : public TestCase
+{
+public:
+  CoalescingPartitionInterfaceTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Build the topology, run it and write the measurements
+   *
+   * \param partitioned true to run nodes 2 and 3 in a second partition
+   * \param path file the measurements are written to
+   */
+  void Run (bool partitioned, std::string path);
+
+  /**
+   * \brief Send a frame
+   *
+   * \param dev sending device
+   * \param size size of the frame
+   */
+  void Send (Ptr<NetDevice> dev, uint32_t size);
+
+  /**
+   * \brief Reply to a received frame
+   *
+   * \param dev receiving device
+   * \param p received frame
+   * \param protocol protocol of the frame
+   * \param from address of the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> dev, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Read the records of a measurement file
+   *
+   * \param path the file
+   * \param records the records, by node and interface
+   * \return true if the file was read
+   */
+  bool Read (std::string path, Records &records);
+};
+
+CoalescingPartitionInterfaceTestCase::CoalescingPartitionInterfaceTestCase ()
+  : TestCase ("Partitioned run of a square of four nodes against a sequential run")
+{
+}
+
+void
+CoalescingPartitionInterfaceTestCase::Send (Ptr<NetDevice> dev, uint32_t size)
+{
+  dev->Send (Create<Packet> (size), dev->GetBroadcast (), 0x0800);
+}
+
+bool
+CoalescingPartitionInterfaceTestCase::Receive (Ptr<NetDevice> dev, Ptr<const Packet> p, uint16_t protocol,
+                                               const Address &from)
+{
+  if (p->GetSize () == REQUEST_SIZE)
+    {
+      Send (dev, REPLY_SIZE);
+    }
+  return true;
+}
+
+void
+CoalescingPartitionInterfaceTestCase::Run (bool partitioned, std::string path)
+{
+  if (partitioned)
+    {
+      CoalescingPartitionInterface::Enable (2, 1024 * 1024);
+    }
+
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      nodes.Create (1, partitioned ? i / 2 : 0);
+    }
+
+  PointToPointCoalescingHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("30us"));
+  NetDeviceContainer devices;
+  devices.Add (p2p.Install (nodes.Get (0), nodes.Get (1)));
+  devices.Add (p2p.Install (nodes.Get (2), nodes.Get (3)));
+  devices.Add (p2p.Install (nodes.Get (0), nodes.Get (2)));
+  devices.Add (p2p.Install (nodes.Get (1), nodes.Get (3)));
+
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      Ptr<NetDevice> dev = devices.Get (i);
+      dev->SetReceiveCallback (MakeCallback (&CoalescingPartitionInterfaceTestCase::Receive, this));
+
+      // bursts of 5 frames every 2 ms, shifted per device
+      Ptr<Node> node = dev->GetNode ();
+      if (partitioned && node->GetSystemId () != CoalescingPartitionInterface::GetPartition ())
+        {
+          continue;
+        }
+      for (uint32_t burst = 0; burst < 50; ++burst)
+        {
+          for (uint32_t k = 0; k < 5; ++k)
+            {
+              Time t = MicroSeconds (2000 * burst + 13 * i + 2 * k);
+              Simulator::ScheduleWithContext (node->GetId (), t, &CoalescingPartitionInterfaceTestCase::Send,
+                                              this, dev, REQUEST_SIZE);
+            }
+        }
+    }
+
+  Simulator::Stop (MilliSeconds (110));
+  Simulator::Run ();
+
+  Ptr<CoalescingMeasurementSink> sink = CreateObject<CoalescingMeasurementSink> ();
+  sink->SetAttribute ("OutputPath", StringValue (path));
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      DynamicCast<PointToPointCoalescingNetDeviceBase> (devices.Get (i))->WriteMeasurementsData (sink);
+    }
+  sink->Close ();
+  Simulator::Destroy ();
+
+  if (partitioned)
+    {
+      CoalescingPartitionInterface::Disable ();
+      // the other partition is a copy of the test runner, which must not
+      // go on with the other tests
+      if (CoalescingPartitionInterface::GetPartition () != 0)
+        {
+          _exit (0);
+        }
+    }
+}
+
+bool
+CoalescingPartitionInterfaceTestCase::Read (std::string path, Records &records)
+{
+  std::ifstream is (path.c_str (), std::ios::binary);
+  CoalescingMeasurementFormat::Layout layout;
+  if (!CoalescingMeasurementFormat::ReadHeader (is, layout))
+    {
+      return false;
+    }
+  CoalescingMeasurementRecord r;
+  while (CoalescingMeasurementFormat::ReadRecord (is, layout, r))
+    {
+      records[std::make_pair (r.nodeId, r.ifIndex)] = r;
+    }
+  return true;
+}
+
+void
+CoalescingPartitionInterfaceTestCase::DoRun (void)
+{
+  std::string sequentialPath = CreateTempDirFilename ("sequential.bin");
+  std::string partitionedPath = CreateTempDirFilename ("partitioned.bin");
+  Run (false, sequentialPath);
+  Run (true, partitionedPath);
+  NS_TEST_ASSERT_MSG_EQ (CoalescingPartitionInterface::GetNFailed (), 0u, "A partition failed");
+
+  Records sequential;
+  Records partitioned;
+  NS_TEST_ASSERT_MSG_EQ (Read (sequentialPath, sequential), true, "Cannot read " << sequentialPath);
+  NS_TEST_ASSERT_MSG_EQ (Read (partitionedPath, partitioned), true, "Cannot read " << partitionedPath);
+  NS_TEST_ASSERT_MSG_EQ (sequential.size (), 8u, "Wrong number of ports measured");
+  NS_TEST_ASSERT_MSG_EQ (partitioned.size (), sequential.size (), "Ports of a partition are missing");
+
+  for (Records::const_iterator i = sequential.begin (); i != sequential.end (); ++i)
+    {
+      Records::const_iterator j = partitioned.find (i->first);
+      NS_TEST_ASSERT_MSG_EQ ((j != partitioned.end ()), true, "Port " << i->first.first << "/" << i->first.second << " is missing");
+      NS_TEST_EXPECT_MSG_GT (i->second.lpIntervals, 0, "Port " << i->first.first << "/" << i->first.second << " never slept");
+      NS_TEST_EXPECT_MSG_EQ (j->second.packetCount, i->second.packetCount, "Packets of port " << i->first.first << "/" << i->first.second);
+      NS_TEST_EXPECT_MSG_EQ (j->second.packetBytes, i->second.packetBytes, "Bytes of port " << i->first.first << "/" << i->first.second);
+      NS_TEST_EXPECT_MSG_EQ (j->second.lpIntervals, i->second.lpIntervals, "Low power intervals of port " << i->first.first << "/" << i->first.second);
+      NS_TEST_EXPECT_MSG_EQ (j->second.lpTimeNs, i->second.lpTimeNs, "Low power time of port " << i->first.first << "/" << i->first.second);
+    }
+}
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Test suite of the partitioned execution
+ */
+class CoalescingPartitionInterfaceTestSuite : public TestSuite
+{
+public:
+  CoalescingPartitionInterfaceTestSuite ();
+};
+
+CoalescingPartitionInterfaceTestSuite::CoalescingPartitionInterfaceTestSuite ()
+  : TestSuite ("coalescing-partition-interface", SYSTEM)
+{
+  AddTestCase (new CoalescingPartitionInterfaceTestCase, TestCase::QUICK);
+}
+
+static CoalescingPartitionInterfaceTestSuite g_coalescingPartitionInterfaceTestSuite; //!< Static variable for test initialization
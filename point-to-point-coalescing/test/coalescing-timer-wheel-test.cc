@@ -0,0 +1,424 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * by Natasa Maksic, maksicn@etf.rs
+*/
+
+#include <utility>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/make-event.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/coalescing-timer-wheel.h"
+
+using namespace ns3;
+
+namespace {
+
+// no timer
+const uint32_t NONE = ~static_cast<uint32_t> (0);
+
+} // namespace
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Timers of the same nanosecond, cancel during Expire and overflow
+ *
+ * With a granularity of 1 us the wheel spans 64^4 us, about 16.8 s, so
+ * timers at 20 s wait in the overflow list.
+ */
+class CoalescingTimerWheelOrderTestCase : public TestCase
+{
+public:
+  CoalescingTimerWheelOrderTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Record a timer and run its action
+   *
+   * \param id timer
+   */
+  void Fire (uint32_t id);
+
+  /**
+   * \brief Schedule a timer
+   *
+   * \param id timer
+   * \param delay delay of the timer
+   */
+  void Add (uint32_t id, Time delay);
+
+  Ptr<CoalescingTimerWheel> m_wheel;                      //!< Wheel under test
+  std::vector<CoalescingTimerWheel::Timer> m_timers;      //!< Handle of each timer
+  std::vector<std::pair<uint32_t, Time> > m_fired;        //!< Timers fired, with their time
+};
+
+CoalescingTimerWheelOrderTestCase::CoalescingTimerWheelOrderTestCase ()
+  : TestCase ("Timers of the same nanosecond, cancel during expiry and overflow list")
+{
+}
+
+void
+CoalescingTimerWheelOrderTestCase::Add (uint32_t id, Time delay)
+{
+  m_timers[id] = m_wheel->Schedule (delay, Ptr<EventImpl> (MakeEvent (&CoalescingTimerWheelOrderTestCase::Fire, this, id), false));
+}
+
+void
+CoalescingTimerWheelOrderTestCase::Fire (uint32_t id)
+{
+  m_fired.push_back (std::make_pair (id, Simulator::Now ()));
+  if (id == 0)
+    {
+      // timer 1 is due now, after this one
+      m_wheel->Cancel (m_timers[1]);
+      NS_TEST_EXPECT_MSG_EQ (m_wheel->IsRunning (m_timers[1]), false, "Cancelled timer still running");
+      Add (5, Seconds (0));
+    }
+}
+
+void
+CoalescingTimerWheelOrderTestCase::DoRun (void)
+{
+  m_wheel = CreateObject<CoalescingTimerWheel> ();
+  m_wheel->SetAttribute ("Granularity", TimeValue (MicroSeconds (1)));
+  m_timers.assign (6, 0);
+  m_fired.clear ();
+
+  Add (0, MicroSeconds (10));
+  Add (1, MicroSeconds (10));
+  Add (2, MicroSeconds (10));
+  Add (3, Seconds (20));
+  Add (4, Seconds (20) + NanoSeconds (1));
+  NS_TEST_ASSERT_MSG_EQ (m_wheel->GetNPending (), 5, "Timers not pending");
+
+  Simulator::Run ();
+
+  std::vector<std::pair<uint32_t, Time> > expected;
+  expected.push_back (std::make_pair (0, MicroSeconds (10)));
+  expected.push_back (std::make_pair (2, MicroSeconds (10)));
+  expected.push_back (std::make_pair (5, MicroSeconds (10)));
+  expected.push_back (std::make_pair (3, Seconds (20)));
+  expected.push_back (std::make_pair (4, Seconds (20) + NanoSeconds (1)));
+  NS_TEST_ASSERT_MSG_EQ (m_fired.size (), expected.size (), "Wrong number of timers fired");
+  for (std::size_t i = 0; i < expected.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_fired[i].first, expected[i].first, "Timer " << i << " fired out of order");
+      NS_TEST_EXPECT_MSG_EQ (m_fired[i].second, expected[i].second, "Timer " << m_fired[i].first << " fired at the wrong time");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetNPending (), 0, "Timers left in the wheel");
+
+  Simulator::Destroy ();
+  m_wheel->Dispose ();
+  m_wheel = 0;
+}
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Random timers run by the wheel and by the simulator
+ *
+ * A random sequence of timers, some of which cancel other timers and
+ * schedule new ones when they fire, is run once with the wheel and once
+ * with Simulator::Schedule.  Both runs must fire the same timers in the
+ * same order and at the same times.
+ *
+ * The driver events, which start timers and cancel them, run at odd
+ * nanoseconds and the timers at even ones, since the wheel does not keep
+ * the order of its timers and other events of the same nanosecond.  Many
+ * timers fall on a grid of 10 us, so several expire at the same time, and
+ * some are longer than the span of the wheel.
+ */
+class CoalescingTimerWheelCompareTestCase : public TestCase
+{
+public:
+  /**
+   * \param granularity granularity of the wheel
+   */
+  CoalescingTimerWheelCompareTestCase (Time granularity);
+
+private:
+  virtual void DoRun (void);
+
+  /// Fired timers, with their time in nanoseconds
+  typedef std::vector<std::pair<uint32_t, int64_t> > Log;
+
+  /**
+   * \brief Run the sequence
+   *
+   * \param wheel true to use the wheel, false for the simulator
+   * \param log timers fired
+   */
+  void RunSequence (bool wheel, Log &log);
+
+  /**
+   * \brief Start a timer and cancel another one
+   *
+   * \param op index of the driver event
+   */
+  void Drive (uint32_t op);
+
+  /**
+   * \brief Record a timer, cancel another one and start a new one
+   *
+   * \param id timer
+   */
+  void Fire (uint32_t id);
+
+  /**
+   * \brief Start the next timer
+   */
+  void Start (void);
+
+  /**
+   * \brief Cancel a timer
+   *
+   * \param id timer, or NONE
+   */
+  void Cancel (uint32_t id);
+
+  /**
+   * \param u uniform value in [0, 1)
+   * \return a timer started so far, or NONE with probability 1/2
+   */
+  uint32_t PickTimer (double u) const;
+
+  Time m_granularity;                 //!< Granularity of the wheel
+
+  // the sequence, drawn once for both runs
+  std::vector<int64_t> m_driveNs;     //!< Time of each driver event
+  std::vector<double> m_driveCancel;  //!< Timer cancelled by each driver event
+  std::vector<uint32_t> m_kind;       //!< Kind of the delay of each timer
+  std::vector<double> m_value;        //!< Value of the delay of each timer
+  std::vector<double> m_fireCancel;   //!< Timer cancelled by each timer
+  std::vector<double> m_fireStart;    //!< Whether each timer starts a new one
+
+  // state of a run
+  bool m_useWheel;                    //!< The run uses the wheel
+  Ptr<CoalescingTimerWheel> m_wheel;  //!< Wheel of the run
+  uint32_t m_nStarted;                //!< Timers started so far
+  std::vector<CoalescingTimerWheel::Timer> m_handles; //!< Wheel handle of each timer
+  std::vector<EventId> m_events;      //!< Simulator event of each timer
+  Log *m_log;                         //!< Timers fired
+};
+
+CoalescingTimerWheelCompareTestCase::CoalescingTimerWheelCompareTestCase (Time granularity)
+  : TestCase ("Timers of the wheel match those of the simulator, granularity " + std::to_string (granularity.GetNanoSeconds ()) + " ns"),
+    m_granularity (granularity),
+    m_useWheel (false),
+    m_nStarted (0),
+    m_log (0)
+{
+}
+
+uint32_t
+CoalescingTimerWheelCompareTestCase::PickTimer (double u) const
+{
+  if (u < 0.5 || m_nStarted == 0)
+    {
+      return NONE;
+    }
+  return static_cast<uint32_t> ((u - 0.5) * 2 * m_nStarted);
+}
+
+void
+CoalescingTimerWheelCompareTestCase::Start (void)
+{
+  uint32_t id = m_nStarted;
+  if (id >= m_kind.size ())
+    {
+      return;
+    }
+  m_nStarted++;
+
+  // expiry at an even nanosecond, not earlier than now
+  int64_t nowNs = Simulator::Now ().GetNanoSeconds ();
+  int64_t atNs;
+  switch (m_kind[id])
+    {
+    case 0:
+      // on the grid of 10 us
+      atNs = (nowNs / 10000 + 1 + static_cast<int64_t> (m_value[id] * 50)) * 10000;
+      break;
+    case 1:
+      // up to 2 ms, possibly now
+      atNs = nowNs + 1 + static_cast<int64_t> (m_value[id] * 2000000);
+      atNs -= atNs % 2;
+      break;
+    case 2:
+      // up to 100 ms, in the higher levels
+      atNs = nowNs + 1000000 + static_cast<int64_t> (m_value[id] * 99000000);
+      atNs -= atNs % 2;
+      break;
+    default:
+      // beyond the span of the wheel, in the overflow list
+      atNs = nowNs + 17000000000LL + static_cast<int64_t> (m_value[id] * 23000000000LL);
+      atNs -= atNs % 2;
+      break;
+    }
+  if (atNs < nowNs)
+    {
+      atNs += 2;
+    }
+
+  Time delay = NanoSeconds (atNs - nowNs);
+  if (m_useWheel)
+    {
+      m_handles[id] = m_wheel->Schedule (delay, Ptr<EventImpl> (MakeEvent (&CoalescingTimerWheelCompareTestCase::Fire, this, id), false));
+    }
+  else
+    {
+      m_events[id] = Simulator::Schedule (delay, &CoalescingTimerWheelCompareTestCase::Fire, this, id);
+    }
+}
+
+void
+CoalescingTimerWheelCompareTestCase::Cancel (uint32_t id)
+{
+  if (id == NONE)
+    {
+      return;
+    }
+  if (m_useWheel)
+    {
+      m_wheel->Cancel (m_handles[id]);
+    }
+  else
+    {
+      m_events[id].Cancel ();
+    }
+}
+
+void
+CoalescingTimerWheelCompareTestCase::Drive (uint32_t op)
+{
+  Cancel (PickTimer (m_driveCancel[op]));
+  Start ();
+}
+
+void
+CoalescingTimerWheelCompareTestCase::Fire (uint32_t id)
+{
+  m_log->push_back (std::make_pair (id, Simulator::Now ().GetNanoSeconds ()));
+  Cancel (PickTimer (m_fireCancel[id]));
+  if (m_fireStart[id] < 0.5)
+    {
+      Start ();
+    }
+}
+
+void
+CoalescingTimerWheelCompareTestCase::RunSequence (bool wheel, Log &log)
+{
+  m_useWheel = wheel;
+  m_nStarted = 0;
+  m_handles.assign (m_kind.size (), 0);
+  m_events.assign (m_kind.size (), EventId ());
+  m_log = &log;
+  if (wheel)
+    {
+      m_wheel = CreateObject<CoalescingTimerWheel> ();
+      m_wheel->SetAttribute ("Granularity", TimeValue (m_granularity));
+    }
+
+  for (uint32_t op = 0; op < m_driveNs.size (); ++op)
+    {
+      Simulator::Schedule (NanoSeconds (m_driveNs[op]), &CoalescingTimerWheelCompareTestCase::Drive, this, op);
+    }
+  Simulator::Run ();
+
+  if (wheel)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_wheel->GetNPending (), 0, "Timers left in the wheel");
+      m_wheel->Dispose ();
+      m_wheel = 0;
+    }
+  Simulator::Destroy ();
+  m_log = 0;
+}
+
+void
+CoalescingTimerWheelCompareTestCase::DoRun (void)
+{
+  const uint32_t nDrive = 2000;
+  const uint32_t nTimers = 6000;
+
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  u->SetStream (1);
+  m_driveNs.resize (nDrive);
+  m_driveCancel.resize (nDrive);
+  for (uint32_t i = 0; i < nDrive; ++i)
+    {
+      // odd nanoseconds within the first second
+      m_driveNs[i] = 2 * static_cast<int64_t> (u->GetValue () * 500000000) + 1;
+      m_driveCancel[i] = u->GetValue ();
+    }
+  m_kind.resize (nTimers);
+  m_value.resize (nTimers);
+  m_fireCancel.resize (nTimers);
+  m_fireStart.resize (nTimers);
+  for (uint32_t i = 0; i < nTimers; ++i)
+    {
+      double k = u->GetValue ();
+      m_kind[i] = k < 0.4 ? 0 : k < 0.8 ? 1 : k < 0.95 ? 2 : 3;
+      m_value[i] = u->GetValue ();
+      m_fireCancel[i] = u->GetValue ();
+      m_fireStart[i] = u->GetValue ();
+    }
+
+  Log reference;
+  RunSequence (false, reference);
+  Log wheel;
+  RunSequence (true, wheel);
+
+  NS_TEST_ASSERT_MSG_GT (reference.size (), nDrive / 2, "Too few timers fired to compare");
+  uint32_t sameTime = 0;
+  for (std::size_t i = 1; i < reference.size (); ++i)
+    {
+      sameTime += reference[i].second == reference[i - 1].second ? 1 : 0;
+    }
+  NS_TEST_ASSERT_MSG_GT (sameTime, 0, "No timers of the same nanosecond");
+
+  NS_TEST_ASSERT_MSG_EQ (wheel.size (), reference.size (), "Wheel fired a different number of timers");
+  for (std::size_t i = 0; i < reference.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (wheel[i].first, reference[i].first, "Timer " << i << " fired out of order");
+      NS_TEST_ASSERT_MSG_EQ (wheel[i].second, reference[i].second, "Timer " << wheel[i].first << " fired at the wrong time");
+    }
+}
+
+/**
+ * \ingroup point-to-point-coalescing
+ * \brief Test suite of the coalescing timer wheel
+ */
+class CoalescingTimerWheelTestSuite : public TestSuite
+{
+public:
+  CoalescingTimerWheelTestSuite ();
+};
+
+CoalescingTimerWheelTestSuite::CoalescingTimerWheelTestSuite ()
+  : TestSuite ("coalescing-timer-wheel", UNIT)
+{
+  AddTestCase (new CoalescingTimerWheelOrderTestCase, TestCase::QUICK);
+  AddTestCase (new CoalescingTimerWheelCompareTestCase (MicroSeconds (1)), TestCase::QUICK);
+  AddTestCase (new CoalescingTimerWheelCompareTestCase (NanoSeconds (1)), TestCase::QUICK);
+  AddTestCase (new CoalescingTimerWheelCompareTestCase (NanoSeconds (700)), TestCase::QUICK);
+}
+
+static CoalescingTimerWheelTestSuite g_coalescingTimerWheelTestSuite; //!< Static variable for test initialization
@@ -17,6 +17,7 @@
 
 import sys
 import os
+import glob
 import numpy
 from scipy.special import gamma as Gamma
 from scipy.special import gammaincc as GammaIncc1
@@ -24,6 +25,7 @@ from scipy.misc import factorial as Factorial
 from pylab import *
 from scipy.stats import poisson
 import math
+import struct
 from datetime import datetime
 
 def GammaIncc(a, b):
@@ -166,21 +168,42 @@ def eng_string( x, format='%s', si=True):
 
 
 
-def parse_file( fileName):
-    f = open(fileName, 'r+')
-    lines = f.readlines()	
+# Column types of the measurement file, see coalescing-measurement-format.h
+COLUMN_FORMATS = {1: 'I', 2: 'Q', 3: 'd'}
+
+def read_measurements(fileName):
+    f = open(fileName, 'rb')
+    data = f.read()
+    f.close()
+    if data[0:8] != b'EEEMEAS\0':
+        raise ValueError(fileName + ": not a measurement file")
+    version, ncolumns = struct.unpack_from('<II', data, 8)
+    offset = 16
+    names = []
+    fmt = '<'
+    for i in range(ncolumns):
+        ctype, nlen = struct.unpack_from('<BB', data, offset)
+        names.append(data[offset + 2:offset + 2 + nlen].decode('ascii'))
+        fmt += COLUMN_FORMATS[ctype]
+        offset += 2 + nlen
+    size = struct.calcsize(fmt)
+    records = []
+    while offset + size <= len(data):
+        records.append(dict(zip(names, struct.unpack_from(fmt, data, offset))))
+        offset += size
+    return records
 
+def parse_file( fileName):
     result = []
-    for line in lines:
-       a=[x.strip() for x in line.split(' ')]
-       nodeId = int(a[0])
-       portId = int(a[1])
-       lpTimeNs = float(a[2])
-       lpIntervals = int(a[3])
-       packetCount = int(a[4])
-       packetBytes = int(a[5])
-       ex = float(a[6])
-       linkspeed = float(a[7])
+    for r in read_measurements(fileName):
+       nodeId = r['nodeId']
+       portId = r['ifIndex']
+       lpTimeNs = r['lpTimeNs']
+       lpIntervals = r['lpIntervals']
+       packetCount = r['packetCount']
+       packetBytes = r['packetBytes']
+       ex = r['meanInterarrival']
+       linkspeed = float(r['dataRate'])
        theoreticEtoff = 0
        theoretic2 = 0
        if packetCount > 0:
@@ -209,10 +232,10 @@ def parse_file( fileName):
 
 
 
-def parse_files(fileNameBase):
+def parse_files(folder):
     result = []
-    for i in range(1,101):
-        result.extend(parse_file(fileNameBase + str(i) +  ".txt"))
+    for name in sorted(glob.glob(os.path.join(folder, "data*.bin"))):
+        result.extend(parse_file(name))
     return result
 
 def separatePortMeasurements(measurements):
@@ -275,7 +298,11 @@ def calculateCfdIntervals(portMeasurements, resultFile):
         portCfdIntervals(m[1], f)
     f.close()
 
-measurements = parse_files("simulations/data")
+# folder with the results of one configuration of sweep.py
+folder = "simulations"
+if len(sys.argv) > 1:
+    folder = sys.argv[1]
+measurements = parse_files(folder)
 portMeasurements = separatePortMeasurements(measurements)
 calculateCfdIntervals(portMeasurements, "results.txt")
 
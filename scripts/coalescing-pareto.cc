@@ -0,0 +1,341 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Natasa Maksic, maksicn@etf.rs
+ */
+
+//
+// Evaluates a whole grid of coalescing configurations on the recorded
+// arrivals of each port in one pass over its trace, with the vectorized
+// CoalescingMultiModel, and writes the trade-off between the energy ratio
+// and the delay added by coalescing.  The grid is the product of the given
+// byte limits, timeouts, sleep times and wake-up times.  Ports are
+// evaluated in parallel on all cores.  For every port and configuration
+// the result file has one line:
+//
+//   node port timeout byteLimit sleepTime wakeUpTime eToff phi delay pareto
+//
+// where delay is the mean time from the arrival of a packet to the start
+// of its transmission, in seconds, and pareto is 1 for the configurations
+// on the Pareto front of the port: no other configuration has both a
+// lower energy ratio and a lower delay.
+//
+// Build, without ns-3, for the vector instructions of the machine.  The
+// lane loops of CoalescingMultiModel are only vectorized with
+// -fno-trapping-math:
+//
+//   g++ -O3 -march=native -fno-trapping-math -pthread -I../point-to-point-coalescing/model -o coalescing-pareto coalescing-pareto.cc ../point-to-point-coalescing/model/coalescing-multi-model.cc ../point-to-point-coalescing/model/coalescing-model.cc
+//
+// Usage:
+//
+//   ./coalescing-pareto [--timeout US,...] [--byte-limit BYTES,...] [--sleep-time US,...]
+//       [--wakeup-time US,...] [--port NODE:IF] [--threads N] [--out FILE] TRACE...
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "coalescing-arrival-trace.h"
+#include "coalescing-multi-model.h"
+
+using namespace ns3;
+
+namespace {
+
+// memory-mapped trace file
+struct Trace
+{
+  const uint8_t *base;
+  std::size_t length;
+  uint64_t endNs;
+  std::vector<CoalescingArrivalTraceFormat::Port> ports;
+};
+
+// evaluation of the grid on one port of one trace
+struct Job
+{
+  uint32_t trace;
+  uint32_t port;
+  std::vector<double> eToff;
+  std::vector<double> phi;
+  std::vector<double> delay;
+  uint64_t arrivals;
+};
+
+void
+Usage (const char *name)
+{
+  std::cerr << "usage: " << name << " [--timeout US,...] [--byte-limit BYTES,...] [--sleep-time US,...]\n"
+            << "    [--wakeup-time US,...] [--port NODE:IF] [--threads N] [--out FILE] TRACE..." << std::endl;
+  std::exit (2);
+}
+
+std::vector<double>
+ParseList (const char *s)
+{
+  std::vector<double> values;
+  std::stringstream ss (s);
+  std::string v;
+  while (std::getline (ss, v, ','))
+    {
+      values.push_back (std::atof (v.c_str ()));
+    }
+  return values;
+}
+
+bool
+Map (const std::string &path, Trace &trace)
+{
+  int fd = open (path.c_str (), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0 || st.st_size == 0)
+    {
+      if (fd >= 0)
+        {
+          close (fd);
+        }
+      return false;
+    }
+  void *p = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (p == MAP_FAILED)
+    {
+      return false;
+    }
+  trace.base = static_cast<const uint8_t *> (p);
+  trace.length = st.st_size;
+  return CoalescingArrivalTraceFormat::Read (trace.base, trace.length, trace.endNs, trace.ports);
+}
+
+// configurations on the front: sorted by energy ratio, a configuration is
+// on the front if its delay is below that of all configurations before it
+std::vector<bool>
+GetParetoFront (const std::vector<double> &phi, const std::vector<double> &delay)
+{
+  std::vector<std::pair<std::pair<double, double>, std::size_t> > order;
+  for (std::size_t i = 0; i < phi.size (); ++i)
+    {
+      order.push_back (std::make_pair (std::make_pair (phi[i], delay[i]), i));
+    }
+  std::sort (order.begin (), order.end ());
+  std::vector<bool> front (phi.size (), false);
+  double best = std::numeric_limits<double>::infinity ();
+  for (std::size_t k = 0; k < order.size (); ++k)
+    {
+      if (order[k].first.second < best)
+        {
+          best = order[k].first.second;
+          front[order[k].second] = true;
+        }
+    }
+  return front;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::vector<double> timeouts;
+  timeouts.push_back (100);
+  timeouts.push_back (200);
+  timeouts.push_back (400);
+  timeouts.push_back (800);
+  timeouts.push_back (1600);
+  std::vector<double> byteLimits;
+  for (int b = 6000; b <= 48000; b += 6000)
+    {
+      byteLimits.push_back (b);
+    }
+  CoalescingModel::Parameters base = CoalescingModel::GetDefaultParameters ();
+  std::vector<double> sleepTimes (1, base.sleepTime);
+  std::vector<double> wakeUpTimes (1, base.wakeUpTime);
+  bool onePort = false;
+  uint32_t nodeId = 0;
+  uint32_t ifIndex = 0;
+  unsigned nThreads = std::thread::hardware_concurrency ();
+  std::string out = "pareto.txt";
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      bool hasValue = i + 1 < argc;
+      if (std::strcmp (argv[i], "--timeout") == 0 && hasValue)
+        {
+          timeouts = ParseList (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--byte-limit") == 0 && hasValue)
+        {
+          byteLimits = ParseList (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--sleep-time") == 0 && hasValue)
+        {
+          sleepTimes = ParseList (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--wakeup-time") == 0 && hasValue)
+        {
+          wakeUpTimes = ParseList (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--port") == 0 && hasValue)
+        {
+          if (std::sscanf (argv[++i], "%u:%u", &nodeId, &ifIndex) != 2)
+            {
+              Usage (argv[0]);
+            }
+          onePort = true;
+        }
+      else if (std::strcmp (argv[i], "--threads") == 0 && hasValue)
+        {
+          nThreads = std::atoi (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--out") == 0 && hasValue)
+        {
+          out = argv[++i];
+        }
+      else if (argv[i][0] == '-')
+        {
+          Usage (argv[0]);
+        }
+      else
+        {
+          paths.push_back (argv[i]);
+        }
+    }
+  if (paths.empty ())
+    {
+      Usage (argv[0]);
+    }
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+
+  std::vector<CoalescingMultiModel::Configuration> grid;
+  for (std::size_t a = 0; a < timeouts.size (); ++a)
+    {
+      for (std::size_t b = 0; b < byteLimits.size (); ++b)
+        {
+          for (std::size_t c = 0; c < sleepTimes.size (); ++c)
+            {
+              for (std::size_t d = 0; d < wakeUpTimes.size (); ++d)
+                {
+                  CoalescingMultiModel::Configuration config;
+                  config.timeout = timeouts[a];
+                  config.byteLimit = byteLimits[b];
+                  config.sleepTime = sleepTimes[c];
+                  config.wakeUpTime = wakeUpTimes[d];
+                  grid.push_back (config);
+                }
+            }
+        }
+    }
+
+  std::vector<Trace> traces (paths.size ());
+  std::vector<Job> jobs;
+  for (uint32_t t = 0; t < paths.size (); ++t)
+    {
+      if (!Map (paths[t], traces[t]))
+        {
+          std::cerr << paths[t] << ": not an arrival trace" << std::endl;
+          return 1;
+        }
+      for (uint32_t p = 0; p < traces[t].ports.size (); ++p)
+        {
+          const CoalescingArrivalTraceFormat::Port &port = traces[t].ports[p];
+          if (port.nArrivals == 0 || (onePort && (port.nodeId != nodeId || port.ifIndex != ifIndex)))
+            {
+              continue;
+            }
+          Job job;
+          job.trace = t;
+          job.port = p;
+          job.arrivals = port.nArrivals;
+          jobs.push_back (job);
+        }
+    }
+
+  std::atomic<std::size_t> next (0);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < nThreads; ++w)
+    {
+      workers.push_back (std::thread ([&] () {
+        for (std::size_t j = next++; j < jobs.size (); j = next++)
+          {
+            const Trace &trace = traces[jobs[j].trace];
+            const CoalescingArrivalTraceFormat::Port &port = trace.ports[jobs[j].port];
+            CoalescingModel::Parameters p = base;
+            p.dataRate = port.dataRate;
+
+            CoalescingMultiModel model (grid, p);
+            CoalescingArrivalDecoder arrivals (trace.base + port.offset, port.size);
+            uint64_t timeNs;
+            uint32_t size;
+            while (arrivals.Next (timeNs, size))
+              {
+                model.Arrival (timeNs, size);
+              }
+            model.Finish (trace.endNs);
+
+            for (uint32_t i = 0; i < model.GetN (); ++i)
+              {
+                CoalescingMeasurementRecord r = model.GetMeasurementRecord (i, port.nodeId, port.ifIndex);
+                jobs[j].eToff.push_back (r.lpIntervals > 0 ? 1e-9 * r.lpTimeNs / r.lpIntervals : 0);
+                jobs[j].phi.push_back (model.GetEnergyRatio (i));
+                jobs[j].delay.push_back (model.GetMeanDelay (i));
+              }
+          }
+      }));
+    }
+  for (std::size_t w = 0; w < workers.size (); ++w)
+    {
+      workers[w].join ();
+    }
+  double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  std::ofstream os (out.c_str ());
+  os << "# node port timeout byteLimit sleepTime wakeUpTime eToff phi delay pareto" << std::endl;
+  uint64_t arrivals = 0;
+  for (std::size_t j = 0; j < jobs.size (); ++j)
+    {
+      const CoalescingArrivalTraceFormat::Port &port = traces[jobs[j].trace].ports[jobs[j].port];
+      std::vector<bool> front = GetParetoFront (jobs[j].phi, jobs[j].delay);
+      for (std::size_t i = 0; i < grid.size (); ++i)
+        {
+          os << port.nodeId << " " << port.ifIndex << " " << grid[i].timeout << " " << grid[i].byteLimit << " "
+             << grid[i].sleepTime << " " << grid[i].wakeUpTime << " " << jobs[j].eToff[i] << " "
+             << jobs[j].phi[i] << " " << jobs[j].delay[i] << " " << (front[i] ? 1 : 0) << std::endl;
+        }
+      arrivals += jobs[j].arrivals;
+    }
+
+  std::cerr << jobs.size () << " ports, " << grid.size () << " configurations, " << arrivals << " arrivals in "
+            << seconds << " s, " << (seconds > 0 ? arrivals * grid.size () / seconds : 0)
+            << " configuration-arrivals/s on " << nThreads << " threads" << std::endl;
+  return 0;
+}
@@ -0,0 +1,386 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Natasa Maksic, maksicn@etf.rs
+ */
+
+//
+// Replays recorded packet arrivals through the coalescing state machine of
+// the device, without ns-3, for every combination of the given coalescing
+// timeouts and byte limits.  Traces are written by the example with
+// --arrivalTrace and are memory-mapped, and every port of every trace and
+// configuration is replayed on its own, on all cores.
+//
+// For every configuration, a folder timeout<T>-limit<B> of the output
+// folder receives one measurement file per trace, in the format of the
+// simulations, so eee-validate and eee-aggregate can be used on them.  A
+// trace arrivals<seed>.bin gives data<seed>.bin.  File summary.txt has one
+// line per configuration:
+//
+//   timeout byteLimit ports eToff phi
+//
+// with E[Toff] over all low-power intervals and the energy ratio phi of
+// all ports together.
+//
+// The replay is exact for single-hop studies: the arrivals at a port do
+// not depend on its own coalescing parameters.  When all ports change
+// their parameters, the arrivals downstream of a coalescing port change
+// too, which the replay does not reproduce.
+//
+// Build, without ns-3:
+//
+//   g++ -O2 -pthread -I../point-to-point-coalescing/model -o coalescing-replay coalescing-replay.cc ../point-to-point-coalescing/model/coalescing-model.cc
+//
+// Usage:
+//
+//   ./coalescing-replay [--timeout US,...] [--byte-limit BYTES,...] [--limit RATE:BYTES]...
+//       [--policy NAME] [--packet-limit N] [--low-byte-limit BYTES] [--sleep-time US]
+//       [--wakeup-time US] [--burst 0|1] [--threads N] [--out FOLDER] TRACE...
+//
+// Ports whose data rate is given with --limit keep that byte limit in all
+// configurations.  The defaults are those of the example.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "coalescing-arrival-trace.h"
+#include "coalescing-measurement-format.h"
+#include "coalescing-model.h"
+
+using namespace ns3;
+
+namespace {
+
+// memory-mapped trace file
+struct Trace
+{
+  std::string name;
+  const uint8_t *base;
+  std::size_t length;
+  uint64_t endNs;
+  std::vector<CoalescingArrivalTraceFormat::Port> ports;
+};
+
+// one coalescing configuration
+struct Config
+{
+  double timeout;
+  double byteLimit;
+};
+
+// replay of one port of one trace with one configuration
+struct Job
+{
+  uint32_t config;
+  uint32_t trace;
+  uint32_t port;
+};
+
+struct Result
+{
+  CoalescingMeasurementRecord record;
+  double energy;
+  double energyWithoutEee;
+  uint64_t events;
+};
+
+void
+Usage (const char *name)
+{
+  std::cerr << "usage: " << name << " [--timeout US,...] [--byte-limit BYTES,...] [--limit RATE:BYTES]...\n"
+            << "    [--policy NAME] [--packet-limit N] [--low-byte-limit BYTES] [--sleep-time US]\n"
+            << "    [--wakeup-time US] [--burst 0|1] [--threads N] [--out FOLDER] TRACE..." << std::endl;
+  std::exit (2);
+}
+
+std::vector<double>
+ParseList (const char *s)
+{
+  std::vector<double> values;
+  std::stringstream ss (s);
+  std::string v;
+  while (std::getline (ss, v, ','))
+    {
+      values.push_back (std::atof (v.c_str ()));
+    }
+  return values;
+}
+
+bool
+Map (const std::string &path, Trace &trace)
+{
+  int fd = open (path.c_str (), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0 || st.st_size == 0)
+    {
+      if (fd >= 0)
+        {
+          close (fd);
+        }
+      return false;
+    }
+  void *p = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (p == MAP_FAILED)
+    {
+      return false;
+    }
+  trace.name = path;
+  trace.base = static_cast<const uint8_t *> (p);
+  trace.length = st.st_size;
+  return CoalescingArrivalTraceFormat::Read (trace.base, trace.length, trace.endNs, trace.ports);
+}
+
+// data<seed>.bin for arrivals<seed>.bin, data-<name> otherwise
+std::string
+GetOutputName (const std::string &path)
+{
+  std::string name = path.substr (path.rfind ('/') == std::string::npos ? 0 : path.rfind ('/') + 1);
+  if (name.compare (0, 8, "arrivals") == 0)
+    {
+      return "data" + name.substr (8);
+    }
+  return "data-" + name;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::vector<double> timeouts (1, 800);
+  std::vector<double> byteLimits (1, 24000);
+  std::map<uint64_t, double> limits;
+  CoalescingModel::Parameters base = CoalescingModel::GetDefaultParameters ();
+  unsigned nThreads = std::thread::hardware_concurrency ();
+  std::string out = "replay";
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      bool hasValue = i + 1 < argc;
+      if (std::strcmp (argv[i], "--timeout") == 0 && hasValue)
+        {
+          timeouts = ParseList (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--byte-limit") == 0 && hasValue)
+        {
+          byteLimits = ParseList (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--limit") == 0 && hasValue)
+        {
+          std::string s = argv[++i];
+          std::string::size_type colon = s.find (':');
+          if (colon == std::string::npos)
+            {
+              Usage (argv[0]);
+            }
+          limits[std::strtoull (s.substr (0, colon).c_str (), 0, 10)] = std::atof (s.substr (colon + 1).c_str ());
+        }
+      else if (std::strcmp (argv[i], "--policy") == 0 && hasValue)
+        {
+          std::string name = argv[++i];
+          int type = CoalescingPolicy::HYSTERESIS;
+          while (type >= 0 && name != CoalescingPolicy::GetName (static_cast<CoalescingPolicy::Type> (type)))
+            {
+              type--;
+            }
+          if (type < 0)
+            {
+              Usage (argv[0]);
+            }
+          base.policy = static_cast<CoalescingPolicy::Type> (type);
+        }
+      else if (std::strcmp (argv[i], "--packet-limit") == 0 && hasValue)
+        {
+          base.limits.packetLimit = std::atoi (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--low-byte-limit") == 0 && hasValue)
+        {
+          base.limits.lowByteLimit = std::atof (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--sleep-time") == 0 && hasValue)
+        {
+          base.sleepTime = std::atof (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--wakeup-time") == 0 && hasValue)
+        {
+          base.wakeUpTime = std::atof (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--burst") == 0 && hasValue)
+        {
+          base.burstTransmit = std::atoi (argv[++i]) != 0;
+        }
+      else if (std::strcmp (argv[i], "--threads") == 0 && hasValue)
+        {
+          nThreads = std::atoi (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--out") == 0 && hasValue)
+        {
+          out = argv[++i];
+        }
+      else if (argv[i][0] == '-')
+        {
+          Usage (argv[0]);
+        }
+      else
+        {
+          paths.push_back (argv[i]);
+        }
+    }
+  if (paths.empty () || timeouts.empty () || byteLimits.empty ())
+    {
+      Usage (argv[0]);
+    }
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+
+  std::vector<Trace> traces (paths.size ());
+  for (std::size_t t = 0; t < paths.size (); ++t)
+    {
+      if (!Map (paths[t], traces[t]))
+        {
+          std::cerr << paths[t] << ": not an arrival trace" << std::endl;
+          return 1;
+        }
+    }
+
+  std::vector<Config> configs;
+  for (std::size_t i = 0; i < timeouts.size (); ++i)
+    {
+      for (std::size_t j = 0; j < byteLimits.size (); ++j)
+        {
+          Config c;
+          c.timeout = timeouts[i];
+          c.byteLimit = byteLimits[j];
+          configs.push_back (c);
+        }
+    }
+
+  std::vector<Job> jobs;
+  for (uint32_t c = 0; c < configs.size (); ++c)
+    {
+      for (uint32_t t = 0; t < traces.size (); ++t)
+        {
+          for (uint32_t p = 0; p < traces[t].ports.size (); ++p)
+            {
+              Job job;
+              job.config = c;
+              job.trace = t;
+              job.port = p;
+              jobs.push_back (job);
+            }
+        }
+    }
+
+  //
+  // Jobs are independent and only read the mapped traces, so the workers
+  // share nothing but the index of the next job.
+  //
+  std::vector<Result> results (jobs.size ());
+  std::atomic<std::size_t> next (0);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < nThreads; ++w)
+    {
+      workers.push_back (std::thread ([&] () {
+        for (std::size_t j = next++; j < jobs.size (); j = next++)
+          {
+            const Trace &trace = traces[jobs[j].trace];
+            const CoalescingArrivalTraceFormat::Port &port = trace.ports[jobs[j].port];
+            CoalescingModel::Parameters p = base;
+            p.timeout = configs[jobs[j].config].timeout;
+            std::map<uint64_t, double>::const_iterator limit = limits.find (port.dataRate);
+            p.limits.byteLimit = limit != limits.end () ? limit->second : configs[jobs[j].config].byteLimit;
+            p.dataRate = port.dataRate;
+
+            CoalescingModel model (p);
+            CoalescingArrivalDecoder arrivals (trace.base + port.offset, port.size);
+            uint64_t timeNs;
+            uint32_t size;
+            while (arrivals.Next (timeNs, size))
+              {
+                model.Arrival (timeNs, size);
+              }
+            model.Finish (trace.endNs);
+
+            results[j].record = model.GetMeasurementRecord (port.nodeId, port.ifIndex);
+            results[j].energy = model.GetEnergy ();
+            results[j].energyWithoutEee = model.GetEnergyWithoutEee ();
+            results[j].events = model.GetNEvents ();
+          }
+      }));
+    }
+  for (std::size_t w = 0; w < workers.size (); ++w)
+    {
+      workers[w].join ();
+    }
+  double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  mkdir (out.c_str (), 0777);
+  std::ofstream summary ((out + "/summary.txt").c_str ());
+  summary << "# timeout byteLimit ports eToff phi" << std::endl;
+  uint64_t events = 0;
+  std::size_t j = 0;
+  for (uint32_t c = 0; c < configs.size (); ++c)
+    {
+      std::stringstream folder;
+      folder << out << "/timeout" << configs[c].timeout << "-limit" << configs[c].byteLimit;
+      mkdir (folder.str ().c_str (), 0777);
+
+      double lpTimeNs = 0;
+      uint64_t lpIntervals = 0;
+      double energy = 0;
+      double energyWithoutEee = 0;
+      uint32_t nPorts = 0;
+      for (uint32_t t = 0; t < traces.size (); ++t)
+        {
+          std::ofstream os ((folder.str () + "/" + GetOutputName (traces[t].name)).c_str (), std::ios::binary);
+          CoalescingMeasurementFormat::WriteHeader (os);
+          for (uint32_t p = 0; p < traces[t].ports.size (); ++p, ++j)
+            {
+              CoalescingMeasurementFormat::WriteRecord (os, results[j].record);
+              lpTimeNs += results[j].record.lpTimeNs;
+              lpIntervals += results[j].record.lpIntervals;
+              energy += results[j].energy;
+              energyWithoutEee += results[j].energyWithoutEee;
+              events += results[j].events;
+              nPorts++;
+            }
+        }
+      summary << configs[c].timeout << " " << configs[c].byteLimit << " " << nPorts << " "
+              << (lpIntervals > 0 ? 1e-9 * lpTimeNs / lpIntervals : 0) << " "
+              << (energyWithoutEee > 0 ? energy / energyWithoutEee : 0) << std::endl;
+    }
+
+  std::cerr << jobs.size () << " port replays, " << events << " events in " << seconds << " s, "
+            << (seconds > 0 ? events / seconds : 0) << " events/s on " << nThreads << " threads" << std::endl;
+  return 0;
+}
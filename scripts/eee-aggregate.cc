@@ -0,0 +1,216 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Natasa Maksic, maksicn@etf.rs
+ */
+
+//
+// Streaming confidence intervals of the per-port measurements of a
+// campaign.  Every measurement file is read once and its records are
+// folded into running mean and variance accumulators, so memory depends
+// on the number of ports only.  The results are rewritten after every
+// batch of new files, with one line per port:
+//
+//   node port runs eToff margin packetCount margin packetBytes margin
+//   meanInterarrival margin
+//
+// Build, without ns-3:
+//
+//   g++ -O2 -I../point-to-point-coalescing/model -o eee-aggregate eee-aggregate.cc ../point-to-point-coalescing/model/coalescing-measurement-aggregator.cc
+//
+// Usage:
+//
+//   ./eee-aggregate [--z Z] [--out FILE] [--follow SECONDS [--until RUNS]] FOLDER|FILE...
+//
+// Folders are scanned for data*.bin files.  With --follow the folders are
+// scanned again every SECONDS for files of new runs, until RUNS files have
+// been read.  sweep.py renames a measurement file into place only when the
+// run is complete, so a file found in the folder is always complete.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "coalescing-measurement-format.h"
+#include "coalescing-measurement-aggregator.h"
+
+using namespace ns3;
+
+namespace {
+
+void
+Usage (const char *name)
+{
+  std::cerr << "usage: " << name << " [--z Z] [--out FILE] [--follow SECONDS [--until RUNS]] FOLDER|FILE..." << std::endl;
+  std::exit (2);
+}
+
+bool
+IsDirectory (const std::string &path)
+{
+  struct stat st;
+  return stat (path.c_str (), &st) == 0 && S_ISDIR (st.st_mode);
+}
+
+// measurement files of the folder, sorted by name
+std::set<std::string>
+Scan (const std::string &folder)
+{
+  std::set<std::string> files;
+  DIR *dir = opendir (folder.c_str ());
+  if (dir == 0)
+    {
+      return files;
+    }
+  for (struct dirent *e = readdir (dir); e != 0; e = readdir (dir))
+    {
+      std::string name = e->d_name;
+      if (name.compare (0, 4, "data") == 0 && name.size () > 8
+          && name.compare (name.size () - 4, 4, ".bin") == 0)
+        {
+          files.insert (folder + "/" + name);
+        }
+    }
+  closedir (dir);
+  return files;
+}
+
+bool
+Fold (const std::string &file, CoalescingMeasurementAggregator &aggregator, uint64_t &nRecords)
+{
+  std::ifstream is (file.c_str (), std::ios::binary);
+  CoalescingMeasurementFormat::Layout layout;
+  if (!CoalescingMeasurementFormat::ReadHeader (is, layout))
+    {
+      std::cerr << file << ": not a measurement file" << std::endl;
+      return false;
+    }
+  CoalescingMeasurementRecord r;
+  while (CoalescingMeasurementFormat::ReadRecord (is, layout, r))
+    {
+      if (aggregator.AddRecord (r))
+        {
+          nRecords++;
+        }
+    }
+  return true;
+}
+
+// writes the results under a temporary name first, so readers never see
+// a partial file
+void
+WriteResults (const std::string &out, const CoalescingMeasurementAggregator &aggregator, double z)
+{
+  std::string tmp = out + ".part";
+  {
+    std::ofstream os (tmp.c_str ());
+    aggregator.Write (os, z);
+  }
+  std::rename (tmp.c_str (), out.c_str ());
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  double z = 2.33; // 98%
+  std::string out = "aggregate.txt";
+  int follow = 0;
+  uint64_t until = 0;
+  std::vector<std::string> sources;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      if (std::strcmp (argv[i], "--z") == 0 && i + 1 < argc)
+        {
+          z = std::atof (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--out") == 0 && i + 1 < argc)
+        {
+          out = argv[++i];
+        }
+      else if (std::strcmp (argv[i], "--follow") == 0 && i + 1 < argc)
+        {
+          follow = std::atoi (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--until") == 0 && i + 1 < argc)
+        {
+          until = std::strtoull (argv[++i], 0, 10);
+        }
+      else if (argv[i][0] == '-')
+        {
+          Usage (argv[0]);
+        }
+      else
+        {
+          sources.push_back (argv[i]);
+        }
+    }
+  if (sources.empty ())
+    {
+      Usage (argv[0]);
+    }
+
+  CoalescingMeasurementAggregator aggregator;
+  std::set<std::string> done;
+  uint64_t nRecords = 0;
+
+  for (;;)
+    {
+      uint32_t nNew = 0;
+      for (std::size_t i = 0; i < sources.size (); ++i)
+        {
+          std::set<std::string> files;
+          if (IsDirectory (sources[i]))
+            {
+              files = Scan (sources[i]);
+            }
+          else
+            {
+              files.insert (sources[i]);
+            }
+          for (std::set<std::string>::const_iterator f = files.begin (); f != files.end (); ++f)
+            {
+              if (done.insert (*f).second && Fold (*f, aggregator, nRecords))
+                {
+                  nNew++;
+                }
+            }
+        }
+
+      if (nNew > 0)
+        {
+          WriteResults (out, aggregator, z);
+          std::cerr << done.size () << " runs, " << nRecords << " records, "
+                    << aggregator.GetNPorts () << " ports" << std::endl;
+        }
+
+      if (follow <= 0 || (until > 0 && done.size () >= until))
+        {
+          break;
+        }
+      sleep (follow);
+    }
+  return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Natasa Maksic, maksicn@etf.rs
+ */
+
+//
+// Paired comparison of two EEE configurations.  The runs of the two
+// configurations are paired by seed, data<seed>.bin of folder A with
+// data<seed>.bin of folder B, and for every port the differences B - A of
+// the simulated E[Toff] and energy ratio phi are folded into running
+// accumulators.  When both configurations were run with the same seeds, the
+// random streams of the example do not depend on the EEE parameters, so the
+// two runs of a pair see the same traffic, and the confidence interval of the
+// paired difference is much narrower than the one of the difference of two
+// independent means.  For every port the result file has one line:
+//
+//   node port pairs eToffA eToffB eToffDiff pairedMargin unpairedMargin
+//   reduction phiA phiB phiDiff pairedMargin unpairedMargin reduction
+//
+// where reduction is the ratio of the variances of the unpaired and the
+// paired difference, the factor by which pairing reduces the number of
+// runs needed for the same margin.
+//
+// Build, without ns-3:
+//
+//   g++ -O2 -I../point-to-point-coalescing/model -o eee-compare eee-compare.cc ../point-to-point-coalescing/model/eee-analytical-model.cc ../point-to-point-coalescing/model/coalescing-measurement-aggregator.cc
+//
+// Usage:
+//
+//   ./eee-compare [--z Z] [--out FILE] simulations/HASH_A simulations/HASH_B
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <dirent.h>
+
+#include "coalescing-measurement-format.h"
+#include "coalescing-measurement-aggregator.h"
+#include "eee-analytical-model.h"
+
+using namespace ns3;
+
+namespace {
+
+typedef CoalescingMeasurementAggregator::Port Port;
+
+// simulated E[Toff] and phi of one port in one run
+struct Sample
+{
+  double eToff;
+  double phi;
+};
+
+// accumulators of one quantity of one port
+struct Pair
+{
+  CoalescingWelford a;
+  CoalescingWelford b;
+  CoalescingWelford diff;
+};
+
+void
+Usage (const char *name)
+{
+  std::cerr << "usage: " << name << " [--z Z] [--out FILE] FOLDER_A FOLDER_B" << std::endl;
+  std::exit (2);
+}
+
+// names of the measurement files of the folder
+std::set<std::string>
+Scan (const std::string &folder)
+{
+  std::set<std::string> files;
+  DIR *dir = opendir (folder.c_str ());
+  if (dir == 0)
+    {
+      return files;
+    }
+  for (struct dirent *e = readdir (dir); e != 0; e = readdir (dir))
+    {
+      std::string name = e->d_name;
+      if (name.compare (0, 4, "data") == 0 && name.size () > 8
+          && name.compare (name.size () - 4, 4, ".bin") == 0)
+        {
+          files.insert (name);
+        }
+    }
+  closedir (dir);
+  return files;
+}
+
+bool
+Read (const std::string &file, const EeeAnalyticalModel &model, std::map<Port, Sample> &samples)
+{
+  std::ifstream is (file.c_str (), std::ios::binary);
+  CoalescingMeasurementFormat::Layout layout;
+  if (!CoalescingMeasurementFormat::ReadHeader (is, layout))
+    {
+      std::cerr << file << ": not a measurement file" << std::endl;
+      return false;
+    }
+  CoalescingMeasurementRecord r;
+  while (CoalescingMeasurementFormat::ReadRecord (is, layout, r))
+    {
+      if (r.packetCount == 0 || r.lpIntervals == 0)
+        {
+          continue;
+        }
+      // integer mean packet size, as in calculate.py
+      double ex = static_cast<double> (r.packetBytes / r.packetCount);
+      double rho = (1 / r.meanInterarrival) / (r.dataRate / 8.0 / ex);
+      Sample s;
+      s.eToff = 1e-9 * r.lpTimeNs / r.lpIntervals;
+      s.phi = model.GetPhi (s.eToff, rho);
+      samples[Port (r.nodeId, r.ifIndex)] = s;
+    }
+  return true;
+}
+
+void
+WritePair (std::ostream &os, const Pair &p, double z)
+{
+  double paired = p.diff.GetMargin (z);
+  // margin of the difference of two independent means, with the same
+  // number of runs
+  double unpaired = z * std::sqrt ((p.a.GetVariance () + p.b.GetVariance ()) / p.diff.GetCount ());
+  double reduction = p.diff.GetVariance () > 0
+    ? (p.a.GetVariance () + p.b.GetVariance ()) / p.diff.GetVariance ()
+    : std::numeric_limits<double>::infinity ();
+  os << " " << p.a.GetMean () << " " << p.b.GetMean () << " " << p.diff.GetMean ()
+     << " " << paired << " " << unpaired << " " << reduction;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  double z = 2.33; // 98%
+  std::string out = "compare.txt";
+  std::vector<std::string> folders;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      if (std::strcmp (argv[i], "--z") == 0 && i + 1 < argc)
+        {
+          z = std::atof (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--out") == 0 && i + 1 < argc)
+        {
+          out = argv[++i];
+        }
+      else if (argv[i][0] == '-')
+        {
+          Usage (argv[0]);
+        }
+      else
+        {
+          folders.push_back (argv[i]);
+        }
+    }
+  if (folders.size () != 2)
+    {
+      Usage (argv[0]);
+    }
+
+  EeeAnalyticalModel model;
+  std::set<std::string> filesA = Scan (folders[0]);
+  std::set<std::string> filesB = Scan (folders[1]);
+  std::map<Port, std::vector<Pair> > ports;
+  uint32_t nPairs = 0;
+
+  for (std::set<std::string>::const_iterator f = filesA.begin (); f != filesA.end (); ++f)
+    {
+      if (filesB.find (*f) == filesB.end ())
+        {
+          continue;
+        }
+      std::map<Port, Sample> a;
+      std::map<Port, Sample> b;
+      if (!Read (folders[0] + "/" + *f, model, a) || !Read (folders[1] + "/" + *f, model, b))
+        {
+          return 1;
+        }
+      // only ports measured in both runs of the pair
+      for (std::map<Port, Sample>::const_iterator i = a.begin (); i != a.end (); ++i)
+        {
+          std::map<Port, Sample>::const_iterator j = b.find (i->first);
+          if (j == b.end ())
+            {
+              continue;
+            }
+          std::vector<Pair> &p = ports[i->first];
+          p.resize (2);
+          p[0].a.Add (i->second.eToff);
+          p[0].b.Add (j->second.eToff);
+          p[0].diff.Add (j->second.eToff - i->second.eToff);
+          p[1].a.Add (i->second.phi);
+          p[1].b.Add (j->second.phi);
+          p[1].diff.Add (j->second.phi - i->second.phi);
+        }
+      nPairs++;
+    }
+
+  std::ofstream os (out.c_str ());
+  os << "# node port pairs eToffA eToffB eToffDiff pairedMargin unpairedMargin reduction"
+     << " phiA phiB phiDiff pairedMargin unpairedMargin reduction" << std::endl;
+  for (std::map<Port, std::vector<Pair> >::const_iterator i = ports.begin (); i != ports.end (); ++i)
+    {
+      os << i->first.first << " " << i->first.second << " " << i->second[0].diff.GetCount ();
+      WritePair (os, i->second[0], z);
+      WritePair (os, i->second[1], z);
+      os << std::endl;
+    }
+
+  std::cerr << nPairs << " pairs of runs, " << ports.size () << " ports" << std::endl;
+  return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Natasa Maksic, maksicn@etf.rs
+ */
+
+//
+// Compares the measurements of the simulations with the analytical model,
+// as calculate.py does.  For every port it writes a line to the result
+// file with the number of runs and the mean and the 98% margin of error of
+// the simulated and the theoretical E[Toff] and energy ratio phi:
+//
+//   node port runs simEToff margin thEToff margin simPhi margin thPhi margin
+//
+// Build, without ns-3:
+//
+//   g++ -O2 -I../point-to-point-coalescing/model -o eee-validate eee-validate.cc ../point-to-point-coalescing/model/eee-analytical-model.cc ../point-to-point-coalescing/model/coalescing-measurement-aggregator.cc
+//
+// Usage:
+//
+//   ./eee-validate [--timeout S] [--limit RATE:BYTES]... [--out FILE] simulations/HASH/data*.bin
+//
+// The byte limit of a port is looked up by its data rate.  The defaults
+// are those of the example: 24000 bytes at 10 Gbps, 15000 bytes at 5 Gbps
+// and a timeout of 0.0008 s.
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "coalescing-measurement-format.h"
+#include "coalescing-measurement-aggregator.h"
+#include "eee-analytical-model.h"
+
+using namespace ns3;
+
+namespace {
+
+void
+Usage (const char *name)
+{
+  std::cerr << "usage: " << name << " [--timeout S] [--limit RATE:BYTES]... [--out FILE] FILE..." << std::endl;
+  std::exit (2);
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  double timeout = 0.0008;
+  std::map<uint64_t, double> limits;
+  std::string out = "results.txt";
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      if (std::strcmp (argv[i], "--timeout") == 0 && i + 1 < argc)
+        {
+          timeout = std::atof (argv[++i]);
+        }
+      else if (std::strcmp (argv[i], "--limit") == 0 && i + 1 < argc)
+        {
+          std::string s = argv[++i];
+          std::string::size_type colon = s.find (':');
+          if (colon == std::string::npos)
+            {
+              Usage (argv[0]);
+            }
+          limits[std::strtoull (s.substr (0, colon).c_str (), 0, 10)] = std::atof (s.substr (colon + 1).c_str ());
+        }
+      else if (std::strcmp (argv[i], "--out") == 0 && i + 1 < argc)
+        {
+          out = argv[++i];
+        }
+      else if (argv[i][0] == '-')
+        {
+          Usage (argv[0]);
+        }
+      else
+        {
+          files.push_back (argv[i]);
+        }
+    }
+  if (files.empty ())
+    {
+      Usage (argv[0]);
+    }
+  if (limits.empty ())
+    {
+      limits[10000000000ULL] = 24000;
+      limits[5000000000ULL] = 15000;
+    }
+
+  EeeAnalyticalModel model;
+  const EeeAnalyticalModel::Parameters p = EeeAnalyticalModel::GetDefaultParameters ();
+
+  std::vector<std::string> names;
+  names.push_back ("simEToff");
+  names.push_back ("thEToff");
+  names.push_back ("simPhi");
+  names.push_back ("thPhi");
+  CoalescingMeasurementAggregator results (names);
+  uint64_t nMeasurements = 0;
+
+  //
+  // The operating points of all ports of a run are evaluated in one batch
+  // and then folded into the per-port statistics.
+  //
+  for (std::size_t f = 0; f < files.size (); ++f)
+    {
+      std::vector<CoalescingMeasurementAggregator::Port> ports;
+      std::vector<double> simEToff;
+      std::vector<EeeAnalyticalModel::Input> inputs;
+      std::ifstream is (files[f].c_str (), std::ios::binary);
+      CoalescingMeasurementFormat::Layout layout;
+      if (!CoalescingMeasurementFormat::ReadHeader (is, layout))
+        {
+          std::cerr << files[f] << ": not a measurement file" << std::endl;
+          return 1;
+        }
+      CoalescingMeasurementRecord r;
+      while (CoalescingMeasurementFormat::ReadRecord (is, layout, r))
+        {
+          std::map<uint64_t, double>::const_iterator limit = limits.find (r.dataRate);
+          if (r.packetCount == 0 || r.lpIntervals == 0 || limit == limits.end ())
+            {
+              continue;
+            }
+          EeeAnalyticalModel::Input in;
+          in.lambda = 1 / r.meanInterarrival;
+          // integer mean packet size, as in calculate.py
+          in.ex = static_cast<double> (r.packetBytes / r.packetCount);
+          in.c = limit->second;
+          in.to = timeout;
+          in.rho = in.lambda / (r.dataRate / 8.0 / in.ex);
+          inputs.push_back (in);
+          ports.push_back (std::make_pair (r.nodeId, r.ifIndex));
+          simEToff.push_back (1e-9 * r.lpTimeNs / r.lpIntervals);
+        }
+
+      std::vector<EeeAnalyticalModel::Output> outputs;
+      model.Evaluate (inputs, outputs);
+
+      std::vector<double> values (4);
+      for (std::size_t i = 0; i < inputs.size (); ++i)
+        {
+          values[0] = simEToff[i];
+          values[1] = outputs[i].eToff;
+          values[2] = model.GetPhi (simEToff[i], inputs[i].rho);
+          values[3] = outputs[i].phi;
+          results.Add (ports[i], values);
+          std::cout << ports[i].first << " " << ports[i].second << " " << values[0] << " "
+                    << values[1] << " " << values[2] << " " << values[3] << std::endl;
+        }
+      nMeasurements += inputs.size ();
+    }
+
+  std::ofstream os (out.c_str ());
+  results.Write (os, 2.33); // 98%
+
+  std::cerr << nMeasurements << " measurements of " << results.GetNPorts () << " ports, "
+            << nMeasurements - model.GetNHits () << " model evaluations, Ts " << p.ts
+            << " s, Tw " << p.tw << " s" << std::endl;
+  return 0;
+}
@@ -1,9 +1,3 @@
-rm -rf simulations
-mkdir simulations
-for i in {1..100}
-do
-  rm data.txt
-  ./waf --command-template="%s --RngRun=$i" --run "scratch/leafspineppbp"
-  cp data.txt simulations/data$i.txt
-done
-
+# 100 runs of the example with its default parameters, see sweep.py for
+# parameter sweeps.  Results are stored in simulations/<hash>.
+python3 sweep.py --out simulations --runs 1-100 "$@"
@@ -0,0 +1,166 @@
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Natasa Maksic, maksicn@etf.rs
+#
+
+# Runs the example for every combination of parameters and seeds on all
+# cores.  The measurements of each configuration are stored in their own
+# folder, named by a hash of the configuration:
+#
+#   <out>/<hash>/config.json    parameters of the configuration
+#   <out>/<hash>/data<seed>.bin measurements of one run
+#   <out>/<hash>/data<seed>.log output of one run
+#
+# A run whose measurement file exists is not repeated, so an interrupted
+# sweep continues where it stopped.  Measurement files are written under a
+# temporary name and renamed when the run succeeds.
+#
+# Example, to be executed in the ns3 folder:
+#
+#   python3 sweep.py --byte-limit 12000,24000 --timeout 400,800 --runs 1-100
+
+import argparse
+import hashlib
+import itertools
+import json
+import multiprocessing
+import os
+import subprocess
+import sys
+import time
+
+# Options of the grid and the command line arguments of the example they set
+GRID_OPTIONS = [
+    ('byte_limit', 'byteLimit', 'EEE byte limit of the links between switches'),
+    ('server_byte_limit', 'serverByteLimit', 'EEE byte limit of the links to the servers'),
+    ('timeout', 'timeout', 'EEE coalescing timeout in microseconds'),
+    ('rate', 'rate', 'data rate of the links between switches'),
+    ('server_rate', 'serverRate', 'data rate of the links to the servers'),
+]
+
+def parse_runs(text):
+    runs = []
+    for part in text.split(','):
+        if '-' in part:
+            first, last = part.split('-')
+            runs.extend(range(int(first), int(last) + 1))
+        else:
+            runs.append(int(part))
+    return runs
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Run a parameter sweep of the coalescing example.')
+    parser.add_argument('--program', default='scratch/leafspineppbp',
+                        help='program run by waf (default: %(default)s)')
+    parser.add_argument('--waf', default='./waf', help='waf script (default: %(default)s)')
+    parser.add_argument('--out', default='simulations', help='output folder (default: %(default)s)')
+    parser.add_argument('--runs', default='1-100', help='seeds as list and ranges, e.g. 1-50,60 (default: %(default)s)')
+    parser.add_argument('--jobs', type=int, default=multiprocessing.cpu_count(),
+                        help='number of parallel runs (default: number of cores)')
+    parser.add_argument('--force', action='store_true', help='repeat runs which are already done')
+    parser.add_argument('--no-build', action='store_true', help='do not build before the sweep')
+    for name, arg, text in GRID_OPTIONS:
+        parser.add_argument('--' + name.replace('_', '-'), help='comma separated values of the ' + text)
+    parser.add_argument('--param', action='append', default=[], metavar='NAME=V1,V2',
+                        help='any other argument of the program, e.g. '
+                             'ns3::PointToPointCoalescingNetDeviceBase::CoalescingPolicy=ByteLimit,Hybrid')
+    return parser.parse_args()
+
+def build_grid(args):
+    axes = []
+    for name, arg, text in GRID_OPTIONS:
+        values = getattr(args, name)
+        if values is not None:
+            axes.append((arg, values.split(',')))
+    for p in args.param:
+        name, values = p.split('=', 1)
+        axes.append((name, values.split(',')))
+    names = [a[0] for a in axes]
+    configs = []
+    for values in itertools.product(*[a[1] for a in axes]):
+        configs.append(dict(zip(names, values)))
+    return configs
+
+def config_hash(program, config):
+    text = json.dumps({'program': program, 'config': config}, sort_keys=True)
+    return hashlib.sha1(text.encode('utf-8')).hexdigest()[:12]
+
+def run_job(job):
+    waf, program, folder, config, seed = job
+    output = os.path.abspath(os.path.join(folder, 'data%d.bin' % seed))
+    partial = output + '.part'
+    log = os.path.join(folder, 'data%d.log' % seed)
+    template = '%s --RngRun=' + str(seed) + ' --output=' + partial
+    for name in sorted(config):
+        template += ' --' + name + '=' + config[name]
+    start = time.time()
+    with open(log, 'w') as f:
+        rc = subprocess.call([waf, '--run-no-build', program, '--command-template=' + template],
+                             stdout=f, stderr=subprocess.STDOUT)
+    if rc == 0 and os.path.exists(partial):
+        os.rename(partial, output)
+    elif os.path.exists(partial):
+        os.remove(partial)
+    return (folder, seed, rc, time.time() - start)
+
+def main():
+    args = parse_args()
+    runs = parse_runs(args.runs)
+    configs = build_grid(args)
+
+    if not args.no_build:
+        if subprocess.call([args.waf, 'build']) != 0:
+            sys.exit('build failed')
+
+    jobs = []
+    skipped = 0
+    for config in configs:
+        folder = os.path.join(args.out, config_hash(args.program, config))
+        if not os.path.isdir(folder):
+            os.makedirs(folder)
+        with open(os.path.join(folder, 'config.json'), 'w') as f:
+            json.dump({'program': args.program, 'config': config}, f, indent=2, sort_keys=True)
+        print('%s %s' % (folder, json.dumps(config, sort_keys=True)))
+        for seed in runs:
+            if not args.force and os.path.exists(os.path.join(folder, 'data%d.bin' % seed)):
+                skipped += 1
+                continue
+            jobs.append((args.waf, args.program, folder, config, seed))
+
+    print('%d runs, %d already done' % (len(jobs), skipped))
+
+    # Runs take very different times, so idle workers take the next run one
+    # at a time instead of getting a fixed share up front.
+    failed = 0
+    pool = multiprocessing.Pool(args.jobs)
+    try:
+        for done, (folder, seed, rc, duration) in enumerate(pool.imap_unordered(run_job, jobs, 1), 1):
+            status = 'ok' if rc == 0 else 'FAILED (%d)' % rc
+            if rc != 0:
+                failed += 1
+            print('[%d/%d] %s seed %d %s in %.1fs' % (done, len(jobs), folder, seed, status, duration))
+            sys.stdout.flush()
+        pool.close()
+    except KeyboardInterrupt:
+        pool.terminate()
+        raise
+    finally:
+        pool.join()
+
+    if failed:
+        sys.exit('%d runs failed, see the logs' % failed)
+
+if __name__ == '__main__':
+    main()